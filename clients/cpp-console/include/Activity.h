@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <string>
+#include "ActivityArena.h"
+
+/// <summary>
+/// A Bot Framework activity as received from the dialog service. The top-level fields the client routes
+/// on (type, id, text and inputHint) are pulled out by a single forward scan that skips every other value
+/// without decoding it, so a large adaptive-card attachment costs one memchr pass instead of a DOM with an
+/// allocation per node. The full document is only parsed the first time Json() is called.
+/// </summary>
+/// <example>
+/// <code>
+/// Activity activity(event.GetActivity());
+/// if (activity.InputHint() == "expectingInput") { ... }
+/// auto&amp; attachments = activity.Json()["attachments"];
+/// </code>
+/// </example>
+/// <remarks>
+/// Only string values of top-level keys are extracted; the same keys inside nested objects, such as
+/// "from.id", are ignored. The scan checks the structure of the top-level object but not the contents of
+/// skipped values; Json() throws nlohmann::json::parse_error for a malformed activity, while the field
+/// accessors return empty strings when the top level is malformed.
+/// When an arena is given, the DOM is allocated from it and must not be used after the Activity is gone;
+/// the owner resets the arena once the activity has been handled.
+/// </remarks>
+class Activity
+{
+public:
+    explicit Activity(std::string raw, ActivityArena* arena = nullptr);
+    ~Activity();
+
+    Activity(const Activity&) = delete;
+    Activity& operator=(const Activity&) = delete;
+
+    const std::string& Type() const { return m_type; }
+    const std::string& Id() const { return m_id; }
+    const std::string& Text() const { return m_text; }
+    const std::string& InputHint() const { return m_inputHint; }
+    bool HasText() const { return m_hasText; }
+
+    // The activity exactly as received.
+    const std::string& Raw() const { return m_raw; }
+
+    // Parses the full activity on first use.
+    const ActivityJson& Json();
+    bool IsParsed() const { return m_parsed; }
+
+private:
+    class FieldExtractor;
+
+    std::string m_raw;
+    std::string m_type;
+    std::string m_id;
+    std::string m_text;
+    std::string m_inputHint;
+    bool m_hasText = false;
+    bool m_parsed = false;
+    ActivityArena* m_arena;
+    ActivityJson m_json;
+};
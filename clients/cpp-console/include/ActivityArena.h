@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+/// <summary>
+/// A monotonic arena for the short-lived allocations made while handling one activity. Allocation is a
+/// pointer bump, freeing is a no-op and Reset() releases everything at once, so a parsed activity costs
+/// a handful of block allocations instead of one heap allocation per node and string.
+/// </summary>
+/// <example>
+/// <code>
+/// ActivityArena arena;
+/// {
+///     ActivityArena::Scope scope(arena);
+///     ActivityJson json = ActivityJson::parse(raw);
+///     ...
+/// }
+/// arena.Reset();
+/// </code>
+/// </example>
+/// <remarks>
+/// ArenaAllocator is stateless, as nlohmann::basic_json requires, and allocates from the arena made
+/// current on the calling thread by a Scope. Values allocated from an arena must be destroyed while that
+/// arena is current and before it is reset. Outside of any scope the allocator falls back to the heap.
+/// After a Reset that followed an overflow, the arena keeps one block large enough for everything the
+/// last activity used, so steady state is a single block that is never freed.
+/// </remarks>
+class ActivityArena
+{
+public:
+    static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+    explicit ActivityArena(size_t blockSize = DefaultBlockSize);
+    ~ActivityArena();
+
+    ActivityArena(const ActivityArena&) = delete;
+    ActivityArena& operator=(const ActivityArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment);
+    bool Owns(const void* pointer) const;
+
+    // Releases every allocation made since the last reset.
+    void Reset();
+
+    // Allocations served since the last reset, and the bytes they used.
+    uint64_t Allocations() const { return m_allocations; }
+    size_t BytesUsed() const { return m_bytesUsed; }
+
+    // Heap blocks the arena has allocated over its lifetime.
+    uint64_t BlockAllocations() const { return m_blockAllocations; }
+
+    // The arena allocations on this thread go to, or nullptr.
+    static ActivityArena* Current();
+
+    // Makes an arena current on this thread for the lifetime of the scope.
+    class Scope
+    {
+    public:
+        explicit Scope(ActivityArena& arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ActivityArena* m_previous;
+    };
+
+private:
+    struct Block
+    {
+        unsigned char* data;
+        size_t size;
+    };
+
+    void AddBlock(size_t minimumSize);
+
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    size_t m_offset = 0;
+    size_t m_bytesUsed = 0;
+    uint64_t m_allocations = 0;
+    uint64_t m_blockAllocations = 0;
+};
+
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        ActivityArena* arena = ActivityArena::Current();
+        if (arena != nullptr)
+        {
+            return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        ActivityArena* arena = ActivityArena::Current();
+        if (arena == nullptr || !arena->Owns(pointer))
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    bool operator==(const ArenaAllocator&) const { return true; }
+    bool operator!=(const ArenaAllocator&) const { return false; }
+};
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
+
+// nlohmann::json with every node, container and string allocated from the current ActivityArena.
+typedef nlohmann::basic_json<std::map, std::vector, ArenaString, bool, std::int64_t, std::uint64_t, double, ArenaAllocator> ActivityJson;
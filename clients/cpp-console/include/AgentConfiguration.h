@@ -34,7 +34,8 @@ enum class AgentConfigurationLoadResult
     BadSpeechKey,
     MissingRegion,
     RegionWithCustom,
-    UnknownFailure
+    UnknownFailure,
+    LocalDialogScriptNotFound
 };
 
 class AgentConfiguration
@@ -53,7 +54,25 @@ public:
     std::string _barge_in_supported;
     std::string _customMicConfigPath;
     std::string _linuxCaptureDeviceName;
+    std::string _ttsRecordingDirectory;
+    std::string _turnTimelineFile;
+    // When set, a LocalDialogService playing this script stands in for the dialog service.
+    std::string _localDialogScript;
+    // When set, the state is published in a shared memory status board of this name for other processes.
+    std::string _statusBoardName;
+    // Threshold for leveled logging: trace, debug, info, warning or error. Info when empty.
+    std::string _logLevel;
+    // When set, tracing is on and traces are written here as Chrome trace JSON.
+    std::string _traceFile;
     unsigned int _volume = 0;
+    unsigned int _multiturnLeadTimeMs = 1000;
+    unsigned int _keepAliveIntervalSeconds = 240;
+    // Status changes this close to the last one shown are held back and only the latest is shown.
+    unsigned int _statusCoalesceMs = 100;
+    // A turn slower than this from its start to the answer being heard writes a trace of it, 0 to never.
+    unsigned int _traceTurnThresholdMs = 0;
+    // How fast file input is pushed relative to real-time, 0 for as fast as possible.
+    double _fileInputSpeed = 0;
 
     AgentConfiguration();
     static std::shared_ptr<AgentConfiguration> LoadFromFile(const std::string& path);
@@ -0,0 +1,147 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A log line being built on the calling thread. Each thread reuses one, so formatting a line allocates nothing
+/// once the buffer has grown to the longest line the thread writes.
+/// </summary>
+class LogLine
+{
+public:
+    LogLine() { m_buffer.reserve(256); }
+
+    void Clear() { m_buffer.clear(); }
+    const char* Data() const { return m_buffer.data(); }
+    size_t Size() const { return m_buffer.size(); }
+
+    void Append(const char* value) { m_buffer.append(value != nullptr ? value : "(null)"); }
+    void Append(char* value) { Append(const_cast<const char*>(value)); }
+    void Append(const std::string& value) { m_buffer.append(value); }
+    void Append(char value) { m_buffer.push_back(value); }
+    void Append(int value) { AppendSigned(value); }
+    void Append(long value) { AppendSigned(value); }
+    void Append(long long value) { AppendSigned(value); }
+    void Append(unsigned int value) { AppendUnsigned(value); }
+    void Append(unsigned long value) { AppendUnsigned(value); }
+    void Append(unsigned long long value) { AppendUnsigned(value); }
+
+    // Anything else that can be written to an ostream, formatted the way cout would.
+    template <typename T>
+    void Append(const T& value)
+    {
+        static thread_local std::ostringstream stream;
+        stream.str(std::string());
+        stream << value;
+        m_buffer.append(stream.str());
+    }
+
+    // HH:MM:SS.mmm in local time. localtime only runs when the second changes.
+    void AppendTimestamp();
+
+private:
+    void AppendSigned(long long value);
+    void AppendUnsigned(unsigned long long value);
+
+    std::string m_buffer;
+};
+
+/// <summary>
+/// Writes log lines to stdout from a background thread, so that logging from SDK callbacks and the dispatch
+/// thread never waits on a slow terminal or journald pipe. log and log_t in log.h go through it.
+/// </summary>
+/// <example>
+/// <code>
+/// LogLine&amp; line = AsyncLogger::ThreadLine();
+/// line.Clear();
+/// line.Append("hello ");
+/// line.Append(42);
+/// AsyncLogger::Instance().Write(line.Data(), line.Size());
+/// </code>
+/// </example>
+/// <remarks>
+/// Write copies the line into a slot of a bounded lock-free ring (Dmitry Vyukov's bounded queue) and returns; it
+/// only takes a lock, to wake the writer, when the writer is asleep with nothing to do. Lines longer than a
+/// slot are copied to the heap. The writer drains whatever has arrived into one buffer and writes it with a single
+/// fwrite and fflush. When the ring is full the line is dropped and counted, and the writer reports the count in
+/// the log. Pending lines are written at exit. Output from code that writes to cout or printf directly is not
+/// ordered against lines still in the ring.
+/// </remarks>
+class AsyncLogger
+{
+public:
+    static constexpr size_t DefaultSlotCount = 1024;
+    static constexpr size_t InlineBytes = 232;
+
+    // slotCount must be a power of two.
+    AsyncLogger(FILE* output, size_t slotCount = DefaultSlotCount);
+    // Writes everything still queued.
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // The process wide logger on stdout. It is never destroyed; it stops and writes out what is queued at exit.
+    static AsyncLogger& Instance();
+    static LogLine& ThreadLine();
+
+    // Queues a line; a newline is added. Any thread, never blocks.
+    void Write(const char* data, size_t size);
+
+    // Blocks until every line written before the call is out.
+    void Flush();
+
+    // Writes out what is queued and stops the writer; later lines are written synchronously.
+    void Stop();
+
+    uint64_t LinesWritten() const { return m_written.load(); }
+    uint64_t LinesDropped() const { return m_dropped.load(); }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        uint32_t size;
+        char* heapData;
+        char inlineData[InlineBytes];
+    };
+
+    bool TryRead(std::string& batch);
+    void WriterThreadMain();
+    void WriteOut(const std::string& batch, uint64_t lines);
+
+    FILE* m_output;
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+    std::atomic<size_t> m_enqueuePosition{ 0 };
+    size_t m_dequeuePosition = 0;
+    // The position of the last line written out, for Flush.
+    size_t m_writtenPosition = 0;
+
+    std::atomic<uint64_t> m_written{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+    uint64_t m_droppedReported = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    std::atomic<bool> m_writerAsleep{ false };
+    std::atomic<bool> m_stopping{ false };
+    std::atomic<bool> m_flushRequested{ false };
+    bool m_stopped = false;
+    // Serializes writes made after Stop.
+    std::mutex m_syncMutex;
+    std::thread m_writerThread;
+};
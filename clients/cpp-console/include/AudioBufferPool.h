@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace AudioPlayer
+{
+    class AudioBufferPool;
+
+    /// <summary>
+    /// A move-only handle to an audio block. The block goes back to the pool it came from
+    /// when the handle is destroyed or reset. Blocks that could not be served from a pool
+    /// are owned by the handle and freed on the heap instead.
+    /// </summary>
+    /// <remarks>
+    /// </remarks>
+    class PooledBuffer
+    {
+    public:
+        PooledBuffer() = default;
+        PooledBuffer(PooledBuffer&& other) noexcept;
+        PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+        PooledBuffer(const PooledBuffer&) = delete;
+        PooledBuffer& operator=(const PooledBuffer&) = delete;
+        ~PooledBuffer();
+
+        unsigned char* Data() const { return m_data; }
+
+        // The number of bytes the block can hold.
+        size_t Capacity() const { return m_capacity; }
+
+        // The number of valid bytes the owner has written into the block.
+        size_t Size() const { return m_size; }
+        void SetSize(size_t size) { m_size = size < m_capacity ? size : m_capacity; }
+
+        // True when the block was taken from a pool rather than the heap.
+        bool IsPooled() const { return m_pool != nullptr; }
+
+        explicit operator bool() const { return m_data != nullptr; }
+
+        // Returns the block to its owner and leaves the handle empty.
+        void Reset();
+
+    private:
+        friend class AudioBufferPool;
+        PooledBuffer(AudioBufferPool* pool, unsigned char* data, size_t capacity);
+
+        AudioBufferPool* m_pool = nullptr;
+        unsigned char* m_data = nullptr;
+        size_t m_capacity = 0;
+        size_t m_size = 0;
+    };
+
+    /// <summary>
+    /// A fixed-size slab allocator for audio blocks. All blocks are carved out of a single
+    /// allocation made at construction so that acquiring and releasing blocks on the audio
+    /// path never touches the heap.
+    /// </summary>
+    /// <example>
+    /// <code>
+    /// PooledBuffer buffer = AudioBufferPool::AcquireAudioBuffer(1024);
+    /// size_t bytesRead = stream->Read(buffer.Data(), buffer.Capacity());
+    /// buffer.SetSize(bytesRead);
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// When a pool runs dry, or a request is larger than its block size, the block is
+    /// allocated on the heap and counted in FallbackAllocations() so that undersized pools
+    /// show up in diagnostics instead of failing playback.
+    /// </remarks>
+    class AudioBufferPool
+    {
+    public:
+        // Large enough for one ALSA/WASAPI period of 16 bit audio.
+        static constexpr size_t PeriodBlockSize = 4096;
+        static constexpr size_t PeriodBlockCount = 32;
+
+        // Large enough for a queued byte array chunk or a full WASAPI render buffer at 16khz.
+        static constexpr size_t ChunkBlockSize = 32768;
+        static constexpr size_t ChunkBlockCount = 16;
+
+        AudioBufferPool(size_t blockSize, size_t blockCount);
+        ~AudioBufferPool();
+
+        AudioBufferPool(const AudioBufferPool&) = delete;
+        AudioBufferPool& operator=(const AudioBufferPool&) = delete;
+
+        // Takes a block from the pool, falling back to the heap if none are free.
+        PooledBuffer Acquire();
+
+        size_t BlockSize() const { return m_blockSize; }
+        size_t BlockCount() const { return m_blockCount; }
+        size_t Available();
+        uint64_t FallbackAllocations() const { return m_fallbackAllocations.load(); }
+
+        // Process wide pools shared by the audio players and the dialog layer. They live until the process exits.
+        static AudioBufferPool& PeriodPool();
+        static AudioBufferPool& ChunkPool();
+
+        // Returns a block of at least size bytes from the smallest shared pool that fits.
+        static PooledBuffer AcquireAudioBuffer(size_t size);
+
+    private:
+        friend class PooledBuffer;
+        void Release(unsigned char* data);
+        static PooledBuffer AllocateFromHeap(size_t size);
+
+        size_t m_blockSize;
+        size_t m_blockCount;
+        unsigned char* m_slab;
+        std::vector<unsigned char*> m_freeBlocks;
+        std::mutex m_mutex;
+        std::atomic<uint64_t> m_fallbackAllocations{ 0 };
+    };
+}
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "WavHeader.h"
+
+/// <summary>
+/// Converts interleaved PCM or float audio into the 16 bit mono format the speech service expects.
+/// Audio goes through three stages: channels are down-mixed to mono, the sample rate is converted
+/// with a low-pass filtered linear resampler, and the result is quantized to 16 bit.
+/// </summary>
+/// <example>
+/// <code>
+/// AudioConverter converter(info.format);
+/// std::vector<int16_t> output;
+/// converter.Convert(buffer.data(), bytesRead, output);
+/// pushStream->Write((uint8_t*)output.data(), (uint32_t)(output.size() * sizeof(int16_t)));
+/// </code>
+/// </example>
+/// <remarks>
+/// Convert can be called with blocks of any size. Partial frames are carried over to the next call.
+/// </remarks>
+class AudioConverter
+{
+public:
+    AudioConverter(const WavFile::WavFormat& inputFormat, uint32_t outputSamplesPerSecond = 16000);
+
+    // True if the input format can be decoded: 8/16/24/32 bit PCM or 32 bit float, any number of channels.
+    static bool IsSupported(const WavFile::WavFormat& inputFormat);
+
+    // True unless the input is already 16 bit mono PCM at the output rate.
+    static bool NeedsConversion(const WavFile::WavFormat& inputFormat, uint32_t outputSamplesPerSecond = 16000);
+
+    // Converts a block of input bytes and appends the converted samples to output.
+    // Returns the number of samples appended.
+    size_t Convert(const unsigned char* input, size_t inputSize, std::vector<int16_t>& output);
+
+    // The duration of the input consumed so far, used to report throughput relative to real time.
+    double InputSeconds() const;
+
+private:
+    float DecodeSample(const unsigned char* sample) const;
+    float Filter(float sample);
+    void Resample(float sample, std::vector<int16_t>& output);
+
+    WavFile::WavFormat m_inputFormat;
+    uint32_t m_outputSamplesPerSecond;
+    uint32_t m_bytesPerSample;
+
+    // bytes of a frame split across two Convert calls
+    std::vector<unsigned char> m_partialFrame;
+
+    // anti-aliasing filter, only used when the input rate is higher than the output rate
+    std::vector<float> m_filterTaps;
+    std::vector<float> m_filterHistory;
+    size_t m_filterPosition = 0;
+
+    // linear resampler state
+    double m_step;
+    double m_position = 0.0;
+    float m_previousSample = 0.0f;
+    bool m_havePreviousSample = false;
+
+    uint64_t m_framesConsumed = 0;
+};
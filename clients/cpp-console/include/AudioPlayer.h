@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <chrono>
+#include <functional>
 #include "speechapi_cxx.h"
 #include "AudioPlayerState.h"
 #include "AudioPlayerStream.h"
@@ -131,6 +133,50 @@ public:
     /// </remarks>
     virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream) = 0;
 
+    /// <summary>
+    /// Called once for a stream played with Play(pStream, leadTime, onEnding). canceled is false when the
+    /// audio still to be heard has dropped to the lead time, and true if playback was stopped before that.
+    /// </summary>
+    /// <remarks>
+    /// The callback runs on the player thread (or the thread calling Stop) so it should not block.
+    /// </remarks>
+    typedef std::function<void(bool canceled)> PlaybackEndingCallback;
+
+    /// <summary>
+    /// Called once when the first audio of a stream has been handed to the device, with the time its first
+    /// sample is expected to be heard, which is later than now if other audio is still queued ahead of it.
+    /// </summary>
+    /// <remarks>
+    /// The callback runs on the player thread so it should not block.
+    /// </remarks>
+    typedef std::function<void(std::chrono::steady_clock::time_point audibleAt)> PlaybackStartedCallback;
+
+    /// <summary>
+    /// Plays a stream like Play(pStream) and reports when its playback is about to end. The remaining
+    /// time includes the audio queued in the device, so the callback tracks what is actually audible.
+    /// </summary>
+    /// <param name="pStream">A shared pointer to the stream to play</param>
+    /// <param name="leadTime">How long before the end of the audible audio onEnding should be invoked</param>
+    /// <param name="onEnding">Invoked once, see PlaybackEndingCallback</param>
+    /// <param name="onStarted">Optional, invoked once, see PlaybackStartedCallback</param>
+    /// <returns>A return code with < 0 as an error and any other int as success</returns>
+    /// <example>
+    /// <code>
+    /// audioPlayer->Play(stream, std::chrono::milliseconds(500), [](bool canceled)
+    ///     {
+    ///         if (!canceled)
+    ///         {
+    ///             // start listening for the next turn
+    ///         }
+    ///     });
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// Streams shorter than the lead time invoke the callback as soon as they are fully buffered.
+    /// </remarks>
+    virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, PlaybackEndingCallback onEnding,
+        PlaybackStartedCallback onStarted = nullptr) = 0;
+
     /// <summary>
     /// This method is used to stop all playback. This will clear any queued audio meaning that any audio yet to play will be lost.
     /// </summary>
@@ -146,6 +192,37 @@ public:
     /// </remarks>
     virtual int Stop() = 0;
 
+    /// <summary>
+    /// Called once the audio device has been silenced after BargeIn, with the time it went silent and whether
+    /// anything was playing or queued in the device to be silenced.
+    /// </summary>
+    /// <remarks>
+    /// The callback runs on the player thread so it should not block.
+    /// </remarks>
+    typedef std::function<void(std::chrono::steady_clock::time_point silentAt, bool wasAudible)> BargeInCallback;
+
+    /// <summary>
+    /// Silences playback as fast as possible when the user talks over it. Queued audio is dropped straight
+    /// away and the player thread is told to abandon the current stream and flush the audio device before
+    /// writing anything else.
+    /// </summary>
+    /// <param name="onSilent">Optional, invoked once the device is silent, see BargeInCallback</param>
+    /// <returns>A return code with < 0 as an error and any other int as success</returns>
+    /// <example>
+    /// <code>
+    /// auto heard = std::chrono::steady_clock::now();
+    /// audioPlayer->BargeIn([heard](std::chrono::steady_clock::time_point silentAt, bool wasAudible)
+    ///     {
+    ///         // silentAt - heard is the keyword to silence latency
+    ///     });
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// BargeIn does not block and does not touch the device itself, so it can be called from SDK callbacks
+    /// while the player thread is writing. Audio played after the call is not affected.
+    /// </remarks>
+    virtual int BargeIn(BargeInCallback onSilent) = 0;
+
     /// <summary>
     /// This method is used to pause all playback. Any queued audio should remain queued and be played upon resume.
     /// </summary>
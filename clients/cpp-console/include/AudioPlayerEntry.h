@@ -1,6 +1,16 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "AudioBufferPool.h"
 #include "AudioPlayerStream.h"
 
 namespace AudioPlayer
@@ -16,10 +26,94 @@ namespace AudioPlayer
     public:
         AudioPlayerEntry(unsigned char* pData, size_t pSize);
         AudioPlayerEntry(std::shared_ptr<IAudioPlayerStream> pStream);
+        AudioPlayerEntry(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, std::function<void(bool)> onPlaybackEnding,
+            std::function<void(std::chrono::steady_clock::time_point)> onPlaybackStarted = nullptr);
+
+        // Entries own a pooled buffer, so they can be moved between queues but not copied.
+        AudioPlayerEntry(AudioPlayerEntry&&) = default;
+        AudioPlayerEntry& operator=(AudioPlayerEntry&&) = default;
+
+        // Releases the audio held by this entry so the queue node can be reused.
+        // A playback ending callback that has not run yet is invoked as canceled.
+        void Reset();
+
+        // True while the entry has a playback ending callback that has not run yet.
+        bool PlaybackEndingPending() const { return (bool)m_onPlaybackEnding; }
+
+        // Invokes the playback ending callback, if it has not run yet.
+        void NotifyPlaybackEnding(bool canceled);
+
+        bool PlaybackStartedPending() const { return (bool)m_onPlaybackStarted; }
+
+        // Invokes the playback started callback, if it has not run yet.
+        void NotifyPlaybackStarted(std::chrono::steady_clock::time_point audibleAt);
 
         PlayerEntryType m_entryType;
         std::shared_ptr<IAudioPlayerStream> m_audioPlayerStream;
         size_t m_size;
-        unsigned char* m_data;
+        PooledBuffer m_data;
+
+        // Set for streams played with a playback ending callback.
+        std::chrono::milliseconds m_leadTime{ 0 };
+        std::function<void(bool)> m_onPlaybackEnding;
+        std::function<void(std::chrono::steady_clock::time_point)> m_onPlaybackStarted;
+    };
+
+    /// <summary>
+    /// The queue of entries waiting to be played. List nodes are recycled rather than freed
+    /// so that queueing audio does not allocate once the player has warmed up.
+    /// </summary>
+    /// <remarks>
+    /// All methods are thread safe. BeginNext and EndCurrent are expected to be called from
+    /// the player thread only.
+    /// </remarks>
+    class AudioPlayerEntryQueue
+    {
+    public:
+        void Push(AudioPlayerEntry&& entry);
+
+        // Moves the oldest queued entry into the current slot, or returns nullptr if the queue is empty.
+        AudioPlayerEntry* BeginNext();
+
+        // Releases the audio of the current entry and keeps its node for reuse.
+        void EndCurrent();
+
+        // Drops every queued entry that has not started playing, discarding their streams.
+        void Clear();
+
+        bool Empty();
+
+    private:
+        std::mutex m_mutex;
+        std::list<AudioPlayerEntry> m_queue;
+        std::list<AudioPlayerEntry> m_current;
+        std::list<AudioPlayerEntry> m_free;
+    };
+
+    /// <summary>
+    /// A cancel posted to a player thread ahead of everything it has queued. Any thread can post one; the
+    /// player thread notices it between device writes, flushes the device and completes it, so only the
+    /// player thread ever touches the device.
+    /// </summary>
+    /// <remarks>
+    /// Posts that arrive before the player gets round to completing share the one flush, and all of their
+    /// callbacks are invoked with the same time.
+    /// </remarks>
+    class BargeInSignal
+    {
+    public:
+        typedef std::function<void(std::chrono::steady_clock::time_point silentAt, bool wasAudible)> SilentCallback;
+
+        void Post(SilentCallback onSilent);
+
+        bool Pending() const { return m_pending.load(std::memory_order_acquire); }
+
+        // Called by the player thread once the device is silent. wasAudible says whether there was anything to silence.
+        void Complete(bool wasAudible);
+
+    private:
+        std::atomic<bool> m_pending{ false };
+        std::mutex m_mutex;
+        std::vector<SilentCallback> m_callbacks;
     };
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <cstddef>
+#include <functional>
 
 #pragma once
 
@@ -14,5 +15,63 @@ public:
         FSTREAM
     };
 
+    virtual ~IAudioPlayerStream() = default;
+
+    /// <summary>
+    /// Blocks until bufferSize bytes have been read or the stream has ended.
+    /// </summary>
+    /// <returns>The number of bytes read. 0 means the stream has ended.</returns>
     virtual unsigned int Read(unsigned char* buffer, size_t bufferSize) = 0;
+
+    /// <summary>
+    /// Copies up to bufferSize bytes that are already available without waiting.
+    /// </summary>
+    /// <returns>The number of bytes read. 0 only means nothing is buffered right now; use IsEndOfStream to tell the difference.</returns>
+    virtual unsigned int TryRead(unsigned char* buffer, size_t bufferSize) = 0;
+
+    /// <summary>
+    /// The number of bytes TryRead can return right now.
+    /// </summary>
+    virtual size_t Available() = 0;
+
+    /// <summary>
+    /// True once the source has finished and every byte has been read.
+    /// </summary>
+    virtual bool IsEndOfStream() = 0;
+
+    /// <summary>
+    /// True once the source has delivered everything, so Available is exactly the audio left to play.
+    /// </summary>
+    virtual bool IsFullyBuffered() { return IsEndOfStream(); }
+
+    /// <summary>
+    /// Registers a callback that is invoked whenever more data becomes available or the stream ends.
+    /// If data is already available the callback is invoked immediately. Pass nullptr to unregister.
+    /// </summary>
+    /// <remarks>
+    /// The callback may run on a background thread owned by the stream so it should only signal the reader.
+    /// </remarks>
+    virtual void SetReadyCallback(std::function<void()> callback) = 0;
+
+    /// <summary>
+    /// True when the stream can hand out slices of its own memory through ReadSlice.
+    /// </summary>
+    virtual bool SupportsSlices() { return false; }
+
+    /// <summary>
+    /// Points slice at up to maxBytes of the stream's own memory and advances past them, without copying.
+    /// The memory stays valid for the lifetime of the stream.
+    /// </summary>
+    /// <returns>The number of bytes in the slice, or 0 at the end of the stream or if slices are not supported.</returns>
+    virtual unsigned int ReadSlice(const unsigned char** slice, size_t maxBytes)
+    {
+        *slice = nullptr;
+        return 0;
+    }
+
+    /// <summary>
+    /// Throws away anything buffered and stops reading ahead, because the player has abandoned the stream.
+    /// Reads return 0 afterwards.
+    /// </summary>
+    virtual void Discard() {}
 };
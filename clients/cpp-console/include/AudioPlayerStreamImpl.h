@@ -3,7 +3,13 @@
 
 #include "AudioPlayerStream.h"
 #include "speechapi_cxx.h"
+#include <condition_variable>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#pragma once
 
 using namespace std;
 using namespace Microsoft::CognitiveServices::Speech;
@@ -13,17 +19,60 @@ namespace AudioPlayer
     class AudioPlayerStreamImpl : public IAudioPlayerStream
     {
     public:
+        // Blocks until it has read some audio into buffer, returning how much, or returns 0 at the end of the audio.
+        typedef std::function<uint32_t(uint8_t* buffer, uint32_t size)> PullSource;
+
+        // How much audio is read ahead, a second at 16khz 16 bit mono.
+        static constexpr size_t PrefetchCapacity = 32768;
 
         AudioPlayerStreamImpl(std::shared_ptr<Audio::PullAudioOutputStream> pStream);
 
+        // Reads ahead from any blocking source the way a pull stream is read.
+        AudioPlayerStreamImpl(PullSource source);
+
         AudioPlayerStreamImpl(std::shared_ptr<fstream> fStream);
 
+        ~AudioPlayerStreamImpl();
+
         virtual unsigned int Read(unsigned char* buffer, size_t bufferSize) final;
 
+        virtual unsigned int TryRead(unsigned char* buffer, size_t bufferSize) final;
+
+        virtual size_t Available() final;
+
+        virtual bool IsEndOfStream() final;
+
+        virtual bool IsFullyBuffered() final;
+
+        virtual void SetReadyCallback(std::function<void()> callback) final;
+
+        virtual void Discard() final;
+
     private:
-        std::shared_ptr<Audio::PullAudioOutputStream> m_pullStream;
+        // Audio read ahead from the pull stream by a background thread so that TryRead never waits on the network.
+        // It is shared with the thread so the stream can be released while the thread is still blocked in the SDK.
+        // The ring is its own heap allocation rather than a pool block, since the thread can outlive everything
+        // else, the pools included, when it is still blocked at exit.
+        struct PrefetchBuffer
+        {
+            std::mutex mutex;
+            std::condition_variable dataReady;
+            std::condition_variable spaceReady;
+            std::unique_ptr<unsigned char[]> ring;
+            size_t head = 0;
+            size_t count = 0;
+            bool endOfStream = false;
+            bool abandoned = false;
+            std::function<void()> readyCallback;
+        };
+
+        static void PrefetchThreadMain(PullSource source, std::shared_ptr<PrefetchBuffer> prefetch);
+        static size_t CopyFromRing(PrefetchBuffer& prefetch, unsigned char* buffer, size_t bufferSize);
+
         std::shared_ptr<fstream> m_fStream;
+        std::shared_ptr<PrefetchBuffer> m_prefetch;
+        std::streamsize m_fileRemaining = 0;
 
         AudioPlayerStreamType m_streamType;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AgentConfiguration.h"
+#include "DialogService.h"
+#include "LatencyHistogram.h"
+
+/// <summary>
+/// What happened to one utterance of a batch run.
+/// </summary>
+struct BatchResult
+{
+    std::string path;
+    std::string recognizedText;
+    // Every activity received for the utterance, as received.
+    std::vector<std::string> activities;
+    // Empty unless the utterance could not be read or the service canceled the turn.
+    std::string error;
+    double audioSeconds = 0;
+
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point audioEnd;
+    std::chrono::steady_clock::time_point recognized;
+    std::chrono::steady_clock::time_point firstActivity;
+    std::chrono::steady_clock::time_point finished;
+};
+
+/// <summary>
+/// Runs a directory or manifest of WAV utterances through several dialog sessions at once and reports
+/// throughput and latency. Workers take the next utterance from a shared queue, read it through a memory
+/// mapping, convert it to 16 khz mono if needed and push it at FileInputSpeed while it is recognized.
+/// </summary>
+/// <example>
+/// <code>
+/// BatchRunner::Options options;
+/// options.concurrency = 8;
+/// BatchRunner runner(agentConfig, options);
+/// int failures = runner.Run(BatchRunner::LoadInputs("utterances/"));
+/// </code>
+/// </example>
+/// <remarks>
+/// With options.local set, every utterance goes to a LocalDialogService that answers a fixed time after
+/// the audio ends, so the numbers measure the client's own overhead without a network or a subscription.
+/// Latencies are measured from the end of each utterance's audio.
+/// </remarks>
+class BatchRunner
+{
+public:
+    struct Options
+    {
+        size_t concurrency = 1;
+        // Answer from a LocalDialogService instead of the dialog service. It plays LocalDialogScript when one
+        // is configured, and otherwise answers every utterance with its file name.
+        bool local = false;
+        // How long the default local script takes to recognize an utterance after its audio ends.
+        std::chrono::milliseconds localResponseDelay{ 0 };
+        // How long to wait for a turn to finish after its audio ends.
+        std::chrono::milliseconds turnTimeout{ 30000 };
+        // A bot may send several activities, some after the session stops. The turn is done once the session has
+        // stopped and no activity has come for this long.
+        std::chrono::milliseconds activityGrace{ 3000 };
+        // Where to write one JSON line per utterance, if anywhere.
+        std::string resultsPath;
+    };
+
+    BatchRunner(std::shared_ptr<AgentConfiguration> agentConfig, Options options);
+
+    // Lists the .wav files of a directory in name order, or the paths in a manifest file, one per line.
+    // Relative manifest paths are resolved against the manifest's directory; blank lines and # comments are skipped.
+    static std::vector<std::string> LoadInputs(const std::string& directoryOrManifest);
+
+    // Runs every input and logs the report. Returns the number of utterances that failed.
+    size_t Run(const std::vector<std::string>& inputs);
+
+    const std::vector<BatchResult>& Results() const { return m_results; }
+    const LatencyHistogram& RecognitionLatency() const { return m_recognitionLatency; }
+    const LatencyHistogram& ActivityLatency() const { return m_activityLatency; }
+
+private:
+    std::unique_ptr<IDialogService> CreateService(const std::string& path);
+    void WorkerMain();
+    void RunUtterance(BatchResult& result);
+    void Report(std::chrono::steady_clock::duration elapsed);
+    void WriteResults();
+
+    std::shared_ptr<AgentConfiguration> m_agentConfig;
+    Options m_options;
+    std::vector<BatchResult> m_results;
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<size_t> m_failures{ 0 };
+    LatencyHistogram m_recognitionLatency;
+    LatencyHistogram m_activityLatency;
+};
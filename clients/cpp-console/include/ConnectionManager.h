@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "DialogService.h"
+
+/// <summary>
+/// Keeps the Direct Line Speech websocket warm. The service closes a connection that has been idle for
+/// five minutes (see docs/CloudConnectionLogic.md), after which the next turn pays for a new connection.
+/// This tracks the service's Connected and Disconnected events, sends a small keepalive activity when the
+/// connection has been idle for the keepalive interval, and reconnects with backoff when the connection drops.
+/// </summary>
+/// <example>
+/// <code>
+/// ConnectionManager connection(dialogService, std::chrono::seconds(270));
+/// connection.Start();
+/// ...
+/// connection.NoteActivity(); // audio or an activity went up
+/// log_t("connected for ", connection.Uptime().count(), "s, reconnects ", connection.ReconnectCount());
+/// </code>
+/// </example>
+/// <remarks>
+/// The connection callbacks only update counters and wake the scheduler thread, which does the logging,
+/// keepalives and reconnects. A keepalive interval of zero disables the keepalives but still reconnects.
+/// A disconnect asked for through Disconnect is not a drop, so it is left to the caller to connect again.
+/// </remarks>
+class ConnectionManager
+{
+public:
+    // The service's idle disconnect.
+    static constexpr std::chrono::seconds ServiceIdleTimeout{ 300 };
+
+    // Backoff between reconnect attempts while the connection stays down, doubling up to the maximum.
+    static constexpr std::chrono::milliseconds FirstReconnectDelay{ 1000 };
+    static constexpr std::chrono::milliseconds MaxReconnectDelay{ 60000 };
+
+    ConnectionManager(std::shared_ptr<IDialogService> service, std::chrono::milliseconds keepAliveInterval,
+        std::chrono::milliseconds firstReconnectDelay = FirstReconnectDelay);
+    ~ConnectionManager();
+
+    ConnectionManager(const ConnectionManager&) = delete;
+    ConnectionManager& operator=(const ConnectionManager&) = delete;
+
+    // Subscribes to the connection events, connects and starts the scheduler.
+    void Start();
+    void Stop();
+
+    // Disconnects without the scheduler reconnecting. The next connection, whoever makes it, is tracked as usual.
+    void Disconnect();
+
+    // Restarts the idle clock. Call when audio or an activity is sent to the service.
+    void NoteActivity();
+
+    bool IsConnected() const { return m_connected.load(); }
+
+    // How long the current connection has been up, zero when disconnected.
+    std::chrono::seconds Uptime() const;
+
+    // Connections made after the first one, whether by the SDK or by us.
+    uint64_t ReconnectCount() const;
+    uint64_t DisconnectCount() const { return m_disconnects.load(); }
+    uint64_t KeepAlivesSent() const { return m_keepAlivesSent.load(); }
+
+private:
+    void OnConnected();
+    void OnDisconnected();
+    void SchedulerThreadMain();
+    void SendKeepAlive();
+    void Reconnect();
+
+    std::shared_ptr<IDialogService> m_service;
+    std::chrono::milliseconds m_keepAliveInterval;
+    std::chrono::milliseconds m_firstReconnectDelay;
+
+    std::atomic<bool> m_connected{ false };
+    std::atomic<int64_t> m_connectedSince{ 0 };
+    std::atomic<int64_t> m_lastActivity{ 0 };
+    std::atomic<uint64_t> m_connects{ 0 };
+    std::atomic<uint64_t> m_disconnects{ 0 };
+    std::atomic<uint64_t> m_keepAlivesSent{ 0 };
+
+    bool m_running = false;
+    bool m_stateChanged = false;
+    // Set by Disconnect and cleared when the next connection comes up.
+    bool m_disconnectRequested = false;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::thread m_schedulerThread;
+};
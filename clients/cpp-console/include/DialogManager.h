@@ -1,11 +1,29 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include "Activity.h"
 #include "AgentConfiguration.h"
+#include "ConnectionManager.h"
 #include "DeviceStatusIndicators.h"
+#include "DialogService.h"
+#include "DispatchPool.h"
 #include "speechapi_cxx.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "AudioPlayerStreamImpl.h"
+#include "LatencyHistogram.h"
+#include "MpscQueue.h"
+#include "StatusBoard.h"
+#include "StatusPipeline.h"
+#include "TtsRecorder.h"
+#include "TurnTracker.h"
+#include "WavHeader.h"
 
 #ifdef LINUX
 #include "LinuxAudioPlayer.h"
@@ -19,6 +37,7 @@
 #endif
 
 using namespace std;
+using namespace Microsoft::CognitiveServices::Speech;
 using namespace Microsoft::CognitiveServices::Speech::Dialog;
 using namespace Microsoft::CognitiveServices::Speech::Audio;
 
@@ -43,8 +62,15 @@ enum class KeywordActivationState
 class DialogManager
 {
 public:
+    // Called on the dispatch thread for every activity received from the service.
+    typedef function<void(Activity& activity)> ActivityHandler;
+
     DialogManager(shared_ptr<AgentConfiguration> agentConfig);
     DialogManager(shared_ptr<AgentConfiguration> agentConfig, string audioFilePath);
+    // A microphone session whose events are handled on a pool shared with other sessions. sessionName
+    // tags its log lines.
+    DialogManager(shared_ptr<AgentConfiguration> agentConfig, shared_ptr<DispatchPool> dispatchPool, string sessionName);
+    ~DialogManager();
     const DeviceStatus GetDeviceStatus() { return _deviceStatus; };
     const KeywordActivationState GetKeywordActivationState() { return _keywordActivationState; }
     // Start a listening session that will terminate after the first utterance.
@@ -57,34 +83,162 @@ public:
     void StartKws();
     // Stop keyword recognition.
     void StopKws();
-    // Start a listening session that read audio stream from a wav file.
+    // Start a listening session that read audio stream from a wav file. The audio is pushed from its own thread,
+    // paced by FileInputSpeed: 1 is real-time, N is N times real-time and 0 is as fast as possible.
     void ListenFromFile();
     // Get mute state of the default microphone.
     bool IsMuted() { return _muter ? _muter->IsMuted() : false; };
+    // Register a handler for received activities. Handlers that need more than the type, id, text and
+    // inputHint can call Activity::Json() to parse the full activity. The DOM lives in a per-activity
+    // arena, so handlers must copy out anything they keep.
+    void AddActivityHandler(ActivityHandler handler);
+    // The per stage turn latency histograms as JSON.
+    string TurnTimelineJson() { return _turnTracker.ToJson(); }
+    // Print the turn latency histograms, and write them to TurnTimelineFile if one is configured.
+    void DumpTurnTimeline();
+    // Write the spans of the last few seconds to TraceFile as a Chrome trace, if TraceFile is configured.
+    void DumpTrace();
+    const string& SessionName() const { return _sessionName; }
+    // CPU time spent handling this session's events, and how many there were.
+    chrono::microseconds DispatchCpuTime() const { return chrono::microseconds(_dispatchCpuMicroseconds.load()); }
+    uint64_t EventsDispatched() const { return _eventsDispatched.load(); }
+    // Time from a keyword being recognized over TTS playback to the audio device going silent.
+    const LatencyHistogram& BargeInLatency() const { return _bargeInLatency; }
+    // Time for keyword recognition to be armed, at start up and each time it is resumed.
+    const LatencyHistogram& KeywordArmLatency() const { return _keywordArmLatency; }
+    // Time from the constructor starting to keyword recognition being armed, and to the connection being
+    // initialized, zero until they happen.
+    chrono::microseconds StartupToArmed() const { return chrono::microseconds(_startupToArmedMicroseconds.load()); }
+    chrono::microseconds StartupToConnected() const { return chrono::microseconds(_startupToConnectedMicroseconds.load()); }
 
 private:
+    // A copy of what the dialog handlers need from an SDK or player callback, handed to the dispatch thread.
+    struct DialogEvent
+    {
+        enum class Type
+        {
+            SessionStarted,
+            SessionStopped,
+            Recognizing,
+            Recognized,
+            Canceled,
+            ActivityReceived,
+            // TTS playback is about to end and the conversation expects more input.
+            Continue,
+            // TTS playback was stopped before the conversation could continue.
+            ContinuationCanceled,
+            // The microphone was muted or unmuted, here or by another program.
+            MuteChanged,
+            // A turn took longer than TraceTurnThresholdMs to be answered. The text is the turn number.
+            SlowTurn
+        };
+
+        DialogEvent() = default;
+        explicit DialogEvent(Type eventType) : type(eventType), received(chrono::steady_clock::now()) {}
+
+        Type type = Type::SessionStarted;
+        // Session id, recognized text, activity json or error details depending on the type.
+        string text;
+        ResultReason reason = ResultReason::NoMatch;
+        CancellationReason cancellationReason = CancellationReason::Error;
+        shared_ptr<IAudioPlayerStream> audio;
+        // When the callback fired, or for continuations when the activity that asked for one arrived.
+        chrono::steady_clock::time_point received;
+    };
+
     bool _volumeOn = false;
     bool _bargeInSupported = false;
     string _audioFilePath = "";
+    string _sessionId = "";
     DeviceStatus _deviceStatus = DeviceStatus::Initializing;
+    // Carries status changes to the indicators off the thread that made them.
+    unique_ptr<StatusPipeline> _statusPipeline;
+    // Shared memory copy of the state for other processes, when StatusBoardName is set.
+    StatusBoard _statusBoard;
     KeywordActivationState _keywordActivationState = KeywordActivationState::Undefined;
-    IAudioPlayer* _player;
+    IAudioPlayer* _player = nullptr;
+    unique_ptr<AudioPlayer::TtsRecorder> _ttsRecorder;
+    // Time from an expectingInput activity arriving to listening again.
+    LatencyHistogram _turnLatency;
+    // Where the time goes between the keyword and the answer, per turn.
+    TurnTracker _turnTracker;
+    // Time spent inside SDK callbacks before they return.
+    LatencyHistogram _callbackResidency;
+    LatencyHistogram _bargeInLatency;
+    // Time for StartKws to arm keyword recognition, at start up and on every resume after an answer.
+    LatencyHistogram _keywordArmLatency;
+    // The last turn a slow turn trace was written for, so each is written once.
+    atomic<uint64_t> _tracedTurn{ 0 };
+    MpscQueue<DialogEvent> _events;
+    // Runs DrainEvents. Private to this session unless one was shared through the constructor.
+    shared_ptr<DispatchPool> _dispatchPool;
+    atomic<bool> _dispatching{ false };
+    // True while a DrainEvents task is queued or running; there is never more than one, which keeps events in order.
+    atomic<bool> _drainScheduled{ false };
+    mutex _dispatchMutex;
+    condition_variable _drainIdle;
+    string _sessionName;
+    atomic<int64_t> _dispatchCpuMicroseconds{ 0 };
+    atomic<uint64_t> _eventsDispatched{ 0 };
+    vector<ActivityHandler> _activityHandlers;
+    // Backs the DOM of the activity being handled on the dispatch thread.
+    ActivityArena _activityArena;
+    mutex _activityHandlersMutex;
     shared_ptr <IMicMuter> _muter;
     shared_ptr<AgentConfiguration> _agentConfig;
-    shared_ptr<DialogServiceConnector> _dialogServiceConnector;
-    shared_ptr<PushAudioInputStream> _pushStream;
+    shared_ptr<IDialogService> _dialogService;
+    // Pushes file input into _dialogService while it is being recognized.
+    thread _pushThread;
+    atomic<bool> _pushing{ false };
+    unique_ptr<ConnectionManager> _connectionManager;
+    bool _connectionStarted = false;
+    // Connects, and sends the keyword priming activity, while keyword recognition is already listening.
+    thread _connectThread;
+    chrono::steady_clock::time_point _startedAt;
+    atomic<int64_t> _startupToArmedMicroseconds{ 0 };
+    atomic<int64_t> _startupToConnectedMicroseconds{ 0 };
     void InitializeDialogServiceConnectorFromMicrophone();
     void InitializeDialogServiceConnectorFromFile();
+    // Replaces the service with a LocalDialogService when LocalDialogScript is configured.
+    bool InitializeLocalDialogService(bool pushedInput);
     void InitializePlayer();
     void InitializeMuter();
     void AttachHandlers();
+    void DetachHandlers();
+    void StartDispatcher();
+    void StopDispatcher();
+    void PostEvent(DialogEvent&& event, chrono::steady_clock::time_point callbackStart);
+    void ScheduleDrain();
+    void DrainEvents();
+    void HandleEvent(DialogEvent& event);
+    void BargeIn(chrono::steady_clock::time_point keywordAt);
+    void HandleRecognized(const DialogEvent& event);
+    void HandleCanceled(const DialogEvent& event);
+    void HandleActivity(DialogEvent& event);
+    void HandleContinuation(const DialogEvent& event);
+    // Creates the connection manager without connecting, so handlers can note activity on it straight away.
+    void InitializeConnectionManager();
+    // Connects and sends the keyword priming activity. Blocks until both are done.
     void InitializeConnection();
+    // Runs InitializeConnection on _connectThread.
+    void ConnectInBackground();
+    // Waits for a connection started by ConnectInBackground to finish coming up.
+    void WaitForConnectThread();
     void SetDeviceStatus(const DeviceStatus status);
-    void SetKeywordActivationState(const KeywordActivationState& state) { _keywordActivationState = state; }
+    void InitializeStatusPipeline();
+    void InitializeStatusBoard();
+    void InitializeTracing();
+    int WriteTrace(const string& path);
+    // Asks for a trace to be written if the turn has taken longer than TraceTurnThresholdMs by at.
+    void CheckTurnLatency(uint64_t turn, chrono::steady_clock::time_point at);
+    static const char* EventName(DialogEvent::Type type);
+    // Called on the player thread when an answer stops playing.
+    void PublishPlaybackEnded(bool canceled, chrono::steady_clock::time_point endedAt);
+    void SetKeywordActivationState(const KeywordActivationState& state);
     void ContinueListening();
     void ResumeKws();
     void PauseKws();
     fstream OpenFile(const string& audioFilePath);
     int ReadBuffer(fstream& fs, uint8_t* dataBuffer, uint32_t size);
-    void PushData(const string& audioFilePath);
+    void PushData(fstream fs, WavFile::WavFileInfo info);
 };
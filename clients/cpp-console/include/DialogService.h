@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "speechapi_cxx.h"
+#include "AudioPlayerStream.h"
+
+/// <summary>
+/// The callbacks a dialog service raises during a conversation. Any of them may be empty.
+/// </summary>
+/// <remarks>
+/// Callbacks run on threads owned by the service and should hand their work off and return.
+/// They must not call back into the service.
+/// </remarks>
+struct DialogServiceHandlers
+{
+    std::function<void(const std::string& sessionId)> sessionStarted;
+    std::function<void(const std::string& sessionId)> sessionStopped;
+    std::function<void(Microsoft::CognitiveServices::Speech::ResultReason reason, const std::string& text)> recognizing;
+    std::function<void(Microsoft::CognitiveServices::Speech::ResultReason reason, const std::string& text)> recognized;
+    std::function<void(Microsoft::CognitiveServices::Speech::CancellationReason reason, const std::string& errorDetails)> canceled;
+    // audio is null when the activity has no TTS.
+    std::function<void(const std::string& activity, std::shared_ptr<IAudioPlayerStream> audio)> activityReceived;
+};
+
+/// <summary>
+/// Abstract object used to define the interface to a dialog service: a Direct Line Speech bot or a
+/// Custom Commands application behind the Speech SDK, or a stand-in for one.
+/// </summary>
+/// <example>
+/// <code>
+/// std::unique_ptr<IDialogService> service = std::make_unique<SpeechDialogService>(connector);
+/// DialogServiceHandlers handlers;
+/// handlers.recognized = [](ResultReason reason, const std::string& text) { ... };
+/// service->SetHandlers(handlers);
+/// service->Connect();
+/// service->ListenOnce();
+/// </code>
+/// </example>
+/// <remarks>
+/// The calls start work and return without waiting for it; results arrive through the handlers.
+/// </remarks>
+class IDialogService
+{
+public:
+    /// <summary>
+    /// The destructor should be defined to clean up any variables or resources.
+    /// </summary>
+    virtual ~IDialogService() = default;
+
+    /// <summary>
+    /// Replaces the conversation callbacks. Pass an empty DialogServiceHandlers to detach; once this returns
+    /// no callback from the old set is still running.
+    /// </summary>
+    virtual void SetHandlers(const DialogServiceHandlers& handlers) = 0;
+
+    /// <summary>
+    /// Replaces the callbacks raised when the connection to the service comes up or goes down. Pass nullptr to detach;
+    /// as with SetHandlers, once this returns neither old callback is still running.
+    /// </summary>
+    virtual void SetConnectionHandlers(std::function<void()> connected, std::function<void()> disconnected) = 0;
+
+    /// <summary>
+    /// Opens the connection to the service.
+    /// </summary>
+    virtual void Connect() = 0;
+
+    /// <summary>
+    /// Closes the connection to the service.
+    /// </summary>
+    virtual void Disconnect() = 0;
+
+    /// <summary>
+    /// Starts a listening session that ends after the first utterance.
+    /// </summary>
+    virtual void ListenOnce() = 0;
+
+    /// <summary>
+    /// Starts listening for the keyword in the model file. A recognized keyword starts a listening session.
+    /// </summary>
+    virtual void StartKeywordRecognition(const std::string& modelPath) = 0;
+
+    /// <summary>
+    /// Stops listening for the keyword.
+    /// </summary>
+    virtual void StopKeywordRecognition() = 0;
+
+    /// <summary>
+    /// Sends an activity, serialized as JSON, to the service.
+    /// </summary>
+    virtual void SendActivity(const std::string& activity) = 0;
+
+    /// <summary>
+    /// Feeds 16 khz 16 bit mono audio to a service that was created for pushed input rather than a microphone.
+    /// </summary>
+    virtual void WriteAudio(const uint8_t* data, uint32_t size) = 0;
+
+    /// <summary>
+    /// Marks the end of the pushed audio.
+    /// </summary>
+    virtual void CloseAudio() = 0;
+};
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A fixed set of worker threads that run submitted tasks, shared by the dialog sessions of a process so
+/// that handling their events does not cost a thread per session.
+/// </summary>
+/// <example>
+/// <code>
+/// auto pool = std::make_shared&lt;DispatchPool&gt;(2);
+/// DialogManager first(firstConfig, pool, "kitchen");
+/// DialogManager second(secondConfig, pool, "hallway");
+/// </code>
+/// </example>
+/// <remarks>
+/// Tasks run in submission order but may run concurrently on different workers. A DialogManager keeps its
+/// own events in order by having at most one drain task queued or running at a time.
+/// </remarks>
+class DispatchPool
+{
+public:
+    explicit DispatchPool(size_t threadCount);
+    ~DispatchPool();
+
+    DispatchPool(const DispatchPool&) = delete;
+    DispatchPool& operator=(const DispatchPool&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    size_t ThreadCount() const { return m_workers.size(); }
+    uint64_t TasksRun() const { return m_tasksRun.load(); }
+
+private:
+    void WorkerThreadMain();
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskReady;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_running = true;
+    std::vector<std::thread> m_workers;
+    std::atomic<uint64_t> m_tasksRun{ 0 };
+};
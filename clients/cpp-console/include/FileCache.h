@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// <summary>
+/// The modification time and size of a file, used to notice that it changed.
+/// </summary>
+struct FileStamp
+{
+    bool exists = false;
+    int64_t modified = 0;
+    uint64_t size = 0;
+
+    // Stats path. A file that cannot be stat'ed comes back with exists false.
+    static FileStamp Of(const std::string& path);
+
+    bool operator==(const FileStamp& other) const { return exists == other.exists && modified == other.modified && size == other.size; }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Keeps what was loaded from a file for the life of the process, and hands the same object back until the
+/// file changes on disk.
+/// </summary>
+/// <example>
+/// <code>
+/// FileCache&lt;KeywordRecognitionModel&gt; models([](const std::string&amp; path) { return KeywordRecognitionModel::FromFile(path); });
+/// auto model = models.Get(modelPath); // read from disk
+/// model = models.Get(modelPath);      // the same model, after a stat
+/// </code>
+/// </example>
+/// <remarks>
+/// A change is a different modification time or size. If a changed or deleted file fails to load, the object
+/// loaded before is kept and the load is tried again on the next Get, so a model being copied over does not
+/// break keyword recognition. A file that has never loaded throws whatever the loader throws.
+/// </remarks>
+template <typename T>
+class FileCache
+{
+public:
+    typedef std::function<std::shared_ptr<T>(const std::string& path)> Loader;
+
+    explicit FileCache(Loader loader) : m_loader(loader)
+    {
+    }
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    std::shared_ptr<T> Get(const std::string& path)
+    {
+        FileStamp stamp = FileStamp::Of(path);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cached = m_entries.find(path);
+        if (cached != m_entries.end() && cached->second.stamp == stamp)
+        {
+            m_hits++;
+            return cached->second.value;
+        }
+
+        std::shared_ptr<T> value;
+        try
+        {
+            value = m_loader(path);
+        }
+        catch (...)
+        {
+            if (cached == m_entries.end())
+            {
+                throw;
+            }
+            m_failedReloads++;
+            return cached->second.value;
+        }
+
+        m_loads++;
+        Entry& entry = m_entries[path];
+        entry.value = value;
+        entry.stamp = stamp;
+        return value;
+    }
+
+    // Loads from disk, including reloads after a change.
+    uint64_t Loads() const { return m_loads.load(); }
+    // Gets answered from memory.
+    uint64_t Hits() const { return m_hits.load(); }
+    // Reloads that failed and left the previous object in use.
+    uint64_t FailedReloads() const { return m_failedReloads.load(); }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<T> value;
+        FileStamp stamp;
+    };
+
+    Loader m_loader;
+    std::mutex m_mutex;
+    std::map<std::string, Entry> m_entries;
+    std::atomic<uint64_t> m_loads{ 0 };
+    std::atomic<uint64_t> m_hits{ 0 };
+    std::atomic<uint64_t> m_failedReloads{ 0 };
+};
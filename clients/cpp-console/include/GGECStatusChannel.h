@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DeviceStatusIndicators.h"
+
+/// <summary>
+/// Sends the GGEC speaker's LED and voice UI messages over one long-lived Unix domain socket instead of running
+/// adk-message-send through a shell for every status change.
+/// </summary>
+/// <example>
+/// <code>
+/// GGECStatusChannel channel("/run/adk/status.sock");
+/// channel.Send(DeviceStatus::Listening); // writes "led_start_pattern {pattern:0}\n"
+/// </code>
+/// </example>
+/// <remarks>
+/// Each message is the text adk-message-send takes, ending in a newline, and is encoded once at construction so a
+/// status change is a single write. The socket is connected on first use. When there is no socket path, or the
+/// receiver is not there, the message goes through system() as before and a reconnect is tried at most once per
+/// ReconnectInterval, so a missing receiver costs no more than the old path did.
+/// </remarks>
+class GGECStatusChannel
+{
+public:
+    static constexpr std::chrono::milliseconds ReconnectInterval{ 1000 };
+
+    // An empty socketPath always uses system().
+    explicit GGECStatusChannel(const std::string& socketPath);
+    ~GGECStatusChannel();
+
+    GGECStatusChannel(const GGECStatusChannel&) = delete;
+    GGECStatusChannel& operator=(const GGECStatusChannel&) = delete;
+
+    // Returns 0 when the message went over the socket, 1 when it fell back to system(), -1 when both failed.
+    int Send(DeviceStatus status);
+
+    // The message sent for status, without the trailing newline.
+    static std::string MessageFor(DeviceStatus status);
+
+    uint64_t SentOverSocket() const { return m_sentOverSocket.load(); }
+    uint64_t SentThroughShell() const { return m_sentThroughShell.load(); }
+    uint64_t Reconnects() const { return m_reconnects.load(); }
+
+    // The indicators' process wide channel, on the socket named by the GGEC_STATUS_SOCKET environment variable.
+    static GGECStatusChannel& Default();
+
+private:
+    bool EnsureConnected();
+    bool WriteAll(const std::string& message);
+    void Disconnect();
+
+    std::string m_socketPath;
+    std::vector<std::string> m_messages;
+    std::vector<std::string> m_commands;
+    std::mutex m_mutex;
+    int m_socket = -1;
+    bool m_everConnected = false;
+    std::chrono::steady_clock::time_point m_nextConnectAttempt;
+    std::atomic<uint64_t> m_sentOverSocket{ 0 };
+    std::atomic<uint64_t> m_sentThroughShell{ 0 };
+    std::atomic<uint64_t> m_reconnects{ 0 };
+};
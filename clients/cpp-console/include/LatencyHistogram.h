@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// A fixed-size latency histogram in the style of HdrHistogram. Values are recorded in microseconds
+/// into log-linear buckets, 32 per power of two, so every percentile is accurate to about 3%
+/// from one microsecond up to several days.
+/// </summary>
+/// <example>
+/// <code>
+/// LatencyHistogram histogram;
+/// auto start = std::chrono::steady_clock::now();
+/// ...
+/// histogram.Record(std::chrono::steady_clock::now() - start);
+/// log_t("p99 = ", histogram.Percentile(99.0), "us");
+/// </code>
+/// </example>
+/// <remarks>
+/// Record is lock-free and does not allocate, so it can be called from the audio path and SDK callbacks.
+/// Readers see a consistent-enough snapshot for reporting but not an atomic one.
+/// </remarks>
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t microseconds);
+    void Record(std::chrono::steady_clock::duration duration);
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t Min() const;
+    double Mean() const;
+
+    // The smallest recorded value that percent of all values are less than or equal to, in microseconds.
+    uint64_t Percentile(double percent) const;
+
+    void Reset();
+
+private:
+    static constexpr int SubBucketBits = 5;
+    static constexpr size_t SubBucketCount = 1 << SubBucketBits;
+    static constexpr size_t BucketCount = SubBucketCount * (64 - SubBucketBits + 1);
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum{ 0 };
+    std::atomic<uint64_t> m_max{ 0 };
+};
@@ -36,8 +36,13 @@ namespace AudioPlayer
 
         virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream) final;
 
+        virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, PlaybackEndingCallback onEnding,
+            PlaybackStartedCallback onStarted = nullptr) final;
+
         virtual int Stop() final;
 
+        virtual int BargeIn(BargeInCallback onSilent) final;
+
         /// <summary>
         /// not implemented currently
         /// </summary
@@ -63,19 +68,29 @@ namespace AudioPlayer
         bool                    m_canceled = false;
         bool                    m_shuttingDown;
         std::string             m_device;
-        std::mutex              m_queueMutex;
         std::mutex              m_threadMutex;
         std::condition_variable m_conditionVariable;
+        std::mutex              m_streamMutex;
+        std::condition_variable m_streamReady;
 
         AudioPlayerState m_state = AudioPlayerState::UNINITIALIZED;
 
-        std::list<AudioPlayerEntry> m_audioQueue;
+        AudioPlayerEntryQueue m_audioQueue;
+        BargeInSignal m_bargeIn;
 
         std::thread m_playerThread;
         void PlayerThreadMain();
-        void PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry);
-        void PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry> pEntry);
-        int WriteToALSA(uint8_t* buffer);
+        void PlayByteBuffer(AudioPlayerEntry& entry);
+        void PlayAudioPlayerStream(AudioPlayerEntry& entry);
+        int WriteToALSA(const uint8_t* buffer);
+        // True when the current entry should stop playing, because of Stop, BargeIn or Close.
+        bool Interrupted() const { return m_canceled || m_bargeIn.Pending(); }
+        void CompleteBargeIn(bool wasPlaying);
+        int Enqueue(AudioPlayerEntry&& entry);
+        std::chrono::milliseconds QueuedAudio(size_t pendingBytes);
+        void CheckPlaybackStarted(AudioPlayerEntry& entry, size_t bytesWritten);
+        void CheckPlaybackEnding(AudioPlayerEntry& entry);
+        void FinishPlaybackEnding(AudioPlayerEntry& entry);
         void SetAlsaMasterVolume(long volume);
         int Close();
     };
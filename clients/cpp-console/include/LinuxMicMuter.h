@@ -3,20 +3,65 @@
 
 #pragma once
 
+#include <alsa/asoundlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "LatencyHistogram.h"
 #include "MicMuter.h"
 
 namespace MicMuter
 {
+    /// <summary>
+    /// Mutes the microphone with the capture switch of the ALSA mixer on the capture device's card.
+    /// </summary>
+    /// <remarks>
+    /// The mixer is opened and the capture switch element found once, in Initialize. A thread waits on the mixer's
+    /// poll descriptors, so a mute made by another program (alsamixer, a hardware button) shows up in IsMuted and
+    /// the mute changed handler as soon as the driver reports it, with no polling. The time from MuteUnmute to the
+    /// driver's change event is recorded in MuteLatency. The mute state found at start up is restored on exit.
+    /// </remarks>
     class LinuxMicMuter :public IMicMuter
     {
     public:
+        // captureDeviceName is LinuxCaptureDeviceName, for example plughw:1,0. Empty means the default card.
+        explicit LinuxMicMuter(const std::string& captureDeviceName = "");
         ~LinuxMicMuter();
 
         virtual int Initialize() final;
         virtual int MuteUnmute() final;
         virtual bool IsMuted() final;
+        virtual void SetMuteChangedHandler(MuteChangedHandler handler) final;
+
+        // Time from MuteUnmute to the driver reporting the new state.
+        const LatencyHistogram& MuteLatency() const { return _muteLatency; }
+
+        // The mixer device for a PCM device name: hw:1 for plughw:1,0, default when there is no card in the name.
+        static std::string MixerDeviceFor(const std::string& captureDeviceName);
 
     private:
-        bool _muted = false;
+        void EventThreadMain();
+        // Reads the switch and reports a change. Called with _mixerMutex held; returns true if the state changed.
+        bool ReadSwitch();
+
+        std::string _mixerDevice;
+        snd_mixer_t* _mixer = nullptr;
+        snd_mixer_elem_t* _captureSwitch = nullptr;
+        // The mixer handle is not thread safe; this serializes MuteUnmute against the event thread.
+        std::mutex _mixerMutex;
+        std::atomic<bool> _muted{ false };
+        bool _originalMuted = false;
+        std::mutex _handlerMutex;
+        MuteChangedHandler _muteChanged;
+
+        std::thread _eventThread;
+        int _wakePipe[2] = { -1, -1 };
+
+        bool _changeRequested = false;
+        bool _requestedMuted = false;
+        std::chrono::steady_clock::time_point _requestedAt;
+        LatencyHistogram _muteLatency;
     };
 };
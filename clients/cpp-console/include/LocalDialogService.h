@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DialogService.h"
+
+/// <summary>
+/// An offline stand-in for the dialog service that plays back a script. Every listening session answers with the
+/// next scripted turn: intermediate and final recognition, then an activity with generated or recorded TTS audio,
+/// each after a fixed delay. Latency and load tests become deterministic and need neither a network nor a subscription.
+/// </summary>
+/// <example>
+/// <code>
+/// auto service = LocalDialogService::FromScriptFile("local-dialog.json", true);
+/// service->SetHandlers(handlers);
+/// service->ListenOnce();
+/// service->WriteAudio(audio, size);
+/// service->CloseAudio(); // recognition is answered RecognizedDelayMs after this
+/// </code>
+/// </example>
+/// <remarks>
+/// A script is JSON:
+///   { "ConnectDelayMs": 50, "KeywordAfterMs": 0, "RecognizingDelayMs": 200, "RecognizedDelayMs": 300, "ActivityDelayMs": 400,
+///     "Turns": [ { "Text": "what time is it", "Reply": "It is noon.", "TtsMs": 1500, "TtsFile": "", "ExpectingInput": false, "Activity": { } } ] }
+/// Turns are used in order and wrap around. TtsFile, a 16 khz 16 bit mono WAV file, takes precedence over TtsMs of
+/// generated tone, and fields of Activity are merged into the reply activity. For pushed input the final result comes
+/// RecognizedDelayMs after the audio is closed, otherwise after the session starts. With KeywordAfterMs set, keyword
+/// recognition reports a keyword that long after it starts, and again after every keyword turn while it stays on.
+/// Connect returns ConnectDelayMs after it is called, once the connection is up, as the connector's does; sessions
+/// started before then begin when it is up.
+/// </remarks>
+class LocalDialogService : public IDialogService
+{
+public:
+    struct Turn
+    {
+        std::string text = "hello";
+        std::string reply = "Hello from the local dialog service.";
+        std::chrono::milliseconds ttsDuration{ 1000 };
+        std::string ttsFile;
+        bool expectingInput = false;
+        // Serialized JSON object merged into the reply activity.
+        std::string activity;
+    };
+
+    struct Script
+    {
+        std::chrono::milliseconds connectDelay{ 0 };
+        // Zero means keywords are never reported.
+        std::chrono::milliseconds keywordAfter{ 0 };
+        std::chrono::milliseconds recognizingDelay{ 0 };
+        std::chrono::milliseconds recognizedDelay{ 0 };
+        std::chrono::milliseconds activityDelay{ 0 };
+        std::vector<Turn> turns;
+    };
+
+    // pushedInput says whether audio comes through WriteAudio, as it does for file input, or from a microphone.
+    LocalDialogService(Script script, bool pushedInput);
+    ~LocalDialogService();
+
+    LocalDialogService(const LocalDialogService&) = delete;
+    LocalDialogService& operator=(const LocalDialogService&) = delete;
+
+    // Returns nullptr if the script cannot be read.
+    static std::unique_ptr<LocalDialogService> FromScriptFile(const std::string& path, bool pushedInput);
+
+    virtual void SetHandlers(const DialogServiceHandlers& handlers) final;
+    virtual void SetConnectionHandlers(std::function<void()> connected, std::function<void()> disconnected) final;
+    virtual void Connect() final;
+    virtual void Disconnect() final;
+    virtual void ListenOnce() final;
+    virtual void StartKeywordRecognition(const std::string& modelPath) final;
+    virtual void StopKeywordRecognition() final;
+    virtual void SendActivity(const std::string& activity) final;
+    virtual void WriteAudio(const uint8_t* data, uint32_t size) final;
+    virtual void CloseAudio() final;
+
+    uint64_t TurnsCompleted() const { return m_turnsCompleted.load(); }
+    uint64_t AudioBytesReceived() const { return m_audioBytes.load(); }
+    uint64_t ActivitiesSent() const { return m_activitiesSent.load(); }
+
+private:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    typedef std::multimap<TimePoint, std::function<void()>> ActionQueue;
+
+    // The caller holds m_mutex for all of these.
+    void Schedule(TimePoint at, std::function<void()> action);
+    // Returns when the connection is, or will be, up.
+    TimePoint ConnectLocked(TimePoint at);
+    void ScheduleKeywordLocked(TimePoint at);
+    void StartSessionLocked(TimePoint at, bool keyword);
+    void FinishSessionLocked(TimePoint inputEnd, bool matched);
+
+    // Runs callback with the current handlers, unless the connection was dropped since epoch.
+    void Raise(uint64_t epoch, const std::function<void(const DialogServiceHandlers&)>& callback);
+    void WorkerThreadMain();
+
+    Script m_script;
+    bool m_pushedInput;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    ActionQueue m_actions;
+    bool m_running = true;
+    bool m_connected = false;
+    TimePoint m_connectedAt;
+    // Bumped when the connection drops, so the events of the abandoned session are dropped too.
+    uint64_t m_epoch = 0;
+    bool m_listening = false;
+    std::string m_sessionId;
+    // The intermediate result of the current session, withdrawn if the final result would come first.
+    ActionQueue::iterator m_recognizingAction;
+    bool m_recognizingPending = false;
+    // Whether the current session was started by a keyword.
+    bool m_keywordSession = false;
+    bool m_awaitingInputEnd = false;
+    bool m_inputClosed = false;
+    bool m_inputConsumed = false;
+    // Bumped when keyword recognition stops, so keywords scheduled before then are dropped.
+    uint64_t m_keywordGeneration = 0;
+    bool m_keywordArmed = false;
+    size_t m_nextTurn = 0;
+    uint64_t m_sessions = 0;
+
+    // Held while callbacks run, so replacing them waits for the ones in flight.
+    std::mutex m_handlersMutex;
+    DialogServiceHandlers m_handlers;
+    std::function<void()> m_onConnected;
+    std::function<void()> m_onDisconnected;
+
+    std::atomic<uint64_t> m_turnsCompleted{ 0 };
+    std::atomic<uint64_t> m_audioBytes{ 0 };
+    std::atomic<uint64_t> m_activitiesSent{ 0 };
+    std::thread m_workerThread;
+};
@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <string>
+#include "AudioPlayerStream.h"
+#include "WavHeader.h"
+
+namespace AudioPlayer
+{
+    /// <summary>
+    /// An IAudioPlayerStream over a memory-mapped WAV file. The RIFF header is parsed on open
+    /// so callers no longer need to skip a fixed number of bytes, and reads are served as slices
+    /// of the mapping so playback costs no system calls per period.
+    /// </summary>
+    /// <example>
+    /// <code>
+    /// auto stream = std::make_shared<AudioPlayer::MappedAudioPlayerStream>("prompt.wav");
+    /// if (stream->IsValid())
+    /// {
+    ///     audioPlayer->Play(stream);
+    /// }
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// The stream does not convert audio, so check Format() against what the player was initialized with.
+    /// </remarks>
+    class MappedAudioPlayerStream : public IAudioPlayerStream
+    {
+    public:
+        MappedAudioPlayerStream(const std::string& filePath);
+
+        ~MappedAudioPlayerStream();
+
+        MappedAudioPlayerStream(const MappedAudioPlayerStream&) = delete;
+        MappedAudioPlayerStream& operator=(const MappedAudioPlayerStream&) = delete;
+
+        // True when the file was mapped and its header was parsed.
+        bool IsValid() const { return m_data != nullptr; }
+
+        WavFile::WavParseResult ParseResult() const { return m_parseResult; }
+
+        const WavFile::WavFormat& Format() const { return m_info.format; }
+
+        size_t DataLength() const { return m_info.dataLength; }
+
+        // Starts the stream over from the first sample so a prompt can be replayed without remapping it.
+        void Rewind() { m_position = 0; }
+
+        virtual unsigned int Read(unsigned char* buffer, size_t bufferSize) final;
+
+        virtual unsigned int TryRead(unsigned char* buffer, size_t bufferSize) final;
+
+        virtual size_t Available() final;
+
+        virtual bool IsEndOfStream() final;
+
+        virtual bool IsFullyBuffered() final { return true; }
+
+        virtual void SetReadyCallback(std::function<void()> callback) final;
+
+        virtual bool SupportsSlices() final { return true; }
+
+        virtual unsigned int ReadSlice(const unsigned char** slice, size_t maxBytes) final;
+
+    private:
+        bool Map(const std::string& filePath);
+        void Unmap();
+
+        const unsigned char* m_mapping = nullptr;
+        size_t m_mappingSize = 0;
+#ifdef WINDOWS
+        void* m_fileHandle = nullptr;
+        void* m_mappingHandle = nullptr;
+#endif
+
+        WavFile::WavFileInfo m_info;
+        WavFile::WavParseResult m_parseResult = WavFile::WavParseResult::Truncated;
+        const unsigned char* m_data = nullptr;
+        size_t m_position = 0;
+    };
+}
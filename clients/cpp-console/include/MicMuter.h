@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <functional>
+
 /// <summary>
 /// Abstract object used to define the interface to a MicMuter
 /// </summary>
@@ -9,6 +11,8 @@
 class IMicMuter
 {
 public:
+    typedef std::function<void(bool muted)> MuteChangedHandler;
+
     /// <summary>
     /// The destructor should be defined to clean up any variables or resources.
     /// </summary>
@@ -41,4 +45,12 @@ public:
     /// <remarks>
     /// </remarks>
     virtual bool IsMuted() = 0;
+
+    /// <summary>
+    /// Sets a handler called whenever the mute state changes, including changes made outside this program.
+    /// </summary>
+    /// <remarks>
+    /// The handler may be called on a thread owned by the muter. Muters that cannot detect changes never call it.
+    /// </remarks>
+    virtual void SetMuteChangedHandler(MuteChangedHandler handler) {}
 };
@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+/// <summary>
+/// An unbounded multi-producer single-consumer queue. Push is lock-free (one allocation and one atomic
+/// exchange), so it can be called from SDK callbacks and audio threads without waiting on the consumer.
+/// </summary>
+/// <example>
+/// <code>
+/// MpscQueue&lt;Event&gt; queue;
+/// // any thread
+/// queue.Push(Event{ ... });
+/// // the consumer thread
+/// Event event;
+/// while (queue.WaitPop(event, std::chrono::milliseconds(100))) { Handle(event); }
+/// </code>
+/// </example>
+/// <remarks>
+/// Based on Dmitry Vyukov's intrusive MPSC queue. The consumer may block in WaitPop; producers only
+/// take the wake-up mutex when the consumer is actually asleep.
+/// The consumer may move between threads as long as only one of them consumes at a time, as when a
+/// DispatchPool drains the queue.
+/// </remarks>
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : m_head(&m_stub), m_tail(&m_stub)
+    {
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+        while (TryPop(value))
+        {
+        }
+        if (m_tail != &m_stub)
+        {
+            delete m_tail;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread.
+    void Push(T&& value)
+    {
+        Node* node = new Node(std::move(value));
+        Node* previous = m_head.exchange(node, std::memory_order_seq_cst);
+        // seq_cst pairs with the consumer's check in WaitPop so a sleeping consumer is never missed
+        previous->next.store(node, std::memory_order_seq_cst);
+
+        if (m_consumerWaiting.load(std::memory_order_seq_cst))
+        {
+            Wake();
+        }
+    }
+
+    // Consumer thread only. Returns false if the queue is empty.
+    bool TryPop(T& value)
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return false;
+        }
+
+        // next becomes the new stub, so only its value is taken
+        value = std::move(next->value);
+        m_tail = next;
+        if (tail != &m_stub)
+        {
+            delete tail;
+        }
+        return true;
+    }
+
+    // Consumer thread only. False positives are possible while a producer is half way through a push.
+    bool IsEmpty() const
+    {
+        return m_tail->next.load(std::memory_order_seq_cst) == nullptr;
+    }
+
+    // Consumer thread only. Waits up to timeout for an item; returns false on timeout, on Wake, or if
+    // a producer was interrupted half way through a push (the item shows up on the next call).
+    bool WaitPop(T& value, std::chrono::milliseconds timeout)
+    {
+        if (TryPop(value))
+        {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_consumerWaiting.store(true, std::memory_order_seq_cst);
+        if (m_tail->next.load(std::memory_order_seq_cst) == nullptr)
+        {
+            m_wakeUp.wait_for(lock, timeout);
+        }
+        m_consumerWaiting.store(false, std::memory_order_relaxed);
+        lock.unlock();
+
+        return TryPop(value);
+    }
+
+    // Wakes the consumer if it is blocked in WaitPop, for example to shut it down.
+    void Wake()
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeUp.notify_one();
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T&& nodeValue) : value(std::move(nodeValue))
+        {
+        }
+
+        std::atomic<Node*> next{ nullptr };
+        T value;
+    };
+
+    Node m_stub;
+    alignas(64) std::atomic<Node*> m_head;
+    alignas(64) Node* m_tail;
+    std::atomic<bool> m_consumerWaiting{ false };
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeUp;
+};
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "WavHeader.h"
+
+/// <summary>
+/// Paces audio pushed from a file into the push stream at a multiple of real time, in chunks about the size a
+/// microphone delivers, so a file can stand in for live input.
+/// </summary>
+/// <example>
+/// <code>
+/// PushPacer pacer(agentConfig->_fileInputSpeed);
+/// uint32_t chunk = PushPacer::InputBytesPerChunk(info.format);
+/// while (...)
+/// {
+///     pacer.WaitForNextChunk();
+///     pushStream->Write(data, size);
+///     pacer.Pushed(size);
+/// }
+/// log_t(pacer.AudioSeconds(), "s pushed");
+/// </code>
+/// </example>
+/// <remarks>
+/// Each chunk is released once the clock has caught up with the audio pushed before it, counted from the
+/// first chunk, so sleeping late never accumulates into drift. A speed of 0 or less pushes without waiting.
+/// </remarks>
+class PushPacer
+{
+public:
+    // Audio is pushed in blocks of this much, about what a microphone delivers at a time.
+    static constexpr uint32_t ChunkMs = 20;
+
+    // The push stream's default format, 16 khz 16 bit mono.
+    static constexpr double PushStreamBytesPerSecond = 16000 * 2;
+
+    // speed is a multiple of real time: 1 for a live microphone's pace, 4 for four times that.
+    explicit PushPacer(double speed);
+
+    // The number of bytes of input in format that hold ChunkMs of audio.
+    static uint32_t InputBytesPerChunk(const WavFile::WavFormat& format);
+
+    // Sleeps until the next chunk is due.
+    void WaitForNextChunk();
+
+    // Counts bytes of push stream format audio as pushed.
+    void Pushed(uint32_t bytes) { m_pushedBytes += bytes; }
+
+    bool IsPaced() const { return m_speed > 0; }
+    uint64_t PushedBytes() const { return m_pushedBytes; }
+    double AudioSeconds() const { return (double)m_pushedBytes / PushStreamBytesPerSecond; }
+    std::chrono::steady_clock::time_point Started() const { return m_start; }
+
+    // The furthest behind its due time any chunk went out.
+    std::chrono::steady_clock::duration MaxLateness() const { return m_maxLateness; }
+
+private:
+    double m_speed;
+    uint64_t m_pushedBytes = 0;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::duration m_maxLateness{ 0 };
+};
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/// <summary>
+/// Point in time readings of the CPU time and memory used by this process, for the reports printed by the
+/// session host and the benchmarks.
+/// </summary>
+/// <remarks>
+/// CPU times are the sum of user and kernel time. Any reading the platform cannot provide comes back as zero.
+/// </remarks>
+namespace ResourceUsage
+{
+    // CPU time used by every thread of the process so far.
+    std::chrono::microseconds ProcessCpuTime();
+
+    // CPU time used by the calling thread so far.
+    std::chrono::microseconds ThreadCpuTime();
+
+    // The bytes of the process currently resident in memory.
+    uint64_t ResidentBytes();
+
+    // The most bytes the process has had resident at once.
+    uint64_t PeakResidentBytes();
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DispatchPool.h"
+
+class DialogManager;
+
+/// <summary>
+/// Runs several microphone dialog sessions, one per configuration file, in a single process. The sessions
+/// share one dispatch pool, the process wide audio buffer pools and the console log, where each session's
+/// lines are tagged with its name.
+/// </summary>
+/// <example>
+/// <code>
+/// SessionHost host(2);
+/// host.Start({ "kitchen.json", "hallway.json" });
+/// host.Report();
+/// </code>
+/// </example>
+/// <remarks>
+/// A session's CPU time is the time the dispatch pool spent handling its events. The CPU used by the SDK
+/// and the audio threads is only visible in the process total. A session's memory is the growth of the
+/// resident set while it was created, so it covers its player, connector and buffers but not anything
+/// the sessions allocate later.
+/// </remarks>
+class SessionHost
+{
+public:
+    struct Session
+    {
+        std::string name;
+        std::shared_ptr<DialogManager> dialogManager;
+        // How much the resident set grew while the session was created.
+        uint64_t residentBytes = 0;
+    };
+
+    explicit SessionHost(size_t dispatchThreads);
+    ~SessionHost();
+
+    // Loads every configuration and starts a session for each. The session is named after its file.
+    // Returns 0, or the load result of the first configuration that failed, in which case nothing is started.
+    int Start(const std::vector<std::string>& configFilePaths);
+
+    // Logs per session and aggregate CPU time and resident memory.
+    void Report();
+
+    const std::vector<Session>& Sessions() const { return m_sessions; }
+
+private:
+    std::shared_ptr<DispatchPool> m_dispatchPool;
+    std::vector<Session> m_sessions;
+    std::chrono::steady_clock::time_point m_started;
+    std::chrono::microseconds m_processCpuAtStart{ 0 };
+    uint64_t m_residentBytesAtStart = 0;
+};
@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include "DialogService.h"
+#include "FileCache.h"
+#include "speechapi_cxx.h"
+
+/// <summary>
+/// The dialog service reached through the Speech SDK's DialogServiceConnector.
+/// </summary>
+/// <example>
+/// <code>
+/// auto pushStream = AudioInputStream::CreatePushStream();
+/// auto connector = DialogServiceConnector::FromConfig(config, AudioConfig::FromStreamInput(pushStream));
+/// SpeechDialogService service(connector, pushStream);
+/// </code>
+/// </example>
+/// <remarks>
+/// TTS audio is wrapped in an AudioPlayerStreamImpl inside the SDK callback so that prefetching starts as soon
+/// as the activity arrives. Keyword models come from a cache shared by every connector in the process, so
+/// resuming keyword recognition after each answer does not read the model from disk again.
+/// The SDK signals are connected once and call the current handlers under a mutex, since disconnecting an SDK
+/// signal does not wait for a callback already running; replacing the handlers waits for it instead.
+/// </remarks>
+class SpeechDialogService : public IDialogService
+{
+public:
+    // pushStream is the connector's audio input when it reads pushed audio rather than a microphone.
+    SpeechDialogService(std::shared_ptr<Microsoft::CognitiveServices::Speech::Dialog::DialogServiceConnector> connector,
+        std::shared_ptr<Microsoft::CognitiveServices::Speech::Audio::PushAudioInputStream> pushStream = nullptr);
+    ~SpeechDialogService();
+
+    SpeechDialogService(const SpeechDialogService&) = delete;
+    SpeechDialogService& operator=(const SpeechDialogService&) = delete;
+
+    virtual void SetHandlers(const DialogServiceHandlers& handlers) final;
+    virtual void SetConnectionHandlers(std::function<void()> connected, std::function<void()> disconnected) final;
+    virtual void Connect() final;
+    virtual void Disconnect() final;
+    virtual void ListenOnce() final;
+    virtual void StartKeywordRecognition(const std::string& modelPath) final;
+    virtual void StopKeywordRecognition() final;
+    virtual void SendActivity(const std::string& activity) final;
+    virtual void WriteAudio(const uint8_t* data, uint32_t size) final;
+    virtual void CloseAudio() final;
+
+    // The keyword models loaded so far, reloaded when their file changes.
+    static FileCache<Microsoft::CognitiveServices::Speech::KeywordRecognitionModel>& KeywordModelCache();
+
+private:
+    // Shared with the SDK callbacks, which may still be starting when the service is destroyed.
+    struct Callbacks
+    {
+        // Held while a callback runs, so replacing the handlers waits for the one in flight.
+        std::mutex mutex;
+        DialogServiceHandlers handlers;
+        std::function<void()> connected;
+        std::function<void()> disconnected;
+    };
+
+    void ConnectSignals();
+    void DisconnectSignals();
+
+    std::shared_ptr<Callbacks> m_callbacks;
+
+    std::shared_ptr<Microsoft::CognitiveServices::Speech::Dialog::DialogServiceConnector> m_connector;
+    std::shared_ptr<Microsoft::CognitiveServices::Speech::Audio::PushAudioInputStream> m_pushStream;
+    std::shared_ptr<Microsoft::CognitiveServices::Speech::Connection> m_connection;
+    // Kept so that starting a listening session does not wait for it to finish.
+    std::future<std::shared_ptr<Microsoft::CognitiveServices::Speech::SpeechRecognitionResult>> m_listen;
+    std::mutex m_listenMutex;
+};
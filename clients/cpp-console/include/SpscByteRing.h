@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include "AudioBufferPool.h"
+
+namespace AudioPlayer
+{
+    /// <summary>
+    /// A bounded lock-free byte ring for exactly one producer thread and one consumer thread.
+    /// Neither side ever blocks or allocates, which makes it safe to feed from the audio path.
+    /// </summary>
+    /// <example>
+    /// <code>
+    /// SpscByteRing ring(AudioBufferPool::ChunkPool().Acquire());
+    /// // producer
+    /// if (!ring.Write(samples, size)) { dropped += size; }
+    /// // consumer
+    /// const unsigned char* region;
+    /// size_t length = ring.ReadableRegion(&region);
+    /// fwrite(region, 1, length, file);
+    /// ring.Consume(length);
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// The capacity is the storage capacity rounded down to a power of two.
+    /// </remarks>
+    class SpscByteRing
+    {
+    public:
+        explicit SpscByteRing(PooledBuffer storage);
+
+        SpscByteRing(const SpscByteRing&) = delete;
+        SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+        size_t Capacity() const { return m_mask + 1; }
+
+        // Producer: copies all of data into the ring, or nothing if there is not enough space.
+        bool Write(const unsigned char* data, size_t size);
+
+        // Consumer: points region at the longest contiguous run of unread bytes and returns its length.
+        size_t ReadableRegion(const unsigned char** region) const;
+
+        // Consumer: releases size bytes previously returned by ReadableRegion.
+        void Consume(size_t size);
+
+        // The number of unread bytes. Exact when called from either side, a snapshot otherwise.
+        size_t Size() const;
+
+    private:
+        PooledBuffer m_storage;
+        size_t m_mask = 0;
+
+        // positions only ever increase; the index into the storage is position & m_mask
+        alignas(64) std::atomic<size_t> m_readPosition{ 0 };
+        alignas(64) std::atomic<size_t> m_writePosition{ 0 };
+    };
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "StatusBoardLayout.h"
+
+/// <summary>
+/// Publishes the assistant's state in a named shared memory segment, so the LED daemon, a screen UI or a watchdog
+/// can poll it instead of scraping stdout. The layout is in StatusBoardLayout.h.
+/// </summary>
+/// <example>
+/// <code>
+/// StatusBoard board;
+/// board.Open("/cppSample.status");
+/// board.Update([](StatusBoardFields&amp; fields) { fields.deviceStatus = (uint32_t)DeviceStatus::Listening; });
+/// </code>
+/// </example>
+/// <remarks>
+/// Updates are seqlock writes: two stores to the sequence around a copy of the fields, with no syscall. Writers from
+/// different threads are serialized by a mutex; readers take no lock at all. On Linux the name is a POSIX shared
+/// memory name and the segment is in /dev/shm; on Windows it is a named file mapping in the session namespace.
+/// The segment is removed when the board is closed.
+/// </remarks>
+class StatusBoard
+{
+public:
+    StatusBoard() = default;
+    ~StatusBoard();
+
+    StatusBoard(const StatusBoard&) = delete;
+    StatusBoard& operator=(const StatusBoard&) = delete;
+
+    // Creates or takes over the segment. Returns 0 on success.
+    int Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return m_segment != nullptr; }
+
+    // Runs change on a copy of the published fields and publishes the result. Does nothing if the board is not open.
+    void Update(const std::function<void(StatusBoardFields& fields)>& change);
+
+    // Microseconds on the clock the fields' timestamps use, CLOCK_MONOTONIC on Linux.
+    static uint64_t NowMicroseconds();
+    static uint64_t ToMicroseconds(std::chrono::steady_clock::time_point time);
+
+private:
+    std::atomic<uint32_t>& Sequence();
+
+    std::string m_name;
+    StatusBoardSegment* m_segment = nullptr;
+    StatusBoardFields m_fields{};
+    std::mutex m_writeMutex;
+#ifdef WINDOWS
+    void* m_mapping = nullptr;
+#endif
+};
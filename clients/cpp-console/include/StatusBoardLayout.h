@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+/*
+ * The layout of the status board, the shared memory segment the sample publishes its state in for other processes
+ * on the device. It is plain C so that readers in any language with a C FFI can map it. See StatusBoard.h for the
+ * writer and StatusBoardReader.h for the reader library.
+ *
+ * The segment is guarded by a seqlock. The writer makes sequence odd, updates the fields and makes it even again.
+ * A reader copies the fields between two loads of sequence and keeps the copy only if both loads returned the
+ * same even value. Readers never write to the segment, so any number of them can poll it without a syscall.
+ */
+
+#include <stdint.h>
+
+#define STATUS_BOARD_MAGIC 0x42535356u /* "VSSB" */
+#define STATUS_BOARD_VERSION 1u
+
+/* Fields only ever get added at the end; readers check size before reading newer ones. */
+typedef struct StatusBoardFields
+{
+    uint32_t deviceStatus;            /* DeviceStatus, Idle = 0 to Speaking = 6 */
+    uint32_t keywordActivationState;  /* KeywordActivationState, Undefined = 0 to NotListening = 4 */
+    uint32_t muted;                   /* 1 when the microphone is muted */
+    uint32_t playing;                 /* 1 while TTS audio is playing */
+    uint64_t playbackStartedUs;       /* CLOCK_MONOTONIC microseconds the current or last answer became audible, 0 if none */
+    uint64_t playbackEndedUs;         /* when it stopped, or 0 while it is still playing */
+    uint64_t turnsStarted;
+    uint64_t turnsPlayed;             /* turns whose answer played to the end */
+    uint64_t bargeIns;
+    uint64_t updatedUs;               /* CLOCK_MONOTONIC microseconds of the last update */
+} StatusBoardFields;
+
+typedef struct StatusBoardSegment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fieldsSize;              /* sizeof(StatusBoardFields) in the writer's build */
+    uint32_t writerPid;
+    uint32_t sequence;                /* the seqlock, odd while an update is in progress */
+    uint32_t reserved;
+    StatusBoardFields fields;
+} StatusBoardSegment;
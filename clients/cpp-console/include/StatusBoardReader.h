@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+/*
+ * A small C library for processes that want the sample's state from its status board (see StatusBoardLayout.h).
+ * Reading takes no lock and makes no syscall, so it is cheap enough to call from a render or LED loop.
+ *
+ *   StatusBoardReader* reader = statusboard_open("/cppSample.status");
+ *   StatusBoardFields fields;
+ *   if (reader != NULL && statusboard_read(reader, &fields) == 0)
+ *   {
+ *       printf("status %u, played %llu ms\n", fields.deviceStatus, statusboard_playback_position_ms(&fields));
+ *   }
+ *   statusboard_close(reader);
+ *
+ * Linux only: it maps the POSIX shared memory the writer creates in /dev/shm. Link with -lrt on older glibc.
+ */
+
+#include "StatusBoardLayout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct StatusBoardReader StatusBoardReader;
+
+/* Maps the board read only. Returns NULL if it does not exist, is not a status board or is a newer major version. */
+StatusBoardReader* statusboard_open(const char* name);
+void statusboard_close(StatusBoardReader* reader);
+
+/* Copies a consistent snapshot of the fields. Returns 0 on success, or -1 if the writer was mid update for every one
+   of a bounded number of attempts, which only happens if it died during an update. */
+int statusboard_read(const StatusBoardReader* reader, StatusBoardFields* fields);
+
+/* The sequence of the last completed update; it changes whenever the fields do, so pollers can skip unchanged boards. */
+uint32_t statusboard_sequence(const StatusBoardReader* reader);
+
+/* The writer's process id, for watchdogs. */
+uint32_t statusboard_writer_pid(const StatusBoardReader* reader);
+
+/* How far into the current or last answer playback is, in milliseconds. */
+uint64_t statusboard_playback_position_ms(const StatusBoardFields* fields);
+
+#ifdef __cplusplus
+}
+#endif
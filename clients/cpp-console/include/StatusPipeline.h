@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "DeviceStatusIndicators.h"
+#include "LatencyHistogram.h"
+
+/// <summary>
+/// Delivers device status changes to the indicators on a thread of its own, so that slow indicators such as a
+/// console write or a LED command never hold up the thread that changed the status. Updates that do not change
+/// anything are dropped, and bursts are coalesced so that only the latest status of a burst is shown.
+/// </summary>
+/// <example>
+/// <code>
+/// StatusPipeline pipeline(std::chrono::milliseconds(100));
+/// pipeline.Post(DeviceStatus::Detecting, false); // shown straight away
+/// pipeline.Post(DeviceStatus::Detecting, false); // no change, suppressed
+/// pipeline.Post(DeviceStatus::Listening, false); // shown 100ms after Detecting unless replaced first
+/// </code>
+/// </example>
+/// <remarks>
+/// A change that arrives after a quiet spell of at least the coalescing window is delivered at once. Changes
+/// within the window of the last delivery wait for the window to end, and only the latest of them is delivered.
+/// Latency is measured from the Post of the delivered status to the indicator returning.
+/// </remarks>
+class StatusPipeline
+{
+public:
+    typedef std::function<void(DeviceStatus status, bool muted)> Indicator;
+
+    // Delivers to DeviceStatusIndicators::SetStatus unless another indicator is given.
+    explicit StatusPipeline(std::chrono::milliseconds coalesceWindow, Indicator indicator = nullptr);
+    // Delivers the last posted status, if it has not been delivered yet, before returning.
+    ~StatusPipeline();
+
+    StatusPipeline(const StatusPipeline&) = delete;
+    StatusPipeline& operator=(const StatusPipeline&) = delete;
+
+    // Queues a status for the indicators. Never blocks on them.
+    void Post(DeviceStatus status, bool muted);
+
+    uint64_t Delivered() const { return m_delivered.load(); }
+    // Updates that were dropped as no-ops or replaced within a burst.
+    uint64_t Suppressed() const { return m_suppressed.load(); }
+    const LatencyHistogram& IndicatorLatency() const { return m_indicatorLatency; }
+
+private:
+    struct Update
+    {
+        DeviceStatus status = DeviceStatus::Initializing;
+        bool muted = false;
+        std::chrono::steady_clock::time_point posted;
+
+        bool SameAs(const Update& other) const { return status == other.status && muted == other.muted; }
+    };
+
+    void DeliveryThreadMain();
+
+    std::chrono::milliseconds m_coalesceWindow;
+    Indicator m_indicator;
+
+    std::mutex m_mutex;
+    std::condition_variable m_updated;
+    Update m_lastPosted;
+    bool m_hasPosted = false;
+    Update m_pending;
+    bool m_hasPending = false;
+    bool m_stopping = false;
+
+    std::atomic<uint64_t> m_delivered{ 0 };
+    std::atomic<uint64_t> m_suppressed{ 0 };
+    LatencyHistogram m_indicatorLatency;
+    std::thread m_deliveryThread;
+};
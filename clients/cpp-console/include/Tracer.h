@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Records spans and instant events into a ring buffer per thread and exports them as a Chrome trace
+/// (chrome://tracing or https://ui.perfetto.dev), so a slow turn can be looked at as a timeline of what
+/// every thread was doing instead of being pieced together from the log.
+/// </summary>
+/// <example>
+/// <code>
+/// Tracer::Instance().Enable(true);
+/// {
+///     TraceSpan span("kws", "StartKws");
+///     _dialogService->StartKeywordRecognition(modelPath);
+/// }
+/// Tracer::Instance().Instant("status", "Post");
+/// Tracer::Instance().WriteChromeTrace("trace.json");
+/// </code>
+/// </example>
+/// <remarks>
+/// Recording is lock free: each thread writes only to its own ring and readers check a per event
+/// sequence to skip events being overwritten, so exporting does not stop the threads being traced.
+/// Each ring keeps the last EventsPerThread events, which makes the tracer a flight recorder of the
+/// last few seconds. Category and event names must be string literals, or otherwise outlive the
+/// tracer, since only the pointers are stored. While tracing is disabled a span costs one relaxed load.
+/// A thread's ring goes back to the tracer when the thread exits and the next new thread takes it over, so
+/// the memory held depends on how many threads trace at once rather than how many ever did. The events of
+/// an exited thread stay in the trace until its ring is taken over.
+/// </remarks>
+class Tracer
+{
+public:
+    static constexpr size_t EventsPerThread = 8192;
+    // Threads beyond this many at once record nothing and are counted in EventsDropped().
+    static constexpr size_t MaxThreads = 64;
+
+    static Tracer& Instance();
+
+    void Enable(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool Enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Records a span that ran from start to end on the calling thread.
+    void Complete(const char* category, const char* name, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end);
+    // Records a point in time on the calling thread.
+    void Instant(const char* category, const char* name, std::chrono::steady_clock::time_point at = std::chrono::steady_clock::now());
+    // Names the calling thread in the exported trace.
+    void SetThreadName(const char* name);
+
+    // Every event still in the rings, oldest first per thread, as a Chrome trace JSON document.
+    std::string ToChromeTraceJson();
+    // Writes ToChromeTraceJson() to path. Returns 0 on success.
+    int WriteChromeTrace(const std::string& path);
+
+    // Events recorded since the start, including those since overwritten.
+    uint64_t EventsRecorded();
+    uint64_t EventsDropped() const { return m_eventsDropped.load(); }
+
+private:
+    struct Event
+    {
+        // 2 * index + 1 while being written, 2 * index + 2 once written
+        std::atomic<uint64_t> sequence{ 0 };
+        std::atomic<const char*> category{ nullptr };
+        std::atomic<const char*> name{ nullptr };
+        // steady_clock microseconds
+        std::atomic<int64_t> start{ 0 };
+        // -1 for an instant event
+        std::atomic<int64_t> duration{ 0 };
+    };
+
+    struct Ring
+    {
+        std::atomic<uint32_t> threadId{ 0 };
+        std::atomic<const char*> threadName{ nullptr };
+        std::atomic<uint64_t> head{ 0 };
+        // index of the owning thread's first event; earlier ones belong to a thread that has exited
+        std::atomic<uint64_t> first{ 0 };
+        std::unique_ptr<Event[]> events;
+    };
+
+    // Hands the calling thread's ring back to the tracer when the thread exits.
+    struct RingOwner
+    {
+        Ring* ring = nullptr;
+        ~RingOwner();
+    };
+
+    Tracer() = default;
+    // The calling thread's ring, or nullptr before its first event.
+    static Ring*& CurrentRing();
+    Ring* ThreadRing();
+    void ReleaseRing(Ring* ring);
+    void Record(const char* category, const char* name, int64_t start, int64_t duration);
+
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<uint64_t> m_eventsDropped{ 0 };
+    std::mutex m_ringsMutex;
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    // rings of exited threads, ready for the next new thread
+    std::vector<Ring*> m_freeRings;
+    uint32_t m_lastThreadId = 0;
+};
+
+/// <summary>
+/// Records the time from its construction to its destruction as a span, if tracing was enabled when it
+/// was constructed.
+/// </summary>
+class TraceSpan
+{
+public:
+    TraceSpan(const char* category, const char* name)
+    {
+        if (Tracer::Instance().Enabled())
+        {
+            m_category = category;
+            m_name = name;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_name != nullptr)
+        {
+            Tracer::Instance().Complete(m_category, m_name, m_start, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_category = nullptr;
+    const char* m_name = nullptr;
+    std::chrono::steady_clock::time_point m_start;
+};
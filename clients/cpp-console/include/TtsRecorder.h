@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioPlayerStream.h"
+#include "SpscByteRing.h"
+#include "WavHeader.h"
+
+namespace AudioPlayer
+{
+    /// <summary>
+    /// Saves the TTS audio of each turn to its own WAV file without putting disk I/O on the audio path.
+    /// The audio path copies samples into a bounded lock-free ring per turn, and a low priority writer
+    /// thread drains the rings to disk.
+    /// </summary>
+    /// <example>
+    /// <code>
+    /// TtsRecorder recorder("recordings", TtsRecorder::DefaultFormat());
+    /// auto turn = recorder.StartTurn(sessionId, activityId);
+    /// turn->Write(buffer, bytesRead);
+    /// turn->Finish();
+    /// </code>
+    /// </example>
+    /// <remarks>
+    /// When the writer falls behind, audio that does not fit in a turn's ring is dropped and counted
+    /// instead of blocking playback. Files are named &lt;sessionId&gt;_&lt;activityId&gt;.wav.
+    /// </remarks>
+    class TtsRecorder
+    {
+    public:
+        class Turn
+        {
+        public:
+            Turn(const std::string& path, PooledBuffer ringStorage);
+
+            // Copies audio into the turn's ring. Never blocks; drops the whole block if it does not fit.
+            void Write(const unsigned char* data, size_t size);
+
+            // Marks the end of the turn's audio. The file is closed once the writer has drained the ring.
+            void Finish() { m_finished.store(true, std::memory_order_release); }
+
+            const std::string& Path() const { return m_path; }
+            uint64_t DroppedBytes() const { return m_droppedBytes.load(); }
+
+        private:
+            friend class TtsRecorder;
+
+            std::string m_path;
+            SpscByteRing m_ring;
+            std::atomic<bool> m_finished{ false };
+            std::atomic<uint64_t> m_droppedBytes{ 0 };
+
+            // owned by the writer thread
+            FILE* m_file = nullptr;
+            uint32_t m_bytesWritten = 0;
+            bool m_failed = false;
+        };
+
+        TtsRecorder(const std::string& directory, const WavFile::WavFormat& format);
+
+        // Drains and closes every open turn.
+        ~TtsRecorder();
+
+        TtsRecorder(const TtsRecorder&) = delete;
+        TtsRecorder& operator=(const TtsRecorder&) = delete;
+
+        // Begins a new recording. Either id may be empty; characters that are not valid in a file name are replaced.
+        std::shared_ptr<Turn> StartTurn(const std::string& sessionId, const std::string& activityId);
+
+        uint64_t RecordedTurns() const { return m_recordedTurns.load(); }
+        uint64_t DroppedBytes() const { return m_droppedBytes.load(); }
+
+        // The format of the TTS audio the connector returns by default: 16khz 16 bit mono PCM.
+        static WavFile::WavFormat DefaultFormat();
+
+    private:
+        void WriterThreadMain();
+        void Drain(Turn& turn);
+        void Close(Turn& turn);
+
+        std::string m_directory;
+        WavFile::WavFormat m_format;
+        std::mutex m_turnsMutex;
+        std::vector<std::shared_ptr<Turn>> m_turns;
+        std::vector<std::shared_ptr<Turn>> m_writerTurns;
+        std::atomic<bool> m_stopping{ false };
+        std::atomic<uint64_t> m_recordedTurns{ 0 };
+        std::atomic<uint64_t> m_droppedBytes{ 0 };
+        uint64_t m_turnCount = 0;
+        std::thread m_writer;
+    };
+
+    /// <summary>
+    /// Passes a player stream through unchanged while copying everything read from it into a recorder turn.
+    /// </summary>
+    /// <remarks>
+    /// The turn is finished when the stream reaches its end or is released by the player.
+    /// </remarks>
+    class TeeAudioPlayerStream : public IAudioPlayerStream
+    {
+    public:
+        TeeAudioPlayerStream(std::shared_ptr<IAudioPlayerStream> source, std::shared_ptr<TtsRecorder::Turn> turn);
+
+        ~TeeAudioPlayerStream();
+
+        virtual unsigned int Read(unsigned char* buffer, size_t bufferSize) final;
+
+        virtual unsigned int TryRead(unsigned char* buffer, size_t bufferSize) final;
+
+        virtual size_t Available() final;
+
+        virtual bool IsEndOfStream() final;
+
+        virtual bool IsFullyBuffered() final;
+
+        virtual void SetReadyCallback(std::function<void()> callback) final;
+
+        virtual bool SupportsSlices() final;
+
+        virtual unsigned int ReadSlice(const unsigned char** slice, size_t maxBytes) final;
+
+        virtual void Discard() final;
+
+    private:
+        unsigned int Record(const unsigned char* data, unsigned int size);
+
+        std::shared_ptr<IAudioPlayerStream> m_source;
+        std::shared_ptr<TtsRecorder::Turn> m_turn;
+    };
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "LatencyHistogram.h"
+
+/// <summary>
+/// Timestamps the stages of each dialog turn and keeps a latency histogram per stage, both from the start of
+/// the turn and from the stage before it, so the time between the keyword and the first audible answer can be
+/// broken down.
+/// </summary>
+/// <example>
+/// <code>
+/// TurnTracker tracker;
+/// uint64_t turn = tracker.StartTurn();            // keyword recognized
+/// tracker.Mark(TurnTracker::Stage::FinalRecognized);
+/// tracker.Mark(turn, TurnTracker::Stage::FirstAudible, audibleAt); // from another thread
+/// log_t(tracker.ToJson());
+/// </code>
+/// </example>
+/// <remarks>
+/// Only the first Mark of a stage in a turn counts. Marks can come from any thread; marks for a turn that has
+/// already been replaced by a newer one are ignored. Stages that a turn skips, such as audio for a text-only
+/// answer, are simply not recorded for it.
+/// </remarks>
+class TurnTracker
+{
+public:
+    enum class Stage
+    {
+        // The keyword was recognized or listening was started by hand or for a multiturn reply.
+        TurnStarted,
+        FirstRecognizing,
+        FinalRecognized,
+        FirstActivity,
+        // The first TTS audio was handed to the audio device.
+        FirstAudioByte,
+        // The first TTS sample is expected to be heard.
+        FirstAudible,
+        PlaybackEnded
+    };
+
+    static constexpr size_t StageCount = 7;
+
+    TurnTracker() = default;
+    TurnTracker(const TurnTracker&) = delete;
+    TurnTracker& operator=(const TurnTracker&) = delete;
+
+    // Starts a new turn and returns its id.
+    uint64_t StartTurn(std::chrono::steady_clock::time_point at = std::chrono::steady_clock::now());
+    uint64_t CurrentTurn() const { return m_turn.load(); }
+    // Time from the start of the given turn to at, or zero if the turn is no longer current.
+    std::chrono::steady_clock::duration Elapsed(uint64_t turn, std::chrono::steady_clock::time_point at) const;
+
+    // Records a stage of the current turn, or of the given turn if it is still current. Returns false if the
+    // stage was already recorded or the turn is no longer current.
+    bool Mark(Stage stage, std::chrono::steady_clock::time_point at = std::chrono::steady_clock::now());
+    bool Mark(uint64_t turn, Stage stage, std::chrono::steady_clock::time_point at = std::chrono::steady_clock::now());
+
+    const LatencyHistogram& SinceTurnStart(Stage stage) const { return m_sinceTurnStart[(size_t)stage]; }
+    const LatencyHistogram& SincePreviousStage(Stage stage) const { return m_sincePreviousStage[(size_t)stage]; }
+
+    static const char* StageName(Stage stage);
+
+    // The histograms of every stage as a JSON document, in microseconds.
+    std::string ToJson() const;
+
+private:
+    std::atomic<uint64_t> m_turn{ 0 };
+    // steady_clock ticks of each stage in the current turn, 0 when not reached yet
+    std::array<std::atomic<int64_t>, StageCount> m_marks{};
+    std::array<LatencyHistogram, StageCount> m_sinceTurnStart;
+    std::array<LatencyHistogram, StageCount> m_sincePreviousStage;
+};
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+namespace WavFile
+{
+    constexpr uint16_t FormatPcm = 0x0001;
+    constexpr uint16_t FormatIeeeFloat = 0x0003;
+    constexpr uint16_t FormatExtensible = 0xFFFE;
+
+    // The contents of the "fmt " chunk. For WAVE_FORMAT_EXTENSIBLE files formatTag holds the sub format.
+    struct WavFormat
+    {
+        uint16_t formatTag = 0;
+        uint16_t channels = 0;
+        uint32_t samplesPerSecond = 0;
+        uint32_t averageBytesPerSecond = 0;
+        uint16_t blockAlign = 0;
+        uint16_t bitsPerSample = 0;
+    };
+
+    struct WavFileInfo
+    {
+        WavFormat format;
+        // Offset of the first sample from the start of the file.
+        size_t dataOffset = 0;
+        // Length of the sample data in bytes, clamped to what is actually in the file.
+        size_t dataLength = 0;
+    };
+
+    enum class WavParseResult
+    {
+        Success,
+        NotRiff,
+        NotWave,
+        MissingFormat,
+        MissingData,
+        Truncated
+    };
+
+    /// <summary>
+    /// Walks the RIFF chunks of an in-memory WAV file to find the format and the data chunk.
+    /// Unknown chunks such as LIST or fact are skipped.
+    /// </summary>
+    /// <param name="data">The start of the file</param>
+    /// <param name="size">The number of bytes available at data</param>
+    /// <param name="info">Receives the format and location of the samples on success</param>
+    /// <returns>WavParseResult::Success or the reason the header could not be parsed</returns>
+    WavParseResult ParseHeader(const unsigned char* data, size_t size, WavFileInfo& info);
+
+    /// <summary>
+    /// Reads RIFF chunk headers from a stream until it reaches the data chunk, skipping anything
+    /// it does not need without reading it. On success the stream is left at the first sample.
+    /// </summary>
+    /// <param name="stream">A binary stream positioned at the start of the file</param>
+    /// <param name="info">Receives the format and location of the samples on success</param>
+    /// <returns>WavParseResult::Success or the reason the header could not be parsed</returns>
+    /// <remarks>
+    /// dataLength is 0 when the header does not record a length, in which case the samples run to the end of the stream.
+    /// </remarks>
+    WavParseResult ReadHeader(std::istream& stream, WavFileInfo& info);
+
+    // Size of the header written by WriteHeader: RIFF, a 16 byte fmt chunk and the data chunk header.
+    constexpr size_t CanonicalHeaderSize = 44;
+
+    /// <summary>
+    /// Writes a canonical 44 byte PCM WAV header for dataLength bytes of samples.
+    /// </summary>
+    /// <param name="format">The format of the samples that follow the header</param>
+    /// <param name="dataLength">The number of bytes of sample data</param>
+    /// <param name="header">Receives CanonicalHeaderSize bytes</param>
+    void WriteHeader(const WavFormat& format, uint32_t dataLength, unsigned char* header);
+
+    std::string ToString(WavParseResult result);
+}
@@ -47,8 +47,13 @@ namespace AudioPlayer
 
         virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream) final;
 
+        virtual int Play(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, PlaybackEndingCallback onEnding,
+            PlaybackStartedCallback onStarted = nullptr) final;
+
         virtual int Stop() final;
 
+        virtual int BargeIn(BargeInCallback onSilent) final;
+
         /// <summary>
         /// not implemented currently
         /// </summary
@@ -67,11 +72,13 @@ namespace AudioPlayer
         bool                    m_canceled = false;
         bool                    m_shuttingDown = false;
         std::string             m_device;
-        std::mutex              m_queueMutex;
         std::mutex              m_threadMutex;
         std::condition_variable m_conditionVariable;
+        std::mutex              m_streamMutex;
+        std::condition_variable m_streamReady;
 
-        std::list<AudioPlayerEntry> m_audioQueue;
+        AudioPlayerEntryQueue m_audioQueue;
+        BargeInSignal m_bargeIn;
 
         AudioPlayerState m_state = AudioPlayerState::UNINITIALIZED;
 
@@ -104,8 +111,16 @@ namespace AudioPlayer
 
         std::thread m_playerThread;
         void PlayerThreadMain();
-        void PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry);
-        void PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry> pEntry);
+        void PlayByteBuffer(AudioPlayerEntry& entry);
+        void PlayAudioPlayerStream(AudioPlayerEntry& entry);
+        int Enqueue(AudioPlayerEntry&& entry);
+        // True when the current entry should stop playing, because of Stop, BargeIn or Close.
+        bool Interrupted() const { return m_canceled || m_bargeIn.Pending(); }
+        void CompleteBargeIn(bool wasPlaying);
+        std::chrono::milliseconds QueuedAudio(size_t pendingBytes);
+        void CheckPlaybackStarted(AudioPlayerEntry& entry, size_t bytesWritten);
+        void CheckPlaybackEnding(AudioPlayerEntry& entry);
+        void FinishPlaybackEnding(AudioPlayerEntry& entry);
         int Close();
     };
 }
\ No newline at end of file
@@ -1,39 +1,154 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
-#include <chrono>
-#include <ctime>
-#include <iostream>
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "AsyncLogger.h"
 
 using namespace std;
 
-static void log()
+// Log levels for the LOG_* macros, lowest first. Plain log and log_t calls are not leveled and always print.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+
+// LOG_* calls below this level are removed by the preprocessor, arguments and all, so they cost nothing
+// at run time. Build with -D LOG_LEVEL_FLOOR=LOG_LEVEL_INFO (or 2) to take the debug logging out too.
+#ifndef LOG_LEVEL_FLOOR
+#define LOG_LEVEL_FLOOR LOG_LEVEL_DEBUG
+#endif
+
+// The run time threshold for the LOG_* calls that survive the floor. Defaults to info.
+inline atomic<int>& log_level_threshold()
+{
+    static atomic<int> threshold{ LOG_LEVEL_INFO };
+    return threshold;
+}
+
+inline bool log_level_enabled(int level)
+{
+    return level >= log_level_threshold().load(memory_order_relaxed);
+}
+
+// Sets the run time threshold. Levels below LOG_LEVEL_FLOOR stay compiled out whatever it is set to.
+inline void log_set_level(int level)
+{
+    log_level_threshold().store(level, memory_order_relaxed);
+}
+
+// Maps "trace", "debug", "info", "warning" or "error" to its level, or returns -1.
+inline int log_level_from_name(const string& name)
+{
+    static const char* names[] = { "trace", "debug", "info", "warning", "error" };
+    for (int level = LOG_LEVEL_TRACE; level <= LOG_LEVEL_ERROR; level++)
+    {
+        if (name == names[level])
+        {
+            return level;
+        }
+    }
+    return -1;
+}
+
+// Sets the run time threshold by name, returning false for a name log_level_from_name does not know.
+inline bool log_set_level(const string& name)
+{
+    int level = log_level_from_name(name);
+    if (level < 0)
+    {
+        return false;
+    }
+    log_set_level(level);
+    return true;
+}
+
+// The session the calling thread is working for, printed by log_t when set. Lets the sessions of a
+// multi-session host share one log.
+inline string& log_session()
+{
+    static thread_local string session;
+    return session;
+}
+
+inline void log_append(LogLine& line)
 {
-    cout << endl;
 }
 
 template<typename T, typename... Args>
-void log(T v, Args... args)
+void log_append(LogLine& line, const T& v, const Args&... args)
 {
-    cout << v << flush;
-    log(args...);
+    line.Append(v);
+    log_append(line, args...);
+}
+
+// Formats the arguments into the calling thread's line buffer and hands the line to the background writer.
+template<typename... Args>
+void log(const Args&... args)
+{
+    LogLine& line = AsyncLogger::ThreadLine();
+    line.Clear();
+    log_append(line, args...);
+    AsyncLogger::Instance().Write(line.Data(), line.Size());
 }
 
 template<typename T, typename... Args>
-void log_t(T v, Args... args)
-{
-    char buff[9];
-    chrono::system_clock::time_point now = chrono::system_clock::now();
-    time_t now_c = chrono::system_clock::to_time_t(now);
-    tm now_tm;
-#ifdef LINUX
-    localtime_r(&now_c, &now_tm);
+void log_t(const T& v, const Args&... args)
+{
+    LogLine& line = AsyncLogger::ThreadLine();
+    line.Clear();
+    line.AppendTimestamp();
+    line.Append("  ");
+    if (!log_session().empty())
+    {
+        line.Append('[');
+        line.Append(log_session());
+        line.Append("] ");
+    }
+    log_append(line, v, args...);
+    AsyncLogger::Instance().Write(line.Data(), line.Size());
+}
+
+// Leveled log_t. The arguments are only evaluated when the level is enabled, and a level below
+// LOG_LEVEL_FLOOR expands to an empty statement.
+#define LOG_AT_LEVEL(level, ...) \
+    do \
+    { \
+        if (log_level_enabled(level)) \
+        { \
+            log_t(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if LOG_LEVEL_FLOOR <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) do { } while (0)
 #endif
-#ifdef WINDOWS
-    localtime_s(&now_tm, &now_c);
+
+#if LOG_LEVEL_FLOOR <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { } while (0)
 #endif
-    strftime(buff, sizeof buff, "%H:%M:%S", &now_tm);
 
-    cout << buff << "." << chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000 << "  ";
-    log(v, args...);
-}
+#if LOG_LEVEL_FLOOR <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT_LEVEL(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL_FLOOR <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) LOG_AT_LEVEL(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL_FLOOR <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { } while (0)
+#endif
@@ -42,9 +42,14 @@ set commonTargets=-std=c++14 %inc% %incDir% %lib%
 
 set src=src/GGEC/GGECLinuxAudioPlayer.cpp %src%
 set src=src/GGEC/GGECDeviceStatusIndicators.cpp %src%
+set src=src/GGEC/GGECStatusChannel.cpp %src%
 set src=src/common/AudioPlayerEntry.cpp %src%
 set src=src/common/Main.cpp %src%
 set src=src/common/AgentConfiguration.cpp %src%
+set src=src/common/AsyncLogger.cpp %src%
+set src=src/common/Tracer.cpp %src%
+set src=src/common/FileCache.cpp %src%
+set src=src/common/PushPacer.cpp %src%
 set src=src/common/DialogManager.cpp %src%
 set tgt=out/sample.exe
 
@@ -55,5 +60,13 @@ set finalCommand=%buildCmd% -o %tgt% %src% %commonTargets% %defines%
 echo build command = %finalCommand%
 %finalCommand%
 
+set benchSrc=src/GGEC/GGECStatusBenchmark.cpp src/GGEC/GGECStatusChannel.cpp src/common/LatencyHistogram.cpp src/common/AsyncLogger.cpp
+echo Building: out/statusBenchmark.exe
+%buildCmd% -o out/statusBenchmark.exe %benchSrc% -std=c++14 -I include -lpthread %defines%
+
+set testSrc=src/GGEC/GGECStatusChannelTests.cpp src/GGEC/GGECStatusChannel.cpp src/common/AsyncLogger.cpp
+echo Building: out/statusChannelTests.exe
+%buildCmd% -o out/statusChannelTests.exe %testSrc% -std=c++14 -I include -lpthread %defines%
+
 echo Cleaning up unnecesary downloaded files
 DEL /S /F /Q .\SDK >NUL
\ No newline at end of file
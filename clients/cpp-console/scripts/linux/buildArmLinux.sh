@@ -53,6 +53,29 @@ src/common/AgentConfiguration.cpp \
 src/common/DeviceStatusIndicators.cpp \
 src/common/DialogManager.cpp \
 src/common/AudioPlayerStreamImpl.cpp \
+src/common/AudioBufferPool.cpp \
+src/common/WavHeader.cpp \
+src/common/MappedAudioPlayerStream.cpp \
+src/common/AudioConverter.cpp \
+src/common/SpscByteRing.cpp \
+src/common/TtsRecorder.cpp \
+src/common/LatencyHistogram.cpp \
+src/common/Activity.cpp \
+src/common/ActivityArena.cpp \
+src/common/ConnectionManager.cpp \
+src/common/TurnTracker.cpp \
+src/common/BatchRunner.cpp \
+src/common/SpeechDialogService.cpp \
+src/common/LocalDialogService.cpp \
+src/common/DispatchPool.cpp \
+src/common/ResourceUsage.cpp \
+src/common/SessionHost.cpp \
+src/common/StatusPipeline.cpp \
+src/common/StatusBoard.cpp \
+src/common/AsyncLogger.cpp \
+src/common/Tracer.cpp \
+src/common/FileCache.cpp \
+src/common/PushPacer.cpp \
 -o ./out/sample.exe \
 -std=c++14 \
 -D LINUX \
@@ -63,6 +86,7 @@ src/common/AudioPlayerStreamImpl.cpp \
 -pthread \
 -lstdc++fs \
 -lasound \
+-lrt \
 -lMicrosoft.CognitiveServices.Speech.core; 
 then
 error=0;
@@ -70,6 +94,14 @@ else
 error=1;
 fi
 
+if [ $error -eq 0 ]; then
+echo "Building the status board reader library and benchmark ..."
+gcc -O2 -c src/linux/StatusBoardReader.c -I./include -o ./out/StatusBoardReader.o && \
+ar rcs ./out/libstatusboard.a ./out/StatusBoardReader.o && \
+g++ src/linux/StatusBoardBenchmark.cpp src/common/StatusBoard.cpp -o ./out/statusBoardBenchmark.exe \
+-std=c++14 -D LINUX -I./include -L./out -lstatusboard -pthread -lrt
+fi
+
 cp ./scripts/run.sh ./out
 chmod +x ./out/run.sh
 
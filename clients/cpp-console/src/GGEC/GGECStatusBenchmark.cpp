@@ -0,0 +1,163 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Compares the cost of a status change sent through GGECStatusChannel's socket with the same change sent by
+// running adk-message-send through system(). A stand-in receiver on a local socket and a stand-in
+// adk-message-send script take the place of the device's message bus, so it runs on any Linux machine.
+//
+// usage: statusBenchmark.exe [iterations]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "GGECStatusChannel.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+namespace
+{
+    // Accepts one connection and counts the newline terminated messages that arrive on it.
+    class StandInReceiver
+    {
+    public:
+        explicit StandInReceiver(const string& path)
+        {
+            m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            unlink(path.c_str());
+            if (bind(m_listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listener, 1) != 0)
+            {
+                perror("stand-in receiver");
+                exit(1);
+            }
+            m_thread = thread(&StandInReceiver::Run, this);
+        }
+
+        ~StandInReceiver()
+        {
+            shutdown(m_listener, SHUT_RDWR);
+            close(m_listener);
+            m_thread.join();
+        }
+
+        // Blocks until count messages have arrived in total.
+        void WaitFor(uint64_t count)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_arrived.wait(lock, [this, count] { return m_received >= count; });
+        }
+
+    private:
+        void Run()
+        {
+            int connection = accept(m_listener, nullptr, nullptr);
+            if (connection < 0)
+            {
+                return;
+            }
+            char buffer[256];
+            ssize_t bytes;
+            while ((bytes = read(connection, buffer, sizeof(buffer))) > 0)
+            {
+                uint64_t lines = 0;
+                for (ssize_t i = 0; i < bytes; i++)
+                {
+                    lines += buffer[i] == '\n' ? 1 : 0;
+                }
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_received += lines;
+                }
+                m_arrived.notify_all();
+            }
+            close(connection);
+        }
+
+        int m_listener;
+        thread m_thread;
+        mutex m_mutex;
+        condition_variable m_arrived;
+        uint64_t m_received = 0;
+    };
+
+    void Report(const char* name, const LatencyHistogram& histogram)
+    {
+        printf("%-34s mean %8.1fus  p50 %6lluus  p99 %6lluus  max %6lluus\n", name, histogram.Mean(),
+            (unsigned long long)histogram.Percentile(50.0), (unsigned long long)histogram.Percentile(99.0),
+            (unsigned long long)histogram.Max());
+    }
+
+    const DeviceStatus Cycle[]{ DeviceStatus::Detecting, DeviceStatus::Listening, DeviceStatus::Thinking, DeviceStatus::Speaking };
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 500;
+
+    char directoryTemplate[] = "/tmp/ggecStatusBenchmarkXXXXXX";
+    string directory = mkdtemp(directoryTemplate);
+    string socketPath = directory + "/status.sock";
+
+    // a do-nothing adk-message-send ahead of the real one, so the shell path pays for exactly the process creation
+    string standInSender = directory + "/adk-message-send";
+    {
+        ofstream script(standInSender);
+        script << "#!/bin/sh\nexit 0\n";
+    }
+    chmod(standInSender.c_str(), 0755);
+    string path = directory + ":" + (getenv("PATH") != nullptr ? getenv("PATH") : "");
+    setenv("PATH", path.c_str(), 1);
+
+    LatencyHistogram shell;
+    {
+        GGECStatusChannel channel("");
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = chrono::steady_clock::now();
+            channel.Send(Cycle[i % 4]);
+            shell.Record(chrono::steady_clock::now() - start);
+        }
+    }
+
+    LatencyHistogram socketSend;
+    LatencyHistogram socketDelivered;
+    uint64_t sentOverSocket = 0;
+    {
+        StandInReceiver receiver(socketPath);
+        GGECStatusChannel channel(socketPath);
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = chrono::steady_clock::now();
+            channel.Send(Cycle[i % 4]);
+            socketSend.Record(chrono::steady_clock::now() - start);
+            receiver.WaitFor(i + 1);
+            socketDelivered.Record(chrono::steady_clock::now() - start);
+        }
+        sentOverSocket = channel.SentOverSocket();
+    }
+
+    printf("%d status changes, %llu over the socket\n", iterations, (unsigned long long)sentOverSocket);
+    Report("system(adk-message-send)", shell);
+    Report("socket, Send returns", socketSend);
+    Report("socket, receiver has the message", socketDelivered);
+
+    unlink(socketPath.c_str());
+    unlink(standInSender.c_str());
+    rmdir(directory.c_str());
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "GGECStatusChannel.h"
+#include "log.h"
+
+using namespace std;
+
+namespace
+{
+    // Long enough for a busy receiver, short enough that a wedged one cannot hold up the indicators for long.
+    constexpr int SendTimeoutMs = 50;
+
+    const DeviceStatus AllStatuses[]{ DeviceStatus::Idle, DeviceStatus::Initializing, DeviceStatus::Ready, DeviceStatus::Detecting,
+        DeviceStatus::Listening, DeviceStatus::Thinking, DeviceStatus::Speaking };
+}
+
+constexpr chrono::milliseconds GGECStatusChannel::ReconnectInterval;
+
+GGECStatusChannel::GGECStatusChannel(const string& socketPath)
+{
+    m_socketPath = socketPath;
+    for (auto status : AllStatuses)
+    {
+        string message = MessageFor(status);
+        m_messages.push_back(message + "\n");
+        m_commands.push_back("adk-message-send '" + message + "' >/dev/null");
+    }
+}
+
+GGECStatusChannel::~GGECStatusChannel()
+{
+    Disconnect();
+}
+
+string GGECStatusChannel::MessageFor(DeviceStatus status)
+{
+    switch (status)
+    {
+    case DeviceStatus::Idle:
+        return "voiceui_status_idle {}";
+    case DeviceStatus::Initializing:
+        //red circular
+        return "led_start_pattern {pattern:3}";
+    case DeviceStatus::Ready:
+        //pulse yellow twice
+        return "led_start_pattern {pattern:13}";
+    case DeviceStatus::Detecting:
+        //solid green
+        return "led_start_pattern {pattern:7}";
+    case DeviceStatus::Listening:
+        //blue circular
+        return "led_start_pattern {pattern:0}";
+    case DeviceStatus::Thinking:
+        //pulse purple
+        return "led_start_pattern {pattern:10}";
+    case DeviceStatus::Speaking:
+        return "led_start_pattern {pattern:2}";
+    default:
+        return "";
+    }
+}
+
+int GGECStatusChannel::Send(DeviceStatus status)
+{
+    size_t index = (size_t)status;
+    if (index >= m_messages.size())
+    {
+        return -1;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    if (EnsureConnected())
+    {
+        if (WriteAll(m_messages[index]))
+        {
+            m_sentOverSocket++;
+            return 0;
+        }
+        log_t("GGEC status socket write failed (", strerror(errno), "), falling back to adk-message-send");
+        Disconnect();
+    }
+
+    m_sentThroughShell++;
+    return system(m_commands[index].c_str()) == 0 ? 1 : -1;
+}
+
+bool GGECStatusChannel::EnsureConnected()
+{
+    if (m_socket >= 0)
+    {
+        return true;
+    }
+    if (m_socketPath.empty() || chrono::steady_clock::now() < m_nextConnectAttempt)
+    {
+        return false;
+    }
+    m_nextConnectAttempt = chrono::steady_clock::now() + ReconnectInterval;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(address.sun_path))
+    {
+        log_t("GGEC status socket path is too long: ", m_socketPath);
+        return false;
+    }
+    strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    timeval timeout{ SendTimeoutMs / 1000, (SendTimeoutMs % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (m_everConnected)
+    {
+        m_reconnects++;
+    }
+    m_everConnected = true;
+    m_socket = fd;
+    return true;
+}
+
+bool GGECStatusChannel::WriteAll(const string& message)
+{
+    size_t written = 0;
+    while (written < message.size())
+    {
+        // MSG_NOSIGNAL so a receiver that went away is an error here rather than a SIGPIPE for the process
+        ssize_t result = ::send(m_socket, message.data() + written, message.size() - written, MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        written += (size_t)result;
+    }
+    return true;
+}
+
+void GGECStatusChannel::Disconnect()
+{
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        m_socket = -1;
+    }
+}
+
+GGECStatusChannel& GGECStatusChannel::Default()
+{
+    static GGECStatusChannel channel(getenv("GGEC_STATUS_SOCKET") != nullptr ? getenv("GGEC_STATUS_SOCKET") : "");
+    return channel;
+}
@@ -0,0 +1,238 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Tests GGECStatusChannel against a stand-in receiver on a temporary Unix socket and a stand-in adk-message-send
+// that records what it was asked to send, so it runs on any Linux machine. Exits with 0 when every check passed.
+//
+// usage: statusChannelTests.exe
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "GGECStatusChannel.h"
+
+using namespace std;
+
+namespace
+{
+    int failures = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            printf("  FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Accepts connections one after another and keeps the text that arrives on them.
+    class StandInReceiver
+    {
+    public:
+        explicit StandInReceiver(const string& path)
+        {
+            m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            unlink(path.c_str());
+            if (bind(m_listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listener, 1) != 0)
+            {
+                perror("stand-in receiver");
+                exit(1);
+            }
+            m_path = path;
+            m_thread = thread(&StandInReceiver::Run, this);
+        }
+
+        ~StandInReceiver()
+        {
+            shutdown(m_listener, SHUT_RDWR);
+            close(m_listener);
+            DropConnection();
+            m_thread.join();
+            unlink(m_path.c_str());
+        }
+
+        // Blocks until the text received so far ends with count newlines, or a second has passed.
+        string WaitForLines(size_t count)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_arrived.wait_for(lock, chrono::seconds(1), [&] { return (size_t)std::count(m_text.begin(), m_text.end(), '\n') >= count; });
+            return m_text;
+        }
+
+        // Closes the current connection, as a receiver that restarts would.
+        void DropConnection()
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_connection >= 0)
+            {
+                shutdown(m_connection, SHUT_RDWR);
+            }
+        }
+
+        // The connections accepted so far, once there are count of them or a second has passed.
+        int WaitForConnections(int count)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_arrived.wait_for(lock, chrono::seconds(1), [&] { return m_connections >= count; });
+            return m_connections;
+        }
+
+    private:
+        void Run()
+        {
+            int connection;
+            while ((connection = accept(m_listener, nullptr, nullptr)) >= 0)
+            {
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_connection = connection;
+                    m_connections++;
+                }
+                m_arrived.notify_all();
+                char buffer[256];
+                ssize_t bytes;
+                while ((bytes = read(connection, buffer, sizeof(buffer))) > 0)
+                {
+                    {
+                        lock_guard<mutex> lock(m_mutex);
+                        m_text.append(buffer, (size_t)bytes);
+                    }
+                    m_arrived.notify_all();
+                }
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_connection = -1;
+                }
+                close(connection);
+            }
+        }
+
+        string m_path;
+        int m_listener;
+        thread m_thread;
+        mutex m_mutex;
+        condition_variable m_arrived;
+        string m_text;
+        int m_connection = -1;
+        int m_connections = 0;
+    };
+
+    // What the stand-in adk-message-send has been asked to send, one message per line.
+    string ShellMessages(const string& log)
+    {
+        ifstream in(log);
+        stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    void TestSendsOverTheSocketWhenTheReceiverIsThere(const string& directory, const string& shellLog)
+    {
+        printf("TestSendsOverTheSocketWhenTheReceiverIsThere\n");
+        unlink(shellLog.c_str());
+        string socketPath = directory + "/present.sock";
+        StandInReceiver receiver(socketPath);
+        GGECStatusChannel channel(socketPath);
+
+        Check(channel.Send(DeviceStatus::Listening) == 0, "Send reports the socket");
+        Check(channel.Send(DeviceStatus::Thinking) == 0, "Send reports the socket for the second message");
+        Check(receiver.WaitForLines(2) == "led_start_pattern {pattern:0}\nled_start_pattern {pattern:10}\n", "receiver got both messages");
+        Check(receiver.WaitForConnections(1) == 1, "one connection for both messages");
+        Check(channel.SentOverSocket() == 2, "counted as sent over the socket");
+        Check(channel.SentThroughShell() == 0, "nothing sent through the shell");
+        Check(ShellMessages(shellLog).empty(), "adk-message-send not run");
+    }
+
+    void TestFallsBackWhenNoReceiverIsThere(const string& directory, const string& shellLog)
+    {
+        printf("TestFallsBackWhenNoReceiverIsThere\n");
+        unlink(shellLog.c_str());
+        GGECStatusChannel channel(directory + "/absent.sock");
+
+        Check(channel.Send(DeviceStatus::Speaking) == 1, "Send reports the fallback");
+        Check(ShellMessages(shellLog) == "led_start_pattern {pattern:2}\n", "adk-message-send got the message");
+        Check(channel.SentOverSocket() == 0, "nothing sent over the socket");
+        Check(channel.SentThroughShell() == 1, "counted as sent through the shell");
+    }
+
+    void TestReconnectsAtMostOncePerInterval(const string& directory, const string& shellLog)
+    {
+        printf("TestReconnectsAtMostOncePerInterval\n");
+        unlink(shellLog.c_str());
+        string socketPath = directory + "/late.sock";
+        GGECStatusChannel channel(socketPath);
+
+        // the first send tries to connect and falls back; the receiver that comes up straight after is not tried
+        // again until the interval has passed
+        Check(channel.Send(DeviceStatus::Detecting) == 1, "first send falls back");
+        auto firstAttempt = chrono::steady_clock::now();
+        StandInReceiver receiver(socketPath);
+        Check(channel.Send(DeviceStatus::Listening) == 1, "send within the interval falls back");
+        Check(receiver.WaitForConnections(0) == 0, "no connection within the interval");
+
+        this_thread::sleep_until(firstAttempt + GGECStatusChannel::ReconnectInterval);
+        Check(channel.Send(DeviceStatus::Thinking) == 0, "send after the interval connects");
+        Check(receiver.WaitForLines(1) == "led_start_pattern {pattern:10}\n", "receiver got the message");
+        Check(channel.Reconnects() == 0, "first connection is not a reconnect");
+
+        // a receiver that goes away is noticed on the next write, and reconnecting waits for the interval again
+        auto connected = chrono::steady_clock::now();
+        receiver.DropConnection();
+        Check(channel.Send(DeviceStatus::Speaking) == 1, "send straight after the drop falls back");
+        Check(channel.Send(DeviceStatus::Ready) == 1, "send within the interval of the drop falls back");
+        Check(receiver.WaitForConnections(1) == 1, "no reconnect within the interval");
+
+        this_thread::sleep_until(connected + GGECStatusChannel::ReconnectInterval);
+        Check(channel.Send(DeviceStatus::Idle) == 0, "send after the interval reconnects");
+        Check(receiver.WaitForConnections(2) == 2, "one reconnect");
+        Check(channel.Reconnects() == 1, "counted as a reconnect");
+        Check(channel.SentOverSocket() == 2, "counted as sent over the socket");
+        Check(ShellMessages(shellLog) == "led_start_pattern {pattern:7}\nled_start_pattern {pattern:0}\n"
+            "led_start_pattern {pattern:2}\nled_start_pattern {pattern:13}\n", "the fallbacks went through the shell");
+    }
+}
+
+int main()
+{
+    char directoryTemplate[] = "/tmp/ggecStatusChannelTestsXXXXXX";
+    string directory = mkdtemp(directoryTemplate);
+
+    // an adk-message-send ahead of the real one that appends each message to a log
+    string shellLog = directory + "/sent.log";
+    string standInSender = directory + "/adk-message-send";
+    {
+        ofstream script(standInSender);
+        script << "#!/bin/sh\necho \"$1\" >> '" << shellLog << "'\n";
+    }
+    chmod(standInSender.c_str(), 0755);
+    string path = directory + ":" + (getenv("PATH") != nullptr ? getenv("PATH") : "");
+    setenv("PATH", path.c_str(), 1);
+
+    TestSendsOverTheSocketWhenTheReceiverIsThere(directory, shellLog);
+    TestFallsBackWhenNoReceiverIsThere(directory, shellLog);
+    TestReconnectsAtMostOncePerInterval(directory, shellLog);
+
+    unlink(shellLog.c_str());
+    unlink(standInSender.c_str());
+    rmdir(directory.c_str());
+
+    printf(failures == 0 ? "All checks passed\n" : "%d checks failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,364 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstring>
+#include <utility>
+#include "Activity.h"
+
+// A single forward pass over the top-level object. Values of keys we don't route on are skipped without
+// being decoded or validated; only the strings we keep are unescaped.
+class Activity::FieldExtractor
+{
+public:
+    FieldExtractor(Activity& activity, const std::string& raw) :
+        m_activity(activity),
+        m_position(raw.data()),
+        m_end(raw.data() + raw.size())
+    {
+    }
+
+    // Returns false if the top level of the activity is not a well formed object.
+    bool Extract()
+    {
+        SkipWhitespace();
+        if (!Consume('{'))
+        {
+            return false;
+        }
+
+        SkipWhitespace();
+        if (Consume('}'))
+        {
+            return true;
+        }
+
+        std::string key;
+        while (true)
+        {
+            SkipWhitespace();
+            if (!Consume('"') || !ReadString(key))
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (!Consume(':'))
+            {
+                return false;
+            }
+            SkipWhitespace();
+
+            std::string* target = Target(key);
+            if (target != nullptr && Consume('"'))
+            {
+                if (!ReadString(*target))
+                {
+                    return false;
+                }
+                if (target == &m_activity.m_text)
+                {
+                    m_activity.m_hasText = true;
+                }
+            }
+            else if (!SkipValue())
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (Consume('}'))
+            {
+                return true;
+            }
+            if (!Consume(','))
+            {
+                return false;
+            }
+        }
+    }
+
+private:
+    std::string* Target(const std::string& key)
+    {
+        if (key == "type")
+        {
+            return &m_activity.m_type;
+        }
+        if (key == "id")
+        {
+            return &m_activity.m_id;
+        }
+        if (key == "text")
+        {
+            return &m_activity.m_text;
+        }
+        if (key == "inputHint")
+        {
+            return &m_activity.m_inputHint;
+        }
+        return nullptr;
+    }
+
+    bool Consume(char c)
+    {
+        if (m_position < m_end && *m_position == c)
+        {
+            m_position++;
+            return true;
+        }
+        return false;
+    }
+
+    void SkipWhitespace()
+    {
+        while (m_position < m_end && (*m_position == ' ' || *m_position == '\t' || *m_position == '\n' || *m_position == '\r'))
+        {
+            m_position++;
+        }
+    }
+
+    // Skips the rest of a string whose opening quote has been consumed.
+    bool SkipString()
+    {
+        while (m_position < m_end)
+        {
+            const char* quote = static_cast<const char*>(memchr(m_position, '"', m_end - m_position));
+            if (quote == nullptr)
+            {
+                break;
+            }
+
+            // the quote is escaped if it follows an odd number of backslashes
+            const char* backslash = quote;
+            while (backslash > m_position && backslash[-1] == '\\')
+            {
+                backslash--;
+            }
+            m_position = quote + 1;
+            if ((quote - backslash) % 2 == 0)
+            {
+                return true;
+            }
+        }
+        m_position = m_end;
+        return false;
+    }
+
+    // Skips one value of any type, including nested objects and arrays.
+    bool SkipValue()
+    {
+        int depth = 0;
+        while (m_position < m_end)
+        {
+            char c = *m_position++;
+            switch (c)
+            {
+            case '"':
+                if (!SkipString())
+                {
+                    return false;
+                }
+                break;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0)
+                {
+                    // the end of the enclosing object, leave it for the caller
+                    m_position--;
+                    return true;
+                }
+                depth--;
+                break;
+            case ',':
+                if (depth == 0)
+                {
+                    m_position--;
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+            if (depth == 0 && (c == '"' || c == '}' || c == ']'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static int HexValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool ReadCodeUnit(uint32_t& unit)
+    {
+        if (m_end - m_position < 4)
+        {
+            return false;
+        }
+        unit = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int digit = HexValue(*m_position++);
+            if (digit < 0)
+            {
+                return false;
+            }
+            unit = (unit << 4) | digit;
+        }
+        return true;
+    }
+
+    static void AppendUtf8(std::string& out, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // Reads and unescapes the rest of a string whose opening quote has been consumed.
+    bool ReadString(std::string& out)
+    {
+        out.clear();
+        while (m_position < m_end)
+        {
+            // copy the run up to the next quote or escape in one go
+            const char* run = m_position;
+            while (m_position < m_end && *m_position != '"' && *m_position != '\\')
+            {
+                m_position++;
+            }
+            out.append(run, m_position - run);
+
+            if (m_position == m_end)
+            {
+                return false;
+            }
+            if (*m_position++ == '"')
+            {
+                return true;
+            }
+
+            if (m_position == m_end)
+            {
+                return false;
+            }
+            char escaped = *m_position++;
+            switch (escaped)
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                uint32_t codePoint;
+                if (!ReadCodeUnit(codePoint))
+                {
+                    return false;
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    uint32_t low;
+                    if (!Consume('\\') || !Consume('u') || !ReadCodeUnit(low) || low < 0xDC00 || low > 0xDFFF)
+                    {
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    Activity& m_activity;
+    const char* m_position;
+    const char* m_end;
+};
+
+Activity::Activity(std::string raw, ActivityArena* arena) : m_raw(std::move(raw)), m_arena(arena)
+{
+    FieldExtractor extractor(*this, m_raw);
+    if (!extractor.Extract())
+    {
+        m_type.clear();
+        m_id.clear();
+        m_text.clear();
+        m_inputHint.clear();
+        m_hasText = false;
+    }
+}
+
+Activity::~Activity()
+{
+    // the DOM has to be released while its arena is current
+    if (m_arena != nullptr && m_parsed)
+    {
+        ActivityArena::Scope scope(*m_arena);
+        m_json = nullptr;
+    }
+}
+
+const ActivityJson& Activity::Json()
+{
+    if (!m_parsed)
+    {
+        if (m_arena != nullptr)
+        {
+            ActivityArena::Scope scope(*m_arena);
+            m_json = ActivityJson::parse(m_raw);
+        }
+        else
+        {
+            m_json = ActivityJson::parse(m_raw);
+        }
+        m_parsed = true;
+    }
+    return m_json;
+}
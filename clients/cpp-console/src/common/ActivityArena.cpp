@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include "ActivityArena.h"
+
+namespace
+{
+    thread_local ActivityArena* t_currentArena = nullptr;
+}
+
+ActivityArena::ActivityArena(size_t blockSize)
+{
+    m_blockSize = blockSize;
+    // room for the overflow blocks of a very large activity without growing the vector
+    m_blocks.reserve(16);
+    AddBlock(blockSize);
+}
+
+ActivityArena::~ActivityArena()
+{
+    for (auto& block : m_blocks)
+    {
+        delete[] block.data;
+    }
+}
+
+void ActivityArena::AddBlock(size_t minimumSize)
+{
+    // double the block size each time we overflow so a large activity needs few blocks
+    size_t size = m_blocks.empty() ? m_blockSize : m_blocks.back().size * 2;
+    size = std::max(size, minimumSize);
+    m_blocks.push_back(Block{ new unsigned char[size], size });
+    m_offset = 0;
+    m_blockAllocations++;
+}
+
+void* ActivityArena::Allocate(size_t size, size_t alignment)
+{
+    Block* block = &m_blocks.back();
+    size_t aligned = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size > block->size)
+    {
+        AddBlock(size + alignment);
+        block = &m_blocks.back();
+        aligned = 0;
+    }
+
+    m_offset = aligned + size;
+    m_bytesUsed += size;
+    m_allocations++;
+    return block->data + aligned;
+}
+
+bool ActivityArena::Owns(const void* pointer) const
+{
+    auto p = static_cast<const unsigned char*>(pointer);
+    for (auto& block : m_blocks)
+    {
+        if (p >= block.data && p < block.data + block.size)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ActivityArena::Reset()
+{
+    if (m_blocks.size() > 1)
+    {
+        // replace the overflow chain with one block that fits all of it
+        size_t total = 0;
+        for (auto& block : m_blocks)
+        {
+            total += block.size;
+            delete[] block.data;
+        }
+        m_blocks.clear();
+        m_blockSize = total;
+        AddBlock(total);
+    }
+
+    m_offset = 0;
+    m_bytesUsed = 0;
+    m_allocations = 0;
+}
+
+ActivityArena* ActivityArena::Current()
+{
+    return t_currentArena;
+}
+
+ActivityArena::Scope::Scope(ActivityArena& arena)
+{
+    m_previous = t_currentArena;
+    t_currentArena = &arena;
+}
+
+ActivityArena::Scope::~Scope()
+{
+    t_currentArena = m_previous;
+}
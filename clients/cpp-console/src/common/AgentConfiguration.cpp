@@ -36,6 +36,17 @@ namespace FieldNames
     constexpr auto LogFilePath = "SpeechSDKLogFile";
     constexpr auto CustomMicConfigPath = "CustomMicConfigPath";
     constexpr auto LinuxCaptureDeviceName = "LinuxCaptureDeviceName";
+    constexpr auto TtsRecordingDirectory = "TTSRecordingDirectory";
+    constexpr auto MultiturnLeadTimeMs = "MultiturnLeadTimeMs";
+    constexpr auto KeepAliveIntervalSeconds = "KeepAliveIntervalSeconds";
+    constexpr auto TurnTimelineFile = "TurnTimelineFile";
+    constexpr auto FileInputSpeed = "FileInputSpeed";
+    constexpr auto LocalDialogScript = "LocalDialogScript";
+    constexpr auto StatusCoalesceMs = "StatusCoalesceMs";
+    constexpr auto StatusBoardName = "StatusBoardName";
+    constexpr auto LogLevel = "LogLevel";
+    constexpr auto TraceFile = "TraceFile";
+    constexpr auto TraceTurnThresholdMs = "TraceTurnThresholdMs";
 }
 
 AgentConfiguration::AgentConfiguration() : _loadResult(AgentConfigurationLoadResult::Undefined)
@@ -72,6 +83,32 @@ shared_ptr<AgentConfiguration> AgentConfiguration::LoadFromFile(const string& pa
     config->_linuxCaptureDeviceName = j.value(FieldNames::LinuxCaptureDeviceName, "");
     config->_volume = atoi(j.value(FieldNames::Volume, "").c_str());
     config->_barge_in_supported = j.value(FieldNames::BargeInSupported, "");
+    config->_ttsRecordingDirectory = j.value(FieldNames::TtsRecordingDirectory, "");
+    config->_turnTimelineFile = j.value(FieldNames::TurnTimelineFile, "");
+    config->_localDialogScript = j.value(FieldNames::LocalDialogScript, "");
+    config->_statusBoardName = j.value(FieldNames::StatusBoardName, "");
+    config->_logLevel = j.value(FieldNames::LogLevel, "");
+    config->_traceFile = j.value(FieldNames::TraceFile, "");
+    if (j.contains(FieldNames::MultiturnLeadTimeMs))
+    {
+        config->_multiturnLeadTimeMs = atoi(j.value(FieldNames::MultiturnLeadTimeMs, "").c_str());
+    }
+    if (j.contains(FieldNames::FileInputSpeed))
+    {
+        config->_fileInputSpeed = atof(j.value(FieldNames::FileInputSpeed, "").c_str());
+    }
+    if (j.contains(FieldNames::KeepAliveIntervalSeconds))
+    {
+        config->_keepAliveIntervalSeconds = atoi(j.value(FieldNames::KeepAliveIntervalSeconds, "").c_str());
+    }
+    if (j.contains(FieldNames::StatusCoalesceMs))
+    {
+        config->_statusCoalesceMs = atoi(j.value(FieldNames::StatusCoalesceMs, "").c_str());
+    }
+    if (j.contains(FieldNames::TraceTurnThresholdMs))
+    {
+        config->_traceTurnThresholdMs = atoi(j.value(FieldNames::TraceTurnThresholdMs, "").c_str());
+    }
 
     if (config->_keywordRecognitionModel.length() > 0)
     {
@@ -116,6 +153,12 @@ shared_ptr<AgentConfiguration> AgentConfiguration::LoadFromFile(const string& pa
         }
     }
 
+    if (!config->_localDialogScript.empty() && !std::experimental::filesystem::exists(config->_localDialogScript))
+    {
+        config->_loadResult = AgentConfigurationLoadResult::LocalDialogScriptNotFound;
+        return config;
+    }
+
     if (config->_speechKey.length() == 0)
     {
         config->_loadResult = AgentConfigurationLoadResult::BadSpeechKey;
@@ -160,6 +203,8 @@ std::string AgentConfiguration::LoadMessage()
         return "Region is missing.";
     case AgentConfigurationLoadResult::RegionWithCustom:
         return "Region with custom is found.";
+    case AgentConfigurationLoadResult::LocalDialogScriptNotFound:
+        return "Local dialog script is not found.";
     case AgentConfigurationLoadResult::Undefined:
     default:
         return "Unknown Failure";
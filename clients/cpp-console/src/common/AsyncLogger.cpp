@@ -0,0 +1,311 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "AsyncLogger.h"
+
+using namespace std;
+
+namespace
+{
+    // The writer writes out at least this often while lines keep arriving.
+    constexpr size_t MaxBatchBytes = 64 * 1024;
+
+    // Only a safety net; the writer is woken whenever a line arrives while it sleeps.
+    constexpr chrono::seconds IdleWait{ 1 };
+
+    // After being woken the writer waits this long for the rest of the burst, so a burst of lines costs one
+    // wake up and one write instead of a context switch per line.
+    constexpr chrono::microseconds BatchDelay{ 500 };
+}
+
+constexpr size_t AsyncLogger::DefaultSlotCount;
+constexpr size_t AsyncLogger::InlineBytes;
+
+void LogLine::AppendSigned(long long value)
+{
+    if (value < 0)
+    {
+        m_buffer.push_back('-');
+        // negate as unsigned so the most negative value does not overflow
+        AppendUnsigned(0ull - (unsigned long long)value);
+    }
+    else
+    {
+        AppendUnsigned((unsigned long long)value);
+    }
+}
+
+void LogLine::AppendUnsigned(unsigned long long value)
+{
+    char digits[20];
+    int count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (count > 0)
+    {
+        m_buffer.push_back(digits[--count]);
+    }
+}
+
+void LogLine::AppendTimestamp()
+{
+    static thread_local time_t cachedSecond = -1;
+    static thread_local char cachedTime[9];
+
+    auto now = chrono::system_clock::now();
+    time_t second = chrono::system_clock::to_time_t(now);
+    if (second != cachedSecond)
+    {
+        tm localTime;
+#ifdef LINUX
+        localtime_r(&second, &localTime);
+#endif
+#ifdef WINDOWS
+        localtime_s(&localTime, &second);
+#endif
+        strftime(cachedTime, sizeof(cachedTime), "%H:%M:%S", &localTime);
+        cachedSecond = second;
+    }
+
+    auto milliseconds = chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    m_buffer.append(cachedTime, 8);
+    m_buffer.push_back('.');
+    m_buffer.push_back((char)('0' + milliseconds / 100));
+    m_buffer.push_back((char)('0' + milliseconds / 10 % 10));
+    m_buffer.push_back((char)('0' + milliseconds % 10));
+}
+
+AsyncLogger::AsyncLogger(FILE* output, size_t slotCount) : m_slots(slotCount)
+{
+    m_output = output;
+    m_mask = slotCount - 1;
+    for (size_t i = 0; i < slotCount; i++)
+    {
+        m_slots[i].sequence.store(i, memory_order_relaxed);
+        m_slots[i].heapData = nullptr;
+    }
+    m_writerThread = thread(&AsyncLogger::WriterThreadMain, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    Stop();
+
+    string discarded;
+    while (TryRead(discarded))
+    {
+    }
+}
+
+AsyncLogger& AsyncLogger::Instance()
+{
+    // never destroyed, so lines logged from other static destructors still have somewhere to go
+    static AsyncLogger* logger = []
+    {
+        auto created = new AsyncLogger(stdout);
+        atexit([] { AsyncLogger::Instance().Stop(); });
+        return created;
+    }();
+    return *logger;
+}
+
+LogLine& AsyncLogger::ThreadLine()
+{
+    static thread_local LogLine line;
+    return line;
+}
+
+void AsyncLogger::Write(const char* data, size_t size)
+{
+    if (m_stopping.load(memory_order_relaxed))
+    {
+        lock_guard<mutex> lock(m_syncMutex);
+        fwrite(data, 1, size, m_output);
+        fputc('\n', m_output);
+        fflush(m_output);
+        return;
+    }
+
+    size_t position = m_enqueuePosition.load(memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &m_slots[position & m_mask];
+        size_t sequence = slot->sequence.load(memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0)
+        {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // the writer has not caught up with a full ring; losing the line beats blocking the caller
+            m_dropped++;
+            return;
+        }
+        else
+        {
+            position = m_enqueuePosition.load(memory_order_relaxed);
+        }
+    }
+
+    slot->size = (uint32_t)size;
+    if (size <= InlineBytes)
+    {
+        memcpy(slot->inlineData, data, size);
+    }
+    else
+    {
+        slot->heapData = new char[size];
+        memcpy(slot->heapData, data, size);
+    }
+    // seq_cst with the load below pairs with the writer announcing it is asleep, so the wake cannot be missed
+    slot->sequence.store(position + 1, memory_order_seq_cst);
+
+    // only the first line to find the writer asleep pays for waking it
+    if (m_writerAsleep.load(memory_order_seq_cst) && m_writerAsleep.exchange(false))
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_wake.notify_one();
+    }
+}
+
+bool AsyncLogger::TryRead(string& batch)
+{
+    Slot& slot = m_slots[m_dequeuePosition & m_mask];
+    if (slot.sequence.load(memory_order_seq_cst) != m_dequeuePosition + 1)
+    {
+        return false;
+    }
+
+    if (slot.heapData != nullptr)
+    {
+        batch.append(slot.heapData, slot.size);
+        delete[] slot.heapData;
+        slot.heapData = nullptr;
+    }
+    else
+    {
+        batch.append(slot.inlineData, slot.size);
+    }
+    batch.push_back('\n');
+
+    slot.sequence.store(m_dequeuePosition + m_mask + 1, memory_order_release);
+    m_dequeuePosition++;
+    return true;
+}
+
+void AsyncLogger::WriteOut(const string& batch, uint64_t lines)
+{
+    fwrite(batch.data(), 1, batch.size(), m_output);
+    fflush(m_output);
+    m_written += lines;
+}
+
+void AsyncLogger::WriterThreadMain()
+{
+    string batch;
+    batch.reserve(MaxBatchBytes + 1024);
+
+    while (true)
+    {
+        uint64_t lines = 0;
+        while (batch.size() < MaxBatchBytes && TryRead(batch))
+        {
+            lines++;
+        }
+        if (lines > 0)
+        {
+            WriteOut(batch, lines);
+            batch.clear();
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_writtenPosition = m_dequeuePosition;
+            }
+            m_flushed.notify_all();
+            continue;
+        }
+
+        uint64_t dropped = m_dropped.load();
+        if (dropped != m_droppedReported)
+        {
+            string report = "log: " + to_string(dropped - m_droppedReported) + " lines dropped, the log could not keep up\n";
+            WriteOut(report, 0);
+            m_droppedReported = dropped;
+        }
+
+        unique_lock<mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_writerAsleep.store(true, memory_order_seq_cst);
+        // a line published before the flag went up is seen here; one published after it wakes us
+        Slot& next = m_slots[m_dequeuePosition & m_mask];
+        bool waited = next.sequence.load(memory_order_seq_cst) != m_dequeuePosition + 1;
+        if (waited)
+        {
+            m_wake.wait_for(lock, IdleWait);
+        }
+        m_writerAsleep.store(false, memory_order_relaxed);
+        lock.unlock();
+
+        if (waited && !m_stopping && !m_flushRequested)
+        {
+            this_thread::sleep_for(BatchDelay);
+        }
+    }
+}
+
+void AsyncLogger::Flush()
+{
+    size_t target = m_enqueuePosition.load();
+    unique_lock<mutex> lock(m_mutex);
+    m_flushRequested = true;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [this, target] { return m_writtenPosition >= target || m_stopped; });
+    m_flushRequested = false;
+}
+
+void AsyncLogger::Stop()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_stopping)
+        {
+            return;
+        }
+        m_stopping = true;
+        m_wake.notify_one();
+    }
+    m_writerThread.join();
+
+    // lines that raced with the writer's last look
+    string rest;
+    uint64_t lines = 0;
+    while (TryRead(rest))
+    {
+        lines++;
+    }
+    if (lines > 0)
+    {
+        WriteOut(rest, lines);
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_flushed.notify_all();
+}
@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <utility>
+#include "AudioBufferPool.h"
+
+using namespace AudioPlayer;
+
+PooledBuffer::PooledBuffer(AudioBufferPool* pool, unsigned char* data, size_t capacity)
+{
+    m_pool = pool;
+    m_data = data;
+    m_capacity = capacity;
+    m_size = 0;
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        m_pool = other.m_pool;
+        m_data = other.m_data;
+        m_capacity = other.m_capacity;
+        m_size = other.m_size;
+        other.m_pool = nullptr;
+        other.m_data = nullptr;
+        other.m_capacity = 0;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+PooledBuffer::~PooledBuffer()
+{
+    Reset();
+}
+
+void PooledBuffer::Reset()
+{
+    if (m_data != nullptr)
+    {
+        if (m_pool != nullptr)
+        {
+            m_pool->Release(m_data);
+        }
+        else
+        {
+            delete[] m_data;
+        }
+    }
+    m_pool = nullptr;
+    m_data = nullptr;
+    m_capacity = 0;
+    m_size = 0;
+}
+
+AudioBufferPool::AudioBufferPool(size_t blockSize, size_t blockCount)
+{
+    m_blockSize = blockSize;
+    m_blockCount = blockCount;
+    m_slab = new unsigned char[blockSize * blockCount];
+
+    // reserve up front so that releasing a block never grows the vector
+    m_freeBlocks.reserve(blockCount);
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        m_freeBlocks.push_back(m_slab + (i * blockSize));
+    }
+}
+
+AudioBufferPool::~AudioBufferPool()
+{
+    delete[] m_slab;
+}
+
+PooledBuffer AudioBufferPool::Acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_freeBlocks.empty())
+        {
+            unsigned char* block = m_freeBlocks.back();
+            m_freeBlocks.pop_back();
+            return PooledBuffer(this, block, m_blockSize);
+        }
+    }
+
+    m_fallbackAllocations++;
+    return AllocateFromHeap(m_blockSize);
+}
+
+void AudioBufferPool::Release(unsigned char* data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeBlocks.push_back(data);
+}
+
+size_t AudioBufferPool::Available()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_freeBlocks.size();
+}
+
+PooledBuffer AudioBufferPool::AllocateFromHeap(size_t size)
+{
+    return PooledBuffer(nullptr, new unsigned char[size], size);
+}
+
+AudioBufferPool& AudioBufferPool::PeriodPool()
+{
+    // never destroyed, so threads still running at exit can keep using and releasing blocks
+    static AudioBufferPool* pool = new AudioBufferPool(PeriodBlockSize, PeriodBlockCount);
+    return *pool;
+}
+
+AudioBufferPool& AudioBufferPool::ChunkPool()
+{
+    static AudioBufferPool* pool = new AudioBufferPool(ChunkBlockSize, ChunkBlockCount);
+    return *pool;
+}
+
+PooledBuffer AudioBufferPool::AcquireAudioBuffer(size_t size)
+{
+    if (size <= PeriodBlockSize)
+    {
+        return PeriodPool().Acquire();
+    }
+    if (size <= ChunkBlockSize)
+    {
+        return ChunkPool().Acquire();
+    }
+
+    // larger than any block we pool; count it against the chunk pool so it is visible
+    ChunkPool().m_fallbackAllocations++;
+    return AllocateFromHeap(size);
+}
@@ -0,0 +1,189 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cmath>
+#include <cstring>
+#include "AudioConverter.h"
+
+namespace
+{
+    constexpr size_t FilterTapCount = 31;
+    constexpr double Pi = 3.14159265358979323846;
+}
+
+AudioConverter::AudioConverter(const WavFile::WavFormat& inputFormat, uint32_t outputSamplesPerSecond)
+{
+    m_inputFormat = inputFormat;
+    m_outputSamplesPerSecond = outputSamplesPerSecond;
+    m_bytesPerSample = inputFormat.bitsPerSample / 8;
+    m_step = (double)inputFormat.samplesPerSecond / outputSamplesPerSecond;
+    m_partialFrame.reserve(inputFormat.blockAlign);
+
+    if (inputFormat.samplesPerSecond > outputSamplesPerSecond)
+    {
+        // Hann windowed sinc low-pass just below the output Nyquist frequency
+        double cutoff = 0.45 / m_step;
+        double sum = 0.0;
+        m_filterTaps.resize(FilterTapCount);
+        for (size_t i = 0; i < FilterTapCount; i++)
+        {
+            double n = (double)i - (FilterTapCount - 1) / 2.0;
+            double sinc = n == 0.0 ? 2.0 * cutoff : sin(2.0 * Pi * cutoff * n) / (Pi * n);
+            double window = 0.5 - 0.5 * cos(2.0 * Pi * i / (FilterTapCount - 1));
+            m_filterTaps[i] = (float)(sinc * window);
+            sum += m_filterTaps[i];
+        }
+        for (auto& tap : m_filterTaps)
+        {
+            tap = (float)(tap / sum);
+        }
+        m_filterHistory.assign(FilterTapCount, 0.0f);
+    }
+}
+
+bool AudioConverter::IsSupported(const WavFile::WavFormat& inputFormat)
+{
+    if (inputFormat.channels == 0 || inputFormat.samplesPerSecond == 0 ||
+        inputFormat.blockAlign != inputFormat.channels * (inputFormat.bitsPerSample / 8))
+    {
+        return false;
+    }
+
+    switch (inputFormat.formatTag)
+    {
+    case WavFile::FormatPcm:
+        return inputFormat.bitsPerSample == 8 || inputFormat.bitsPerSample == 16 ||
+            inputFormat.bitsPerSample == 24 || inputFormat.bitsPerSample == 32;
+    case WavFile::FormatIeeeFloat:
+        return inputFormat.bitsPerSample == 32;
+    default:
+        return false;
+    }
+}
+
+bool AudioConverter::NeedsConversion(const WavFile::WavFormat& inputFormat, uint32_t outputSamplesPerSecond)
+{
+    return inputFormat.formatTag != WavFile::FormatPcm ||
+        inputFormat.channels != 1 ||
+        inputFormat.bitsPerSample != 16 ||
+        inputFormat.samplesPerSecond != outputSamplesPerSecond;
+}
+
+double AudioConverter::InputSeconds() const
+{
+    return (double)m_framesConsumed / m_inputFormat.samplesPerSecond;
+}
+
+float AudioConverter::DecodeSample(const unsigned char* sample) const
+{
+    switch (m_bytesPerSample)
+    {
+    case 1:
+        // 8 bit wav data is unsigned
+        return ((int)sample[0] - 128) / 128.0f;
+    case 2:
+        return (int16_t)(sample[0] | (sample[1] << 8)) / 32768.0f;
+    case 3:
+        return (int32_t)(((uint32_t)sample[0] << 8) | ((uint32_t)sample[1] << 16) | ((uint32_t)sample[2] << 24)) / 2147483648.0f;
+    case 4:
+    default:
+    {
+        uint32_t bits = (uint32_t)sample[0] | ((uint32_t)sample[1] << 8) | ((uint32_t)sample[2] << 16) | ((uint32_t)sample[3] << 24);
+        if (m_inputFormat.formatTag == WavFile::FormatIeeeFloat)
+        {
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        return (int32_t)bits / 2147483648.0f;
+    }
+    }
+}
+
+float AudioConverter::Filter(float sample)
+{
+    if (m_filterTaps.empty())
+    {
+        return sample;
+    }
+
+    m_filterHistory[m_filterPosition] = sample;
+    float result = 0.0f;
+    size_t index = m_filterPosition;
+    for (size_t i = 0; i < FilterTapCount; i++)
+    {
+        result += m_filterTaps[i] * m_filterHistory[index];
+        index = index == 0 ? FilterTapCount - 1 : index - 1;
+    }
+    m_filterPosition = (m_filterPosition + 1) % FilterTapCount;
+    return result;
+}
+
+void AudioConverter::Resample(float sample, std::vector<int16_t>& output)
+{
+    if (!m_havePreviousSample)
+    {
+        m_previousSample = sample;
+        m_havePreviousSample = true;
+        return;
+    }
+
+    // emit every output sample that falls between the previous input sample and this one
+    while (m_position < 1.0)
+    {
+        float value = m_previousSample + (float)m_position * (sample - m_previousSample);
+        value = value > 1.0f ? 1.0f : (value < -1.0f ? -1.0f : value);
+        output.push_back((int16_t)lrintf(value * 32767.0f));
+        m_position += m_step;
+    }
+    m_position -= 1.0;
+    m_previousSample = sample;
+}
+
+size_t AudioConverter::Convert(const unsigned char* input, size_t inputSize, std::vector<int16_t>& output)
+{
+    size_t startSize = output.size();
+    size_t frameSize = m_inputFormat.blockAlign;
+
+    auto convertFrame = [&](const unsigned char* frame)
+    {
+        float mixed = 0.0f;
+        for (uint16_t channel = 0; channel < m_inputFormat.channels; channel++)
+        {
+            mixed += DecodeSample(frame + channel * m_bytesPerSample);
+        }
+        mixed /= m_inputFormat.channels;
+        Resample(Filter(mixed), output);
+        m_framesConsumed++;
+    };
+
+    // finish a frame left over from the previous call
+    if (!m_partialFrame.empty())
+    {
+        size_t needed = frameSize - m_partialFrame.size();
+        size_t take = needed < inputSize ? needed : inputSize;
+        m_partialFrame.insert(m_partialFrame.end(), input, input + take);
+        input += take;
+        inputSize -= take;
+        if (m_partialFrame.size() < frameSize)
+        {
+            return 0;
+        }
+        convertFrame(m_partialFrame.data());
+        m_partialFrame.clear();
+    }
+
+    size_t frames = inputSize / frameSize;
+    for (size_t i = 0; i < frames; i++)
+    {
+        convertFrame(input + i * frameSize);
+    }
+
+    size_t remainder = inputSize % frameSize;
+    if (remainder > 0)
+    {
+        m_partialFrame.assign(input + frames * frameSize, input + inputSize);
+    }
+
+    return output.size() - startSize;
+}
@@ -3,6 +3,7 @@
 
 #include <cstring>
 #include <memory>
+#include <utility>
 #include "AudioPlayerEntry.h"
 #include "AudioPlayerStream.h"
 
@@ -13,15 +14,149 @@ AudioPlayerEntry::AudioPlayerEntry(unsigned char* pData, size_t pSize)
 {
     m_entryType = PlayerEntryType::BYTE_ARRAY;
     m_size = pSize;
-    m_data = (unsigned char*)malloc(pSize);
+    m_data = AudioBufferPool::AcquireAudioBuffer(pSize);
     if (m_data)
     {
-        memcpy(m_data, pData, pSize);
+        memcpy(m_data.Data(), pData, pSize);
+        m_data.SetSize(pSize);
     }
 };
 
 AudioPlayerEntry::AudioPlayerEntry(std::shared_ptr<IAudioPlayerStream> pStream)
 {
     m_entryType = PlayerEntryType::PULL_AUDIO_OUTPUT_STREAM;
+    m_size = 0;
     m_audioPlayerStream = pStream;
-};
\ No newline at end of file
+};
+
+AudioPlayerEntry::AudioPlayerEntry(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, std::function<void(bool)> onPlaybackEnding,
+    std::function<void(std::chrono::steady_clock::time_point)> onPlaybackStarted)
+    : AudioPlayerEntry(pStream)
+{
+    m_leadTime = leadTime;
+    m_onPlaybackEnding = onPlaybackEnding;
+    m_onPlaybackStarted = onPlaybackStarted;
+};
+
+void AudioPlayerEntry::Reset()
+{
+    NotifyPlaybackEnding(true);
+    // a stream that never reached the device has nothing to report as started
+    m_onPlaybackStarted = nullptr;
+    m_leadTime = std::chrono::milliseconds(0);
+    m_audioPlayerStream.reset();
+    m_data.Reset();
+    m_size = 0;
+}
+
+void AudioPlayerEntry::NotifyPlaybackEnding(bool canceled)
+{
+    if (m_onPlaybackEnding)
+    {
+        // clear the callback before invoking it so it can only ever run once
+        std::function<void(bool)> callback = std::move(m_onPlaybackEnding);
+        m_onPlaybackEnding = nullptr;
+        callback(canceled);
+    }
+}
+
+void AudioPlayerEntry::NotifyPlaybackStarted(std::chrono::steady_clock::time_point audibleAt)
+{
+    if (m_onPlaybackStarted)
+    {
+        std::function<void(std::chrono::steady_clock::time_point)> callback = std::move(m_onPlaybackStarted);
+        m_onPlaybackStarted = nullptr;
+        callback(audibleAt);
+    }
+}
+
+void AudioPlayerEntryQueue::Push(AudioPlayerEntry&& entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.empty())
+    {
+        m_queue.push_back(std::move(entry));
+    }
+    else
+    {
+        m_free.front() = std::move(entry);
+        m_queue.splice(m_queue.end(), m_free, m_free.begin());
+    }
+}
+
+AudioPlayerEntry* AudioPlayerEntryQueue::BeginNext()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty())
+    {
+        return nullptr;
+    }
+    m_current.splice(m_current.end(), m_queue, m_queue.begin());
+    return &m_current.back();
+}
+
+void AudioPlayerEntryQueue::EndCurrent()
+{
+    // only the player thread touches the current entry, so it can be reset without holding the lock
+    if (!m_current.empty())
+    {
+        m_current.front().Reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.splice(m_free.end(), m_current, m_current.begin());
+    }
+}
+
+void AudioPlayerEntryQueue::Clear()
+{
+    std::list<AudioPlayerEntry> cleared;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cleared.splice(cleared.end(), m_queue);
+    }
+
+    // reset outside the lock, canceled playback ending callbacks may queue more audio
+    for (auto& entry : cleared)
+    {
+        if (entry.m_audioPlayerStream)
+        {
+            // someone else may still hold the stream, so stop it reading ahead audio nobody will play
+            entry.m_audioPlayerStream->Discard();
+        }
+        entry.Reset();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.splice(m_free.end(), cleared);
+}
+
+bool AudioPlayerEntryQueue::Empty()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.empty();
+}
+
+void BargeInSignal::Post(SilentCallback onSilent)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (onSilent)
+    {
+        m_callbacks.push_back(std::move(onSilent));
+    }
+    m_pending.store(true, std::memory_order_release);
+}
+
+void BargeInSignal::Complete(bool wasAudible)
+{
+    auto silentAt = std::chrono::steady_clock::now();
+    std::vector<SilentCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        callbacks.swap(m_callbacks);
+        m_pending.store(false, std::memory_order_release);
+    }
+
+    for (auto& callback : callbacks)
+    {
+        callback(silentAt, wasAudible);
+    }
+}
@@ -1,20 +1,113 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
 #include "AudioPlayerStreamImpl.h"
 
 using namespace AudioPlayer;
 
+constexpr size_t AudioPlayerStreamImpl::PrefetchCapacity;
+
 AudioPlayerStreamImpl::AudioPlayerStreamImpl(std::shared_ptr<Audio::PullAudioOutputStream> pStream)
+    : AudioPlayerStreamImpl([pStream](uint8_t* buffer, uint32_t size) { return pStream->Read(buffer, size); })
+{
+}
+
+AudioPlayerStreamImpl::AudioPlayerStreamImpl(PullSource source)
 {
-    m_pullStream = pStream;
     m_streamType = AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM;
+
+    m_prefetch = std::make_shared<PrefetchBuffer>();
+    m_prefetch->ring.reset(new unsigned char[PrefetchCapacity]);
+    std::thread(&AudioPlayerStreamImpl::PrefetchThreadMain, std::move(source), m_prefetch).detach();
 }
 
 AudioPlayerStreamImpl::AudioPlayerStreamImpl(std::shared_ptr<fstream> fStream)
 {
     m_fStream = fStream;
     m_streamType = AudioPlayerStreamType::FSTREAM;
+
+    // the caller may already have skipped a header so only count what is left from here
+    std::streampos start = m_fStream->tellg();
+    m_fStream->seekg(0, ios_base::end);
+    m_fileRemaining = m_fStream->tellg() - start;
+    m_fStream->seekg(start);
+}
+
+AudioPlayerStreamImpl::~AudioPlayerStreamImpl()
+{
+    if (m_prefetch != nullptr)
+    {
+        // the prefetch thread may be blocked in the SDK, so let it finish on its own
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        m_prefetch->abandoned = true;
+        m_prefetch->readyCallback = nullptr;
+        m_prefetch->spaceReady.notify_all();
+    }
+}
+
+void AudioPlayerStreamImpl::PrefetchThreadMain(PullSource source, std::shared_ptr<PrefetchBuffer> prefetch)
+{
+    const size_t capacity = PrefetchCapacity;
+    while (true)
+    {
+        size_t tail;
+        size_t contiguous;
+        {
+            std::unique_lock<std::mutex> lock(prefetch->mutex);
+            prefetch->spaceReady.wait(lock, [&] { return prefetch->abandoned || prefetch->count < capacity; });
+            if (prefetch->abandoned)
+            {
+                return;
+            }
+            tail = (prefetch->head + prefetch->count) % capacity;
+            contiguous = (tail >= prefetch->head) ? capacity - tail : prefetch->head - tail;
+            contiguous = std::min(contiguous, capacity - prefetch->count);
+        }
+
+        // only this thread writes to the free part of the ring so the SDK can fill it without holding the lock
+        uint32_t bytesRead = source(prefetch->ring.get() + tail, (uint32_t)contiguous);
+
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(prefetch->mutex);
+            if (prefetch->abandoned)
+            {
+                // discarded while we were in the SDK, what we just read is not wanted
+                return;
+            }
+            if (bytesRead == 0)
+            {
+                prefetch->endOfStream = true;
+            }
+            prefetch->count += bytesRead;
+            callback = prefetch->readyCallback;
+        }
+        prefetch->dataReady.notify_all();
+        if (callback)
+        {
+            callback();
+        }
+        if (bytesRead == 0)
+        {
+            return;
+        }
+    }
+}
+
+size_t AudioPlayerStreamImpl::CopyFromRing(PrefetchBuffer& prefetch, unsigned char* buffer, size_t bufferSize)
+{
+    const size_t capacity = PrefetchCapacity;
+    size_t toCopy = std::min(bufferSize, prefetch.count);
+    size_t first = std::min(toCopy, capacity - prefetch.head);
+    memcpy(buffer, prefetch.ring.get() + prefetch.head, first);
+    memcpy(buffer + first, prefetch.ring.get(), toCopy - first);
+    prefetch.head = (prefetch.head + toCopy) % capacity;
+    prefetch.count -= toCopy;
+    prefetch.spaceReady.notify_one();
+    return toCopy;
 }
 
 unsigned int AudioPlayerStreamImpl::Read(unsigned char* buffer, size_t bufferSize)
@@ -22,15 +115,126 @@ unsigned int AudioPlayerStreamImpl::Read(unsigned char* buffer, size_t bufferSiz
     switch (m_streamType)
     {
     case AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM:
-       return m_pullStream->Read(buffer, (uint32_t)bufferSize);
+    {
+        size_t total = 0;
+        std::unique_lock<std::mutex> lock(m_prefetch->mutex);
+        while (total < bufferSize)
+        {
+            m_prefetch->dataReady.wait(lock, [&] { return m_prefetch->count > 0 || m_prefetch->endOfStream; });
+            if (m_prefetch->count == 0)
+            {
+                break;
+            }
+            total += CopyFromRing(*m_prefetch, buffer + total, bufferSize - total);
+        }
+        return (unsigned int)total;
+    }
     case AudioPlayerStreamType::FSTREAM:
-        if (m_fStream->eof())
+        if (m_fStream->eof() || m_fileRemaining == 0)
         {
             return 0;
         }
         m_fStream->read((char*)buffer, (uint32_t)bufferSize);
         std::streamsize numberOfBytes = m_fStream->gcount();
+        m_fileRemaining -= std::min(numberOfBytes, m_fileRemaining);
         return (unsigned int)numberOfBytes;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+unsigned int AudioPlayerStreamImpl::TryRead(unsigned char* buffer, size_t bufferSize)
+{
+    switch (m_streamType)
+    {
+    case AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM:
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        return (unsigned int)CopyFromRing(*m_prefetch, buffer, bufferSize);
+    }
+    case AudioPlayerStreamType::FSTREAM:
+        // local files never block for long so a regular read is fine here
+        return Read(buffer, bufferSize);
+    }
+    return 0;
+}
+
+size_t AudioPlayerStreamImpl::Available()
+{
+    switch (m_streamType)
+    {
+    case AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM:
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        return m_prefetch->count;
+    }
+    case AudioPlayerStreamType::FSTREAM:
+        return (size_t)m_fileRemaining;
+    }
+    return 0;
+}
+
+bool AudioPlayerStreamImpl::IsEndOfStream()
+{
+    switch (m_streamType)
+    {
+    case AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM:
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        return m_prefetch->endOfStream && m_prefetch->count == 0;
+    }
+    case AudioPlayerStreamType::FSTREAM:
+        return m_fileRemaining == 0 || m_fStream->eof();
+    }
+    return true;
+}
+
+bool AudioPlayerStreamImpl::IsFullyBuffered()
+{
+    switch (m_streamType)
+    {
+    case AudioPlayerStreamType::PULL_AUDIO_OUTPUT_STREAM:
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        return m_prefetch->endOfStream;
+    }
+    case AudioPlayerStreamType::FSTREAM:
+        return true;
+    }
+    return true;
+}
+
+void AudioPlayerStreamImpl::SetReadyCallback(std::function<void()> callback)
+{
+    bool ready = true;
+    if (m_prefetch != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        m_prefetch->readyCallback = callback;
+        ready = m_prefetch->count > 0 || m_prefetch->endOfStream;
+    }
+
+    // files are always ready; pull streams may already have data buffered
+    if (callback && ready)
+    {
+        callback();
+    }
+}
+
+void AudioPlayerStreamImpl::Discard()
+{
+    if (m_prefetch != nullptr)
+    {
+        // stop the prefetch thread at its next read and drop what it has already fetched
+        std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+        m_prefetch->abandoned = true;
+        m_prefetch->endOfStream = true;
+        m_prefetch->count = 0;
+        m_prefetch->readyCallback = nullptr;
+        m_prefetch->spaceReady.notify_all();
+        m_prefetch->dataReady.notify_all();
+    }
+    else if (m_fStream != nullptr)
+    {
+        m_fileRemaining = 0;
+    }
+}
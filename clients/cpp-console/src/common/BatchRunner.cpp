@@ -0,0 +1,431 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <algorithm>
+#include <condition_variable>
+#include <experimental/filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "log.h"
+#include "AudioConverter.h"
+#include "BatchRunner.h"
+#include "LocalDialogService.h"
+#include "MappedAudioPlayerStream.h"
+#include "PushPacer.h"
+#include "SpeechDialogService.h"
+#include "speechapi_cxx.h"
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+using namespace std;
+using namespace Microsoft::CognitiveServices::Speech;
+using namespace Microsoft::CognitiveServices::Speech::Audio;
+using namespace Microsoft::CognitiveServices::Speech::Dialog;
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+    double Milliseconds(chrono::steady_clock::duration duration)
+    {
+        return chrono::duration<double, milli>(duration).count();
+    }
+
+    bool HasTime(chrono::steady_clock::time_point time)
+    {
+        return time.time_since_epoch().count() != 0;
+    }
+
+    /// <summary>
+    /// Collects what a dialog service reports for one utterance.
+    /// </summary>
+    class TurnCollector
+    {
+    public:
+        explicit TurnCollector(chrono::milliseconds activityGrace) : m_activityGrace(activityGrace)
+        {
+        }
+
+        DialogServiceHandlers Handlers()
+        {
+            DialogServiceHandlers handlers;
+            handlers.recognized = [this](ResultReason reason, const string& text)
+            {
+                if (reason == ResultReason::RecognizedSpeech)
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_text = text;
+                    m_recognized = chrono::steady_clock::now();
+                }
+            };
+            handlers.activityReceived = [this](const string& activity, shared_ptr<IAudioPlayerStream>)
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_lastActivity = chrono::steady_clock::now();
+                if (m_activities.empty())
+                {
+                    m_firstActivity = m_lastActivity;
+                }
+                m_activities.push_back(activity);
+                m_changed.notify_all();
+            };
+            handlers.canceled = [this](CancellationReason reason, const string& errorDetails)
+            {
+                if (reason == CancellationReason::Error)
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_error = errorDetails;
+                    m_changed.notify_all();
+                }
+            };
+            handlers.sessionStopped = [this](const string&)
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_stopped = chrono::steady_clock::now();
+                m_changed.notify_all();
+            };
+            return handlers;
+        }
+
+        // Waits for the turn to finish and fills in the recognition, activity and error fields of result.
+        // Returns false if the session did not stop before the timeout.
+        bool Wait(BatchResult& result, chrono::milliseconds timeout)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            auto deadline = chrono::steady_clock::now() + timeout;
+            while (m_error.empty())
+            {
+                // A bot may answer with several activities, some of them after the session stops, so the turn
+                // is over once the session has stopped and no activity has come for the grace period.
+                auto now = chrono::steady_clock::now();
+                auto wakeAt = deadline;
+                if (HasTime(m_stopped))
+                {
+                    auto quietAt = max(m_stopped, m_lastActivity) + m_activityGrace;
+                    if (now >= quietAt || now >= deadline)
+                    {
+                        break;
+                    }
+                    wakeAt = min(wakeAt, quietAt);
+                }
+                else if (now >= deadline)
+                {
+                    break;
+                }
+                m_changed.wait_until(lock, wakeAt);
+            }
+            bool done = !m_error.empty() || HasTime(m_stopped);
+
+            result.recognizedText = m_text;
+            result.recognized = m_recognized;
+            result.activities = m_activities;
+            result.firstActivity = m_firstActivity;
+            result.error = m_error;
+            return done;
+        }
+
+    private:
+        chrono::milliseconds m_activityGrace;
+        mutex m_mutex;
+        condition_variable m_changed;
+        string m_text;
+        vector<string> m_activities;
+        string m_error;
+        chrono::steady_clock::time_point m_recognized;
+        chrono::steady_clock::time_point m_firstActivity;
+        chrono::steady_clock::time_point m_lastActivity;
+        chrono::steady_clock::time_point m_stopped;
+    };
+}
+
+BatchRunner::BatchRunner(shared_ptr<AgentConfiguration> agentConfig, Options options)
+{
+    m_agentConfig = agentConfig;
+    m_options = options;
+    if (m_options.concurrency == 0)
+    {
+        m_options.concurrency = 1;
+    }
+}
+
+vector<string> BatchRunner::LoadInputs(const string& directoryOrManifest)
+{
+    vector<string> inputs;
+    fs::path source(directoryOrManifest);
+
+    if (fs::is_directory(source))
+    {
+        for (auto& entry : fs::directory_iterator(source))
+        {
+            string extension = entry.path().extension().string();
+            transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (fs::is_regular_file(entry.path()) && extension == ".wav")
+            {
+                inputs.push_back(entry.path().string());
+            }
+        }
+        sort(inputs.begin(), inputs.end());
+        return inputs;
+    }
+
+    ifstream manifest(directoryOrManifest);
+    string line;
+    while (getline(manifest, line))
+    {
+        // tolerate manifests written on Windows
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t") - first + 1);
+
+        fs::path input(line);
+        if (input.is_relative())
+        {
+            input = source.parent_path() / input;
+        }
+        inputs.push_back(input.string());
+    }
+    return inputs;
+}
+
+size_t BatchRunner::Run(const vector<string>& inputs)
+{
+    m_results.clear();
+    m_results.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        m_results[i].path = inputs[i];
+    }
+    m_next = 0;
+    m_failures = 0;
+    m_recognitionLatency.Reset();
+    m_activityLatency.Reset();
+
+    size_t workerCount = min(m_options.concurrency, max<size_t>(inputs.size(), 1));
+    log_t("Running ", inputs.size(), " utterance(s) on ", workerCount, " ", m_options.local ? "local" : "service", " session(s)");
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&BatchRunner::WorkerMain, this);
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    Report(chrono::steady_clock::now() - start);
+    if (!m_options.resultsPath.empty())
+    {
+        WriteResults();
+    }
+    return m_failures;
+}
+
+unique_ptr<IDialogService> BatchRunner::CreateService(const string& path)
+{
+    if (!m_options.local)
+    {
+        auto pushStream = AudioInputStream::CreatePushStream();
+        auto connector = DialogServiceConnector::FromConfig(m_agentConfig->CreateDialogServiceConfig(), AudioConfig::FromStreamInput(pushStream));
+        return make_unique<SpeechDialogService>(connector, pushStream);
+    }
+
+    if (!m_agentConfig->_localDialogScript.empty())
+    {
+        return LocalDialogService::FromScriptFile(m_agentConfig->_localDialogScript, true);
+    }
+
+    LocalDialogService::Script script;
+    script.recognizedDelay = m_options.localResponseDelay;
+    LocalDialogService::Turn turn;
+    turn.text = fs::path(path).stem().string();
+    turn.reply = "You said " + turn.text;
+    script.turns.push_back(turn);
+    return make_unique<LocalDialogService>(script, true);
+}
+
+void BatchRunner::WorkerMain()
+{
+    size_t index;
+    while ((index = m_next++) < m_results.size())
+    {
+        BatchResult& result = m_results[index];
+        RunUtterance(result);
+
+        if (result.error.empty())
+        {
+            if (HasTime(result.recognized))
+            {
+                m_recognitionLatency.Record(max(result.recognized, result.audioEnd) - result.audioEnd);
+            }
+            if (HasTime(result.firstActivity))
+            {
+                m_activityLatency.Record(max(result.firstActivity, result.audioEnd) - result.audioEnd);
+            }
+        }
+        else
+        {
+            m_failures++;
+            log_t("Utterance ", result.path, " failed: ", result.error);
+        }
+    }
+}
+
+void BatchRunner::RunUtterance(BatchResult& result)
+{
+    result.started = chrono::steady_clock::now();
+
+    AudioPlayer::MappedAudioPlayerStream input(result.path);
+    if (!input.IsValid())
+    {
+        result.error = "could not read a WAV file";
+        result.finished = chrono::steady_clock::now();
+        return;
+    }
+
+    const WavFile::WavFormat& format = input.Format();
+    unique_ptr<AudioConverter> converter;
+    if (AudioConverter::NeedsConversion(format))
+    {
+        if (!AudioConverter::IsSupported(format))
+        {
+            result.error = "unsupported audio format";
+            result.finished = chrono::steady_clock::now();
+            return;
+        }
+        converter = make_unique<AudioConverter>(format);
+    }
+
+    unique_ptr<IDialogService> service = CreateService(result.path);
+    if (!service)
+    {
+        result.error = "could not create the dialog service";
+        result.finished = chrono::steady_clock::now();
+        return;
+    }
+    TurnCollector collector(m_options.activityGrace);
+    service->SetHandlers(collector.Handlers());
+    service->Connect();
+    service->ListenOnce();
+
+    // slices come straight out of the mapping, so only converted audio is ever copied
+    uint32_t inputBytesPerChunk = PushPacer::InputBytesPerChunk(format);
+    PushPacer pacer(m_agentConfig->_fileInputSpeed);
+    vector<int16_t> converted;
+
+    const unsigned char* slice;
+    unsigned int sliceSize;
+    while ((sliceSize = input.ReadSlice(&slice, inputBytesPerChunk)) > 0)
+    {
+        const uint8_t* output = slice;
+        uint32_t outputSize = sliceSize;
+        if (converter)
+        {
+            converted.clear();
+            converter->Convert(slice, sliceSize, converted);
+            output = (const uint8_t*)converted.data();
+            outputSize = (uint32_t)(converted.size() * sizeof(int16_t));
+        }
+
+        pacer.WaitForNextChunk();
+        service->WriteAudio(output, outputSize);
+        pacer.Pushed(outputSize);
+    }
+    service->CloseAudio();
+    result.audioEnd = chrono::steady_clock::now();
+    result.audioSeconds = pacer.AudioSeconds();
+
+    if (!collector.Wait(result, m_options.turnTimeout) && result.error.empty())
+    {
+        result.error = "timed out waiting for the turn to finish";
+    }
+    service->SetHandlers(DialogServiceHandlers());
+    service.reset();
+    result.finished = chrono::steady_clock::now();
+}
+
+void BatchRunner::Report(chrono::steady_clock::duration elapsed)
+{
+    double wallSeconds = chrono::duration<double>(elapsed).count();
+    double audioSeconds = 0;
+    for (auto& result : m_results)
+    {
+        audioSeconds += result.audioSeconds;
+    }
+
+    size_t completed = m_results.size() - m_failures;
+    log_t("Batch finished: ", completed, " of ", m_results.size(), " utterance(s) in ", wallSeconds, "s, ",
+        wallSeconds > 0 ? completed / wallSeconds : 0, " utterances/s, ",
+        wallSeconds > 0 ? audioSeconds / wallSeconds : 0, "x real-time");
+
+    auto logLatency = [](const char* name, const LatencyHistogram& histogram)
+    {
+        if (histogram.Count() == 0)
+        {
+            log_t(name, ": no samples");
+            return;
+        }
+        log_t(name, " (", histogram.Count(), " samples): p50 ", histogram.Percentile(50.0) / 1000.0,
+            "ms, p90 ", histogram.Percentile(90.0) / 1000.0,
+            "ms, p99 ", histogram.Percentile(99.0) / 1000.0,
+            "ms, max ", histogram.Max() / 1000.0, "ms");
+    };
+    logLatency("Audio end to recognized", m_recognitionLatency);
+    logLatency("Audio end to first activity", m_activityLatency);
+}
+
+void BatchRunner::WriteResults()
+{
+    ofstream out(m_options.resultsPath);
+    if (!out)
+    {
+        log_t("Could not write batch results to ", m_options.resultsPath);
+        return;
+    }
+
+    for (auto& result : m_results)
+    {
+        nlohmann::json line =
+        {
+            { "path", result.path },
+            { "text", result.recognizedText },
+            { "activities", result.activities },
+            { "audioSeconds", result.audioSeconds },
+            { "totalMs", Milliseconds(result.finished - result.started) }
+        };
+        if (HasTime(result.audioEnd))
+        {
+            line["pushMs"] = Milliseconds(result.audioEnd - result.started);
+        }
+        if (HasTime(result.recognized))
+        {
+            line["recognizedMs"] = Milliseconds(result.recognized - result.audioEnd);
+        }
+        if (HasTime(result.firstActivity))
+        {
+            line["firstActivityMs"] = Milliseconds(result.firstActivity - result.audioEnd);
+        }
+        if (!result.error.empty())
+        {
+            line["error"] = result.error;
+        }
+        out << line.dump() << "\n";
+    }
+    log_t("Wrote batch results to ", m_options.resultsPath);
+}
@@ -0,0 +1,226 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include "ConnectionManager.h"
+#include "log.h"
+
+using namespace std;
+
+constexpr chrono::seconds ConnectionManager::ServiceIdleTimeout;
+constexpr chrono::milliseconds ConnectionManager::FirstReconnectDelay;
+constexpr chrono::milliseconds ConnectionManager::MaxReconnectDelay;
+
+namespace
+{
+    constexpr auto KeepAliveActivity = R"({"type":"event","name":"KeepAlive"})";
+
+    int64_t NowTicks()
+    {
+        return chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    chrono::steady_clock::time_point FromTicks(int64_t ticks)
+    {
+        return chrono::steady_clock::time_point(chrono::steady_clock::duration(ticks));
+    }
+}
+
+ConnectionManager::ConnectionManager(shared_ptr<IDialogService> service, chrono::milliseconds keepAliveInterval,
+    chrono::milliseconds firstReconnectDelay)
+{
+    m_service = service;
+    m_keepAliveInterval = keepAliveInterval;
+    m_firstReconnectDelay = firstReconnectDelay;
+    m_lastActivity = NowTicks();
+}
+
+ConnectionManager::~ConnectionManager()
+{
+    Stop();
+}
+
+void ConnectionManager::Start()
+{
+    m_service->SetConnectionHandlers([this] { OnConnected(); }, [this] { OnDisconnected(); });
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = true;
+    }
+    m_schedulerThread = thread(&ConnectionManager::SchedulerThreadMain, this);
+
+    NoteActivity();
+    m_service->Connect();
+}
+
+void ConnectionManager::Stop()
+{
+    m_service->SetConnectionHandlers(nullptr, nullptr);
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_one();
+    if (m_schedulerThread.joinable())
+    {
+        m_schedulerThread.join();
+    }
+}
+
+void ConnectionManager::Disconnect()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_disconnectRequested = true;
+        m_stateChanged = true;
+    }
+    m_wakeUp.notify_one();
+    m_service->Disconnect();
+}
+
+void ConnectionManager::NoteActivity()
+{
+    m_lastActivity = NowTicks();
+}
+
+chrono::seconds ConnectionManager::Uptime() const
+{
+    if (!m_connected)
+    {
+        return chrono::seconds(0);
+    }
+    return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - FromTicks(m_connectedSince));
+}
+
+uint64_t ConnectionManager::ReconnectCount() const
+{
+    uint64_t connects = m_connects.load();
+    return connects > 0 ? connects - 1 : 0;
+}
+
+void ConnectionManager::OnConnected()
+{
+    m_connectedSince = NowTicks();
+    m_connected = true;
+    m_connects++;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_disconnectRequested = false;
+        m_stateChanged = true;
+    }
+    m_wakeUp.notify_one();
+}
+
+void ConnectionManager::OnDisconnected()
+{
+    m_connected = false;
+    m_disconnects++;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stateChanged = true;
+    }
+    m_wakeUp.notify_one();
+}
+
+void ConnectionManager::SendKeepAlive()
+{
+    m_keepAlivesSent++;
+    NoteActivity();
+    m_service->SendActivity(KeepAliveActivity);
+}
+
+void ConnectionManager::Reconnect()
+{
+    NoteActivity();
+    m_service->Connect();
+}
+
+void ConnectionManager::SchedulerThreadMain()
+{
+    bool wasConnected = false;
+    // only reconnect once a connection has actually dropped; the first connect is Start's
+    bool dropped = false;
+    auto disconnectedAt = chrono::steady_clock::now();
+    chrono::milliseconds reconnectDelay = m_firstReconnectDelay;
+
+    unique_lock<mutex> lock(m_mutex);
+    while (m_running)
+    {
+        auto now = chrono::steady_clock::now();
+        bool connected = m_connected;
+
+        if (m_stateChanged)
+        {
+            m_stateChanged = false;
+            if (connected && !wasConnected)
+            {
+                log_t("Connected to the dialog service (reconnects ", ReconnectCount(), ")");
+                reconnectDelay = m_firstReconnectDelay;
+            }
+            else if (!connected && wasConnected && m_disconnectRequested)
+            {
+                log_t("Disconnected from the dialog service as requested after ",
+                    chrono::duration_cast<chrono::seconds>(now - FromTicks(m_connectedSince)).count(), "s connected");
+            }
+            else if (!connected && wasConnected)
+            {
+                log_t("Disconnected from the dialog service after ", chrono::duration_cast<chrono::seconds>(now - FromTicks(m_connectedSince)).count(),
+                    "s connected, reconnecting in ", reconnectDelay.count(), "ms");
+                dropped = true;
+            }
+            if (m_disconnectRequested)
+            {
+                // whoever asked for the disconnect connects again, so a reconnect still pending is not wanted
+                dropped = false;
+            }
+            if (!connected)
+            {
+                disconnectedAt = now;
+            }
+            wasConnected = connected;
+        }
+
+        chrono::steady_clock::time_point deadline;
+        if (connected)
+        {
+            if (m_keepAliveInterval.count() > 0)
+            {
+                deadline = FromTicks(m_lastActivity) + m_keepAliveInterval;
+                if (now >= deadline)
+                {
+                    lock.unlock();
+                    SendKeepAlive();
+                    lock.lock();
+                    continue;
+                }
+            }
+            else
+            {
+                deadline = now + ServiceIdleTimeout;
+            }
+        }
+        else if (!dropped)
+        {
+            m_wakeUp.wait(lock);
+            continue;
+        }
+        else
+        {
+            deadline = disconnectedAt + reconnectDelay;
+            if (now >= deadline)
+            {
+                log_t("Reconnecting to the dialog service");
+                lock.unlock();
+                Reconnect();
+                lock.lock();
+                disconnectedAt = chrono::steady_clock::now();
+                reconnectDelay = min(reconnectDelay * 2, MaxReconnectDelay);
+                continue;
+            }
+        }
+
+        m_wakeUp.wait_until(lock, deadline);
+    }
+}
@@ -3,7 +3,14 @@
 
 #include <thread>
 #include "log.h"
+#include "AudioConverter.h"
 #include "DialogManager.h"
+#include "LocalDialogService.h"
+#include "PushPacer.h"
+#include "ResourceUsage.h"
+#include "SpeechDialogService.h"
+#include "Tracer.h"
+#include "WavHeader.h"
 
 using namespace std;
 using namespace Microsoft::CognitiveServices::Speech;
@@ -12,49 +19,119 @@ using namespace Microsoft::CognitiveServices::Speech::Dialog;
 using namespace AudioPlayer;
 using namespace MicMuter;
 
-DialogManager::DialogManager(shared_ptr<AgentConfiguration> agentConfig)
+namespace
 {
+    // trace.json and ".turn3" make trace.turn3.json
+    string InsertBeforeExtension(const string& path, const string& suffix)
+    {
+        size_t dot = path.find_last_of('.');
+        size_t separator = path.find_last_of("/\\");
+        if (dot == string::npos || (separator != string::npos && dot < separator))
+        {
+            return path + suffix;
+        }
+        return path.substr(0, dot) + suffix + path.substr(dot);
+    }
+}
+
+DialogManager::DialogManager(shared_ptr<AgentConfiguration> agentConfig) : DialogManager(agentConfig, nullptr, "")
+{
+}
+
+DialogManager::DialogManager(shared_ptr<AgentConfiguration> agentConfig, shared_ptr<DispatchPool> dispatchPool, string sessionName)
+{
+    _startedAt = chrono::steady_clock::now();
     _agentConfig = agentConfig;
+    _dispatchPool = dispatchPool;
+    _sessionName = sessionName;
 
+    InitializeTracing();
+    InitializeStatusPipeline();
+    InitializeStatusBoard();
     SetDeviceStatus(DeviceStatus::Initializing);
 
     InitializeDialogServiceConnectorFromMicrophone();
     InitializePlayer();
     InitializeMuter();
+    StartDispatcher();
     AttachHandlers();
-    InitializeConnection();
+    InitializeConnectionManager();
 
-    // Activate keyword listening on start up if keyword model file exists
+    // Activate keyword listening on start up if keyword model file exists. This is local, so it goes before the
+    // connection and a keyword spoken while the connection comes up is still heard. The turn it starts relies on
+    // the connector sending the audio that follows the keyword once it has connected; LocalDialogService models
+    // that, and its tests check that such a turn is answered.
     if (_agentConfig->KeywordRecognitionModel().length() > 0)
     {
         StartKws();
+        _startupToArmedMicroseconds = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - _startedAt).count();
+        log_t("Keyword recognition armed ", _startupToArmedMicroseconds / 1000, "ms after start up");
     }
     else
     {
         SetKeywordActivationState(KeywordActivationState::NotSupported);
     }
 
+    ConnectInBackground();
     SetDeviceStatus(DeviceStatus::Ready);
 }
 
 DialogManager::DialogManager(shared_ptr<AgentConfiguration> agentConfig, string audioFilePath)
 {
+    _startedAt = chrono::steady_clock::now();
     _agentConfig = agentConfig;
     _audioFilePath = audioFilePath;
 
+    InitializeTracing();
+    InitializeStatusPipeline();
+    InitializeStatusBoard();
     SetDeviceStatus(DeviceStatus::Initializing);
 
     InitializeDialogServiceConnectorFromFile();
     InitializePlayer();
     InitializeMuter();
+    StartDispatcher();
     AttachHandlers();
     InitializeConnection();
 
     SetDeviceStatus(DeviceStatus::Ready);
 }
 
+DialogManager::~DialogManager()
+{
+    WaitForConnectThread();
+    DetachHandlers();
+    // A drain still running on the pool can be inside a handler using the player or the connection manager,
+    // so wait for it first. Events posted after this are dropped, so the player's completion callbacks and
+    // the muter's event thread can still post while they are being shut down.
+    StopDispatcher();
+    _connectionManager.reset();
+    if (_muter)
+    {
+        _muter->SetMuteChangedHandler(nullptr);
+    }
+    delete _player;
+    _player = nullptr;
+
+    _pushing = false;
+    if (_pushThread.joinable())
+    {
+        _pushThread.join();
+    }
+
+    if (_turnTracker.CurrentTurn() > 0)
+    {
+        DumpTurnTimeline();
+    }
+}
+
 void DialogManager::InitializeDialogServiceConnectorFromMicrophone()
 {
+    if (InitializeLocalDialogService(false))
+    {
+        return;
+    }
+
     log_t("Configuration loaded. Creating connector...");
 
     // MAS stands for Microsoft Audio Stack
@@ -62,10 +139,10 @@ void DialogManager::InitializeDialogServiceConnectorFromMicrophone()
     auto config = _agentConfig->AsDialogServiceConfig();
     auto audioConfig = AudioConfig::FromMicrophoneInput(_agentConfig->_linuxCaptureDeviceName);
     config->SetProperty("MicArrayGeometryConfigFile", _agentConfig->_customMicConfigPath);
-    _dialogServiceConnector = DialogServiceConnector::FromConfig(config, audioConfig);
+    _dialogService = make_shared<SpeechDialogService>(DialogServiceConnector::FromConfig(config, audioConfig));
 #endif
 #ifndef MAS
-    _dialogServiceConnector = DialogServiceConnector::FromConfig(_agentConfig->AsDialogServiceConfig());
+    _dialogService = make_shared<SpeechDialogService>(DialogServiceConnector::FromConfig(_agentConfig->AsDialogServiceConfig()));
 #endif
     log_t("Connector created");
 }
@@ -89,13 +166,19 @@ void DialogManager::InitializePlayer()
         log_t("Initializing Audio Player...");
         _player->Initialize();
         _player->SetVolume(_agentConfig->_volume);
+
+        if (!_agentConfig->_ttsRecordingDirectory.empty())
+        {
+            log_t("Recording TTS audio to ", _agentConfig->_ttsRecordingDirectory);
+            _ttsRecorder = make_unique<TtsRecorder>(_agentConfig->_ttsRecordingDirectory, TtsRecorder::DefaultFormat());
+        }
     }
 }
 
 void DialogManager::InitializeMuter()
 {
 #ifdef LINUX
-    _muter = make_shared<LinuxMicMuter>();
+    _muter = make_shared<LinuxMicMuter>(_agentConfig->_linuxCaptureDeviceName);
 #endif
 #ifdef WINDOWS
     _muter = make_shared<WindowsMicMuter>();
@@ -103,168 +186,601 @@ void DialogManager::InitializeMuter()
 
     string result = (_muter->Initialize() == 0) ? "succeeded." : "failed.";
     log_t("Initializing Microphone Muter " + result);
+    _muter->SetMuteChangedHandler([this](bool)
+        {
+            auto start = chrono::steady_clock::now();
+            PostEvent(DialogEvent(DialogEvent::Type::MuteChanged), start);
+        });
+}
+
+void DialogManager::InitializeStatusPipeline()
+{
+    _statusPipeline = make_unique<StatusPipeline>(chrono::milliseconds(_agentConfig->_statusCoalesceMs));
+}
+
+void DialogManager::InitializeStatusBoard()
+{
+    if (_agentConfig->_statusBoardName.empty())
+    {
+        return;
+    }
+
+    string name = _agentConfig->_statusBoardName + (_sessionName.empty() ? "" : "." + _sessionName);
+    if (_statusBoard.Open(name) == 0)
+    {
+        log_t("Publishing status on the status board ", name);
+    }
+    else
+    {
+        LOG_ERROR("Failed to open the status board ", name);
+    }
+}
+
+void DialogManager::InitializeTracing()
+{
+    if (!_agentConfig->_traceFile.empty())
+    {
+        // the tracer is shared by every session in the process, so any session asking for it turns it on
+        Tracer::Instance().Enable(true);
+    }
+}
+
+void DialogManager::DumpTrace()
+{
+    if (_agentConfig->_traceFile.empty())
+    {
+        log_t("Tracing is off, set TraceFile in the configuration to turn it on");
+        return;
+    }
+    WriteTrace(_agentConfig->_traceFile);
+}
+
+int DialogManager::WriteTrace(const string& path)
+{
+    auto& tracer = Tracer::Instance();
+    int result = tracer.WriteChromeTrace(path);
+    if (result == 0)
+    {
+        log_t("Wrote the trace to ", path, " (", tracer.EventsRecorded(), " events recorded, ", tracer.EventsDropped(), " dropped)");
+    }
+    else
+    {
+        LOG_ERROR("Failed to write the trace to ", path);
+    }
+    return result;
+}
+
+void DialogManager::CheckTurnLatency(uint64_t turn, chrono::steady_clock::time_point at)
+{
+    if (_agentConfig->_traceTurnThresholdMs == 0 || _agentConfig->_traceFile.empty() ||
+        _turnTracker.Elapsed(turn, at) <= chrono::milliseconds(_agentConfig->_traceTurnThresholdMs))
+    {
+        return;
+    }
+
+    uint64_t traced = _tracedTurn.load();
+    if (traced >= turn || !_tracedTurn.compare_exchange_strong(traced, turn))
+    {
+        return;
+    }
+
+    // written on the dispatch thread, off the player thread this may be called on
+    DialogEvent slowTurn(DialogEvent::Type::SlowTurn);
+    slowTurn.text = to_string(turn);
+    PostEvent(std::move(slowTurn), chrono::steady_clock::now());
+}
+
+const char* DialogManager::EventName(DialogEvent::Type type)
+{
+    switch (type)
+    {
+    case DialogEvent::Type::SessionStarted: return "SessionStarted";
+    case DialogEvent::Type::SessionStopped: return "SessionStopped";
+    case DialogEvent::Type::Recognizing: return "Recognizing";
+    case DialogEvent::Type::Recognized: return "Recognized";
+    case DialogEvent::Type::Canceled: return "Canceled";
+    case DialogEvent::Type::ActivityReceived: return "ActivityReceived";
+    case DialogEvent::Type::Continue: return "Continue";
+    case DialogEvent::Type::ContinuationCanceled: return "ContinuationCanceled";
+    case DialogEvent::Type::MuteChanged: return "MuteChanged";
+    case DialogEvent::Type::SlowTurn: return "SlowTurn";
+    }
+    return "Unknown";
 }
 
 void DialogManager::SetDeviceStatus(const DeviceStatus status)
 {
     _deviceStatus = status;
-    DeviceStatusIndicators::SetStatus(_deviceStatus, IsMuted());
+    bool muted = IsMuted();
+    _statusPipeline->Post(_deviceStatus, muted);
+
+    // a turn always starts by going to Listening, so the turn count is current here
+    uint64_t turn = _turnTracker.CurrentTurn();
+    _statusBoard.Update([status, muted, turn](StatusBoardFields& fields)
+        {
+            fields.deviceStatus = (uint32_t)status;
+            fields.muted = muted ? 1 : 0;
+            fields.turnsStarted = turn;
+        });
+}
+
+void DialogManager::SetKeywordActivationState(const KeywordActivationState& state)
+{
+    _keywordActivationState = state;
+    _statusBoard.Update([state](StatusBoardFields& fields) { fields.keywordActivationState = (uint32_t)state; });
 }
 
 void DialogManager::AttachHandlers()
 {
+    // The handlers only copy what they need into the dispatch queue and return; the work happens on the
+    // dispatch thread so the service can keep delivering events.
+    DialogServiceHandlers handlers;
+
     // Signals that indicates the start of a listening session.
-    _dialogServiceConnector->SessionStarted += [&](const SessionEventArgs& event)
+    handlers.sessionStarted = [this](const string& sessionId)
     {
-        printf("SESSION STARTED: %s ...\n", event.SessionId.c_str());
+        auto start = chrono::steady_clock::now();
+        DialogEvent dialogEvent(DialogEvent::Type::SessionStarted);
+        dialogEvent.text = sessionId;
+        PostEvent(std::move(dialogEvent), start);
     };
 
     // Signals that indicates the end of a listening session.
-    _dialogServiceConnector->SessionStopped += [&](const SessionEventArgs& event)
+    handlers.sessionStopped = [this](const string& sessionId)
     {
-        printf("SESSION STOPPED: %s ...\n", event.SessionId.c_str());
+        auto start = chrono::steady_clock::now();
+        DialogEvent dialogEvent(DialogEvent::Type::SessionStopped);
+        dialogEvent.text = sessionId;
+        PostEvent(std::move(dialogEvent), start);
     };
 
     // Signal for events containing intermediate recognition results.
-    _dialogServiceConnector->Recognizing += [&](const SpeechRecognitionEventArgs& event)
+    handlers.recognizing = [this](ResultReason reason, const string& text)
     {
-        printf("INTERMEDIATE: %s ...\n", event.Result->Text.c_str());
-        SetDeviceStatus(DeviceStatus::Detecting);
+        auto start = chrono::steady_clock::now();
+        DialogEvent dialogEvent(DialogEvent::Type::Recognizing);
+        dialogEvent.text = text;
+        dialogEvent.reason = reason;
+        PostEvent(std::move(dialogEvent), start);
     };
 
     // Signal for events containing speech recognition results.
-    _dialogServiceConnector->Recognized += [&](const SpeechRecognitionEventArgs& event)
+    handlers.recognized = [this](ResultReason reason, const string& text)
     {
-        printf("FINAL RESULT: '%s'\n", event.Result->Text.c_str());
-        auto&& reason = event.Result->Reason;
-
-        DeviceStatus newStatus;
-
-        switch (reason)
+        auto start = chrono::steady_clock::now();
+        if (reason == ResultReason::RecognizedKeyword)
         {
-        case ResultReason::RecognizedKeyword:
-            newStatus = DeviceStatus::Listening;
-            _player->Stop();
-            break;
-        case ResultReason::RecognizedSpeech:
-            newStatus = DeviceStatus::Listening;
-            break;
-        default:
-            newStatus = DeviceStatus::Idle;
+            // silencing the answer the user is talking over cannot wait behind the dispatch queue
+            BargeIn(start);
         }
-
-        //update the device status
-        SetDeviceStatus(newStatus);
+        DialogEvent dialogEvent(DialogEvent::Type::Recognized);
+        dialogEvent.text = text;
+        dialogEvent.reason = reason;
+        PostEvent(std::move(dialogEvent), start);
     };
 
     // Signal for events relating to the cancellation of an interaction. The event indicates if the reason is a direct cancellation or an error.
-    _dialogServiceConnector->Canceled += [&](const SpeechRecognitionCanceledEventArgs& event)
+    handlers.canceled = [this](CancellationReason reason, const string& errorDetails)
     {
-
-        printf("CANCELED: Reason=%d\n", (int)event.Reason);
-        SetDeviceStatus(DeviceStatus::Idle);
-        if (event.Reason == CancellationReason::Error)
-        {
-            printf("CANCELED: ErrorDetails=%s\n", event.ErrorDetails.c_str());
-            printf("CANCELED: Did you update the subscription info?\n");
-            ResumeKws();
-        }
+        auto start = chrono::steady_clock::now();
+        DialogEvent dialogEvent(DialogEvent::Type::Canceled);
+        dialogEvent.cancellationReason = reason;
+        dialogEvent.text = errorDetails;
+        PostEvent(std::move(dialogEvent), start);
     };
 
     // Signals that an activity was received from the service
-    _dialogServiceConnector->ActivityReceived += [&](const ActivityReceivedEventArgs& event)
+    handlers.activityReceived = [this](const string& activity, shared_ptr<IAudioPlayerStream> audio)
     {
-        auto activity = nlohmann::json::parse(event.GetActivity());
+        auto start = chrono::steady_clock::now();
+        DialogEvent dialogEvent(DialogEvent::Type::ActivityReceived);
+        dialogEvent.text = activity;
+        dialogEvent.audio = std::move(audio);
+        PostEvent(std::move(dialogEvent), start);
+    };
 
-        // Let's log the type and whether we have audio. Note this is how you access a property in the json. Here we are
-        // reading the "type" value and defaulting to "" if it doesn't exist.
-        log_t("ActivityReceived, type=", activity.value("type", ""), ", audio=", event.HasAudio() ? "true" : "false");
+    _dialogService->SetHandlers(handlers);
+}
+
+void DialogManager::DetachHandlers()
+{
+    _dialogService->SetHandlers(DialogServiceHandlers());
+}
 
-        if (activity.contains("text"))
+void DialogManager::DumpTurnTimeline()
+{
+    string timeline = _turnTracker.ToJson();
+    log_t("Turn latency timeline: ", timeline);
+    if (_bargeInLatency.Count() > 0)
+    {
+        log_t("Barge-in keyword to silence: p50 ", _bargeInLatency.Percentile(50.0), "us, p99 ", _bargeInLatency.Percentile(99.0),
+            "us, max ", _bargeInLatency.Max(), "us over ", _bargeInLatency.Count(), " barge-ins");
+    }
+    if (_keywordArmLatency.Count() > 0)
+    {
+        auto& models = SpeechDialogService::KeywordModelCache();
+        log_t("Keyword recognition start or resume to armed: p50 ", _keywordArmLatency.Percentile(50.0), "us, p99 ",
+            _keywordArmLatency.Percentile(99.0), "us, max ", _keywordArmLatency.Max(), "us over ", _keywordArmLatency.Count(),
+            " starts, keyword model read from disk ", models.Loads(), " times");
+    }
+    auto& indicatorLatency = _statusPipeline->IndicatorLatency();
+    log_t("Status updates: ", _statusPipeline->Delivered(), " shown, ", _statusPipeline->Suppressed(), " suppressed, indicator latency p50 ",
+        indicatorLatency.Percentile(50.0), "us, p99 ", indicatorLatency.Percentile(99.0), "us, max ", indicatorLatency.Max(), "us");
+
+    if (!_agentConfig->_turnTimelineFile.empty())
+    {
+        ofstream file(_agentConfig->_turnTimelineFile, ios::out | ios::trunc);
+        file << timeline << endl;
+        if (!file)
         {
-            log_t("activity[\"text\"]: ", activity["text"].get<string>());
+            LOG_ERROR("Failed to write the turn latency timeline to ", _agentConfig->_turnTimelineFile);
         }
+    }
+}
+
+void DialogManager::AddActivityHandler(ActivityHandler handler)
+{
+    lock_guard<mutex> lock(_activityHandlersMutex);
+    _activityHandlers.push_back(std::move(handler));
+}
+
+void DialogManager::StartDispatcher()
+{
+    if (!_dispatchPool)
+    {
+        _dispatchPool = make_shared<DispatchPool>(1);
+    }
+    _dispatching = true;
+}
+
+void DialogManager::StopDispatcher()
+{
+    unique_lock<mutex> lock(_dispatchMutex);
+    _dispatching = false;
+    // a shared pool outlives us, so wait until it is done with our drain task
+    _drainIdle.wait(lock, [this] { return !_drainScheduled; });
+}
+
+void DialogManager::PostEvent(DialogEvent&& event, chrono::steady_clock::time_point callbackStart)
+{
+    Tracer::Instance().Instant("post", EventName(event.type), callbackStart);
+    _events.Push(std::move(event));
+    ScheduleDrain();
+    _callbackResidency.Record(chrono::steady_clock::now() - callbackStart);
+}
+
+void DialogManager::ScheduleDrain()
+{
+    // only the caller that flips the flag submits, so at most one drain is ever queued or running
+    if (_drainScheduled.exchange(true))
+    {
+        return;
+    }
+
+    lock_guard<mutex> lock(_dispatchMutex);
+    if (_dispatching)
+    {
+        _dispatchPool->Submit([this] { DrainEvents(); });
+    }
+    else
+    {
+        _drainScheduled = false;
+        _drainIdle.notify_all();
+    }
+}
+
+void DialogManager::DrainEvents()
+{
+    // Handle a bounded batch so one busy session cannot hold a shared worker.
+    constexpr int MaxEventsPerDrain = 16;
 
-        auto continue_multiturn = activity.value<string>("inputHint", "") == "expectingInput";
+    string previousSession = log_session();
+    log_session() = _sessionName;
+    auto cpuStart = ResourceUsage::ThreadCpuTime();
 
-        if (event.HasAudio())
+    DialogEvent event;
+    int handled = 0;
+    while (handled < MaxEventsPerDrain && _dispatching && _events.TryPop(event))
+    {
+        HandleEvent(event);
+        // drop the references held by the event, such as the audio stream, before the next one
+        event = DialogEvent();
+        handled++;
+    }
+
+    _eventsDispatched += handled;
+    _dispatchCpuMicroseconds += (ResourceUsage::ThreadCpuTime() - cpuStart).count();
+    log_session() = previousSession;
+
+    // StopDispatcher waits on this lock, so we must not touch any member once it is released
+    lock_guard<mutex> lock(_dispatchMutex);
+    _drainScheduled = false;
+    // a producer that pushed before the flag was cleared saw it set and left the drain to us
+    if (_dispatching && !_events.IsEmpty() && !_drainScheduled.exchange(true))
+    {
+        _dispatchPool->Submit([this] { DrainEvents(); });
+    }
+    _drainIdle.notify_all();
+}
+
+void DialogManager::HandleEvent(DialogEvent& event)
+{
+    TraceSpan span("dialog", EventName(event.type));
+    switch (event.type)
+    {
+    case DialogEvent::Type::SessionStarted:
+        printf("SESSION STARTED: %s ...\n", event.text.c_str());
+        _sessionId = event.text;
+        _connectionManager->NoteActivity();
+        break;
+    case DialogEvent::Type::SessionStopped:
+        printf("SESSION STOPPED: %s ...\n", event.text.c_str());
+        log_t("SDK callback residency: median ", _callbackResidency.Percentile(50.0), "us, p99 ", _callbackResidency.Percentile(99.0),
+            "us, max ", _callbackResidency.Max(), "us over ", _callbackResidency.Count(), " callbacks");
+        // the idle clock starts when the last audio has gone up
+        _connectionManager->NoteActivity();
+        log_t("Connection up for ", _connectionManager->Uptime().count(), "s, ", _connectionManager->ReconnectCount(), " reconnects, ",
+            _connectionManager->KeepAlivesSent(), " keepalives sent");
+        break;
+    case DialogEvent::Type::Recognizing:
+        printf("INTERMEDIATE: %s ...\n", event.text.c_str());
+        if (event.reason == ResultReason::RecognizingSpeech)
         {
-            log_t("Activity has audio, playing asynchronously.");
+            _turnTracker.Mark(TurnTracker::Stage::FirstRecognizing, event.received);
+        }
+        SetDeviceStatus(DeviceStatus::Detecting);
+        break;
+    case DialogEvent::Type::Recognized:
+        HandleRecognized(event);
+        break;
+    case DialogEvent::Type::Canceled:
+        HandleCanceled(event);
+        break;
+    case DialogEvent::Type::ActivityReceived:
+        HandleActivity(event);
+        // everything the activity's DOM allocated goes at once
+        _activityArena.Reset();
+        break;
+    case DialogEvent::Type::Continue:
+        HandleContinuation(event);
+        break;
+    case DialogEvent::Type::ContinuationCanceled:
+        log_t("TTS playback was stopped, not continuing the conversation");
+        break;
+    case DialogEvent::Type::MuteChanged:
+        // republish the current status with the new mute state
+        SetDeviceStatus(_deviceStatus);
+        break;
+    case DialogEvent::Type::SlowTurn:
+        log_t("Turn ", event.text, " went over ", _agentConfig->_traceTurnThresholdMs, "ms");
+        WriteTrace(InsertBeforeExtension(_agentConfig->_traceFile,
+            (_sessionName.empty() ? "" : "." + _sessionName) + ".turn" + event.text));
+        break;
+    }
+}
 
-            if (!_bargeInSupported)
+void DialogManager::BargeIn(chrono::steady_clock::time_point keywordAt)
+{
+    if (_player == nullptr)
+    {
+        return;
+    }
+
+    _player->BargeIn([this, keywordAt](chrono::steady_clock::time_point silentAt, bool wasAudible)
+        {
+            // a keyword heard while nothing was playing says nothing about how fast we go quiet
+            if (wasAudible)
             {
-                log_t("Pausing KWS during TTS playback");
-                PauseKws();
+                auto latency = silentAt - keywordAt;
+                _bargeInLatency.Record(latency);
+                _statusBoard.Update([silentAt](StatusBoardFields& fields)
+                    {
+                        fields.bargeIns++;
+                        fields.playing = 0;
+                        fields.playbackEndedUs = StatusBoard::ToMicroseconds(silentAt);
+                    });
+                log_t("Barge-in: silent ", chrono::duration_cast<chrono::microseconds>(latency).count(), "us after the keyword");
             }
+        });
+}
 
-            auto audio = event.GetAudio();
-            int play_result = 0;
+void DialogManager::HandleRecognized(const DialogEvent& event)
+{
+    printf("FINAL RESULT: '%s'\n", event.text.c_str());
+    auto&& reason = event.reason;
 
-            uint32_t total_bytes_read = 0;
-            if (_volumeOn && _player != nullptr)
-            {
+    DeviceStatus newStatus;
 
-                // If we are expecting more input and have audio to play, we will want to wait till all audio is done playing before
-                // before listening again. We can read from the stream here to accomplish this.
-                if (continue_multiturn)
-                {
-                    uint32_t playBufferSize = 1024;
-                    unsigned int bytesRead = 0;
-                    std::unique_ptr<unsigned char[]> playBuffer = std::make_unique<unsigned char[]>(playBufferSize);
-                    do
-                    {
-                        bytesRead = audio->Read(playBuffer.get(), playBufferSize);
-                        _player->Play(playBuffer.get(), bytesRead);
-                        total_bytes_read += bytesRead;
-                    } while (bytesRead > 0);
+    switch (reason)
+    {
+    case ResultReason::RecognizedKeyword:
+        newStatus = DeviceStatus::Listening;
+        _turnTracker.StartTurn(event.received);
+        if (!_connectionManager->IsConnected())
+        {
+            log_t("Keyword recognized before the connection is up, the turn goes to the service once it connects");
+        }
+        break;
+    case ResultReason::RecognizedSpeech:
+        // the utterance is complete and we are waiting for the service to answer
+        newStatus = DeviceStatus::Thinking;
+        _turnTracker.Mark(TurnTracker::Stage::FinalRecognized, event.received);
+        break;
+    default:
+        newStatus = DeviceStatus::Idle;
+    }
 
-                    SetDeviceStatus(DeviceStatus::Speaking);
+    //update the device status
+    SetDeviceStatus(newStatus);
+}
 
-                    // We don't want to timeout while tts is playing so start 1 second before it is done
-                    int secondsOfAudio = total_bytes_read / 32000;
-                    std::this_thread::sleep_for(std::chrono::milliseconds((secondsOfAudio - 1) * 1000));
-                }
-                else
+void DialogManager::HandleCanceled(const DialogEvent& event)
+{
+    printf("CANCELED: Reason=%d\n", (int)event.cancellationReason);
+    SetDeviceStatus(DeviceStatus::Idle);
+    if (event.cancellationReason == CancellationReason::Error)
+    {
+        printf("CANCELED: ErrorDetails=%s\n", event.text.c_str());
+        printf("CANCELED: Did you update the subscription info?\n");
+        ResumeKws();
+    }
+}
+
+void DialogManager::HandleActivity(DialogEvent& event)
+{
+    // Only the top-level fields are extracted here. Handlers that need anything else, such as attachments,
+    // call activity.Json() and pay for the full parse.
+    Activity activity(std::move(event.text), &_activityArena);
+
+    // Let's log the type and whether we have audio.
+    LOG_INFO("ActivityReceived, type=", activity.Type(), ", audio=", event.audio != nullptr ? "true" : "false");
+
+    if (activity.HasText())
+    {
+        LOG_INFO("activity[\"text\"]: ", activity.Text());
+    }
+
+    {
+        lock_guard<mutex> lock(_activityHandlersMutex);
+        for (auto& handler : _activityHandlers)
+        {
+            handler(activity);
+        }
+    }
+
+    auto continue_multiturn = activity.InputHint() == "expectingInput";
+    auto activityReceivedTime = event.received;
+    bool firstActivity = _turnTracker.Mark(TurnTracker::Stage::FirstActivity, activityReceivedTime);
+    if (firstActivity && event.audio == nullptr)
+    {
+        // a text only answer is complete when it arrives
+        CheckTurnLatency(_turnTracker.CurrentTurn(), activityReceivedTime);
+    }
+    bool continuationScheduled = false;
+
+    if (event.audio != nullptr)
+    {
+        LOG_INFO("Activity has audio, playing asynchronously.");
+
+        if (!_bargeInSupported)
+        {
+            LOG_DEBUG("Pausing KWS during TTS playback");
+            PauseKws();
+        }
+
+        auto audio = event.audio;
+        int play_result = 0;
+
+        if (_volumeOn && _player != nullptr)
+        {
+            std::shared_ptr<IAudioPlayerStream> playerStream = audio;
+            if (_ttsRecorder)
+            {
+                auto recording = _ttsRecorder->StartTurn(_sessionId, activity.Id());
+                playerStream = std::make_shared<TeeAudioPlayerStream>(playerStream, recording);
+            }
+
+            // the player callbacks run on the player thread, and only count for the turn that is current when they fire
+            uint64_t turn = _turnTracker.CurrentTurn();
+            auto onStarted = [this, turn](chrono::steady_clock::time_point audibleAt)
+            {
+                _turnTracker.Mark(turn, TurnTracker::Stage::FirstAudioByte);
+                if (_turnTracker.Mark(turn, TurnTracker::Stage::FirstAudible, audibleAt))
                 {
-                    std::shared_ptr<IAudioPlayerStream> playerStream = std::make_shared<AudioPlayerStreamImpl>(audio);
-                    play_result = _player->Play(playerStream);
+                    CheckTurnLatency(turn, audibleAt);
                 }
-            }
+                _statusBoard.Update([audibleAt](StatusBoardFields& fields)
+                    {
+                        fields.playing = 1;
+                        fields.playbackStartedUs = StatusBoard::ToMicroseconds(audibleAt);
+                        fields.playbackEndedUs = 0;
+                    });
+            };
 
-            if (!continue_multiturn)
+            if (continue_multiturn)
             {
-                SetDeviceStatus(DeviceStatus::Idle);
+                // If we are expecting more input we want to start listening again just before the audio finishes
+                // playing, so the listening session does not time out while tts is playing.
+                SetDeviceStatus(DeviceStatus::Speaking);
+                auto leadTime = chrono::milliseconds(_agentConfig->_multiturnLeadTimeMs);
+                play_result = _player->Play(playerStream, leadTime, [this, activityReceivedTime, turn, leadTime](bool canceled)
+                    {
+                        if (!canceled)
+                        {
+                            // we are called the lead time ahead of the end
+                            _turnTracker.Mark(turn, TurnTracker::Stage::PlaybackEnded, chrono::steady_clock::now() + leadTime);
+                        }
+                        PublishPlaybackEnded(canceled, chrono::steady_clock::now() + (canceled ? chrono::milliseconds(0) : leadTime));
+                        // hand the continuation to the dispatcher
+                        DialogEvent continuation(canceled ? DialogEvent::Type::ContinuationCanceled : DialogEvent::Type::Continue);
+                        continuation.received = activityReceivedTime;
+                        PostEvent(std::move(continuation), chrono::steady_clock::now());
+                    }, onStarted);
+                continuationScheduled = play_result >= 0;
             }
+            else
+            {
+                play_result = _player->Play(playerStream, chrono::milliseconds(0), [this, turn](bool canceled)
+                    {
+                        if (!canceled)
+                        {
+                            _turnTracker.Mark(turn, TurnTracker::Stage::PlaybackEnded);
+                        }
+                        PublishPlaybackEnded(canceled, chrono::steady_clock::now());
+                    }, onStarted);
+            }
+        }
+
+        if (!continue_multiturn)
+        {
+            SetDeviceStatus(DeviceStatus::Idle);
         }
+    }
 
-        if (continue_multiturn)
+    if (continue_multiturn)
+    {
+        if (continuationScheduled)
+        {
+            log_t("Activity requested a continuation (ExpectingInput) -- listening again when playback is about to end");
+        }
+        else
         {
             log_t("Activity requested a continuation (ExpectingInput) -- listening again");
-            // There may be an issue where the listening times out while the Audio is playing.
             ContinueListening();
         }
-        else
+    }
+    else
+    {
+        if (!_bargeInSupported)
         {
-            if (!_bargeInSupported)
-            {
-                ResumeKws();
-            }
+            ResumeKws();
         }
-    };
+    }
+}
+
+void DialogManager::HandleContinuation(const DialogEvent& event)
+{
+    auto latency = chrono::steady_clock::now() - event.received;
+    _turnLatency.Record(latency);
+    log_t("Listening again ", chrono::duration_cast<chrono::milliseconds>(latency).count(), "ms after the activity (median ",
+        _turnLatency.Percentile(50.0) / 1000, "ms, p95 ", _turnLatency.Percentile(95.0) / 1000, "ms over ", _turnLatency.Count(), " turns)");
+    ContinueListening();
 }
 
 void DialogManager::StartKws()
 {
-    log_t("Enter StartKws (state = ", uint32_t(_keywordActivationState), ")");
+    TraceSpan span("kws", "StartKws");
+    LOG_DEBUG("Enter StartKws (state = ", uint32_t(_keywordActivationState), ")");
 
     auto modelPath = _agentConfig->KeywordRecognitionModel();
-    log_t("Initializing keyword recognition with: ", modelPath);
-    auto model = KeywordRecognitionModel::FromFile(modelPath);
-    auto _ = _dialogServiceConnector->StartKeywordRecognitionAsync(model);
-    _keywordActivationState = KeywordActivationState::Listening;
-    log_t("KWS initialized");
-
-    log_t("Exit StartKws (state = ", uint32_t(_keywordActivationState), ")");
+    LOG_DEBUG("Initializing keyword recognition with: ", modelPath);
+    auto armStart = chrono::steady_clock::now();
+    _dialogService->StartKeywordRecognition(modelPath);
+    SetKeywordActivationState(KeywordActivationState::Listening);
+    _keywordArmLatency.Record(chrono::steady_clock::now() - armStart);
+    LOG_DEBUG("KWS initialized");
+
+    LOG_DEBUG("Exit StartKws (state = ", uint32_t(_keywordActivationState), ")");
 }
 
 void DialogManager::ResumeKws()
@@ -275,6 +791,19 @@ void DialogManager::ResumeKws()
     }
 }
 
+void DialogManager::PublishPlaybackEnded(bool canceled, chrono::steady_clock::time_point endedAt)
+{
+    _statusBoard.Update([canceled, endedAt](StatusBoardFields& fields)
+        {
+            if (!canceled)
+            {
+                fields.turnsPlayed++;
+            }
+            fields.playing = 0;
+            fields.playbackEndedUs = StatusBoard::ToMicroseconds(endedAt);
+        });
+}
+
 void DialogManager::StartListening()
 {
     _player->Stop();
@@ -285,8 +814,9 @@ void DialogManager::StartListening()
 void DialogManager::ContinueListening()
 {
     log_t("Now listening...");
+    _turnTracker.StartTurn();
     SetDeviceStatus(DeviceStatus::Listening);
-    auto future = _dialogServiceConnector->ListenOnceAsync();
+    _dialogService->ListenOnce();
 };
 
 void DialogManager::Stop()
@@ -297,12 +827,15 @@ void DialogManager::Stop()
     {
         _player->Stop();
     }
-    auto future = _dialogServiceConnector->DisconnectAsync();
-    InitializeConnection();
+    // a Stop() while the connection is still coming up waits for it rather than racing its Connect and SendActivity
+    WaitForConnectThread();
+    // not a drop, so the connection manager leaves reconnecting to ConnectInBackground
+    _connectionManager->Disconnect();
     if (_keywordActivationState != KeywordActivationState::NotSupported)
     {
         StartKws();
     }
+    ConnectInBackground();
     SetDeviceStatus(DeviceStatus::Ready);
 }
 
@@ -312,44 +845,50 @@ void DialogManager::MuteUnMute()
     {
         string result = _muter->IsMuted() ? "muted." : "unmuted.";
         log_t("Microphone is " + result);
+#ifndef LINUX
+        // the Linux muter reports its own changes through the mute changed handler
+        PostEvent(DialogEvent(DialogEvent::Type::MuteChanged), chrono::steady_clock::now());
+#endif
     }
     else
     {
-        log_t("Mute/UnMute microphone failed.");
+        LOG_ERROR("Mute/UnMute microphone failed.");
     }
 }
 
 void DialogManager::StopKws()
 {
-    log_t("Enter StopKws (state = ", uint32_t(_keywordActivationState), ")");
+    TraceSpan span("kws", "StopKws");
+    LOG_DEBUG("Enter StopKws (state = ", uint32_t(_keywordActivationState), ")");
 
     if (_keywordActivationState == KeywordActivationState::Listening ||
         _keywordActivationState == KeywordActivationState::Paused)
     {
         if (_keywordActivationState == KeywordActivationState::Listening)
         {
-            log_t("Stopping keyword recognition");
-            auto future = _dialogServiceConnector->StopKeywordRecognitionAsync();
+            LOG_DEBUG("Stopping keyword recognition");
+            _dialogService->StopKeywordRecognition();
         }
 
-        _keywordActivationState = KeywordActivationState::NotListening;
+        SetKeywordActivationState(KeywordActivationState::NotListening);
     }
 
-    log_t("Exit StopKws (state = ", uint32_t(_keywordActivationState), ")");
+    LOG_DEBUG("Exit StopKws (state = ", uint32_t(_keywordActivationState), ")");
 }
 
 void DialogManager::PauseKws()
 {
-    log_t("Enter PauseKws (state = ", uint32_t(_keywordActivationState), ")");
+    TraceSpan span("kws", "PauseKws");
+    LOG_DEBUG("Enter PauseKws (state = ", uint32_t(_keywordActivationState), ")");
 
     if (_keywordActivationState == KeywordActivationState::Listening)
     {
-        log_t("Stopping keyword recognition");
-        auto future = _dialogServiceConnector->StopKeywordRecognitionAsync();
-        _keywordActivationState = KeywordActivationState::Paused;
+        LOG_DEBUG("Stopping keyword recognition");
+        _dialogService->StopKeywordRecognition();
+        SetKeywordActivationState(KeywordActivationState::Paused);
     }
 
-    log_t("Exit PauseKws (state = ", uint32_t(_keywordActivationState), ")");
+    LOG_DEBUG("Exit PauseKws (state = ", uint32_t(_keywordActivationState), ")");
 }
 
 fstream DialogManager::OpenFile(const string& audioFilePath)
@@ -391,57 +930,176 @@ int DialogManager::ReadBuffer(fstream& fs, uint8_t* dataBuffer, uint32_t size)
     }
 }
 
-void DialogManager::PushData(const string& audioFilePath)
+void DialogManager::PushData(fstream fs, WavFile::WavFileInfo info)
 {
-    fstream fs;
-    try
+    log_t("Audio file format: ", info.format.samplesPerSecond, " Hz, ", info.format.bitsPerSample, " bit, ", info.format.channels, " channel(s)");
+
+    // the push stream is created with the default 16 khz 16 bit mono format, anything else is converted on the way in
+    unique_ptr<AudioConverter> converter;
+    if (AudioConverter::NeedsConversion(info.format))
     {
-        fs = OpenFile(audioFilePath);
-        //skip the wave header
-        fs.seekg(44);
-    }
-    catch (const exception& e)
-    {
-        cerr << "Error: exception in pushData, %s." << e.what() << endl;
-        cerr << "  can't open " << audioFilePath << endl;
-        throw e;
-        return;
+        converter = make_unique<AudioConverter>(info.format);
     }
+    std::vector<int16_t> converted;
+    chrono::steady_clock::duration conversionTime{ 0 };
 
-    std::array<uint8_t, 1000> buffer;
-    while (1)
+    // Read the input in blocks that hold PushPacer::ChunkMs of it, so a paced push releases audio the way a microphone would.
+    PushPacer pacer(_agentConfig->_fileInputSpeed);
+    std::vector<uint8_t> buffer(PushPacer::InputBytesPerChunk(info.format));
+
+    // a zero length means the header did not record one, so read to the end of the file
+    size_t remaining = info.dataLength > 0 ? info.dataLength : SIZE_MAX;
+    while (remaining > 0 && _pushing)
     {
-        auto readSamples = ReadBuffer(fs, buffer.data(), (uint32_t)buffer.size());
+        auto readSamples = ReadBuffer(fs, buffer.data(), (uint32_t)min(remaining, buffer.size()));
         if (readSamples == 0)
         {
             break;
         }
-        _pushStream.get()->Write(buffer.data(), readSamples);
+        remaining -= readSamples;
+
+        const uint8_t* output = buffer.data();
+        uint32_t outputSize = readSamples;
+        if (converter)
+        {
+            auto conversionStart = chrono::steady_clock::now();
+            converted.clear();
+            converter->Convert(buffer.data(), readSamples, converted);
+            conversionTime += chrono::steady_clock::now() - conversionStart;
+            output = (const uint8_t*)converted.data();
+            outputSize = (uint32_t)(converted.size() * sizeof(int16_t));
+        }
+
+        pacer.WaitForNextChunk();
+        _dialogService->WriteAudio(output, outputSize);
+        pacer.Pushed(outputSize);
     }
     fs.close();
-    _pushStream.get()->Close();
+    _dialogService->CloseAudio();
+
+    double audioSeconds = pacer.AudioSeconds();
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - pacer.Started()).count();
+    log_t("Pushed ", audioSeconds, "s of audio in ", wallSeconds, "s (", wallSeconds > 0 ? audioSeconds / wallSeconds : 0, "x real-time, ",
+        pacer.IsPaced() ? "paced" : "unthrottled", ", worst chunk ", chrono::duration_cast<chrono::microseconds>(pacer.MaxLateness()).count(), "us late)");
+
+    if (converter)
+    {
+        double seconds = chrono::duration<double>(conversionTime).count();
+        log_t("Converted ", converter->InputSeconds(), "s of audio in ", seconds * 1000, "ms (",
+            seconds > 0 ? converter->InputSeconds() / seconds : 0, "x real-time)");
+    }
 }
 
 void DialogManager::ListenFromFile()
 {
-    PushData(_audioFilePath);
-    _dialogServiceConnector->ListenOnceAsync();
+    fstream fs;
+    WavFile::WavFileInfo info;
+    try
+    {
+        fs = OpenFile(_audioFilePath);
+        auto result = WavFile::ReadHeader(fs, info);
+        if (result != WavFile::WavParseResult::Success)
+        {
+            throw invalid_argument(WavFile::ToString(result));
+        }
+        if (AudioConverter::NeedsConversion(info.format) && !AudioConverter::IsSupported(info.format))
+        {
+            throw invalid_argument("Unsupported audio format.");
+        }
+    }
+    catch (const exception& e)
+    {
+        cerr << "Error: exception in pushData, %s." << e.what() << endl;
+        cerr << "  can't open " << _audioFilePath << endl;
+        throw e;
+        return;
+    }
+
+    // push on a thread of its own so recognition runs while the audio is still arriving
+    _pushing = true;
+    _pushThread = thread(&DialogManager::PushData, this, std::move(fs), info);
+    _dialogService->ListenOnce();
 }
 
 void DialogManager::InitializeDialogServiceConnectorFromFile()
 {
+    if (InitializeLocalDialogService(true))
+    {
+        return;
+    }
+
     log_t("Configuration loaded. Creating connector...");
     shared_ptr<DialogServiceConfig> config = _agentConfig->CreateDialogServiceConfig();
-    _pushStream = AudioInputStream::CreatePushStream();
-    auto audioConfig = AudioConfig::FromStreamInput(_pushStream);
+    auto pushStream = AudioInputStream::CreatePushStream();
+    auto audioConfig = AudioConfig::FromStreamInput(pushStream);
 
-    _dialogServiceConnector = DialogServiceConnector::FromConfig(config, audioConfig);
+    _dialogService = make_shared<SpeechDialogService>(DialogServiceConnector::FromConfig(config, audioConfig), pushStream);
     log_t("Connector created");
 }
 
+bool DialogManager::InitializeLocalDialogService(bool pushedInput)
+{
+    if (_agentConfig->_localDialogScript.empty())
+    {
+        return false;
+    }
+
+    log_t("Configuration loaded. Creating the local dialog service...");
+    _dialogService = LocalDialogService::FromScriptFile(_agentConfig->_localDialogScript, pushedInput);
+    if (!_dialogService)
+    {
+        throw invalid_argument("Failed to load the local dialog script.");
+    }
+    return true;
+}
+
+void DialogManager::InitializeConnectionManager()
+{
+    if (!_connectionManager)
+    {
+        _connectionManager = make_unique<ConnectionManager>(_dialogService, chrono::seconds(_agentConfig->_keepAliveIntervalSeconds));
+    }
+}
+
+void DialogManager::ConnectInBackground()
+{
+    WaitForConnectThread();
+    _connectThread = thread([this]
+        {
+            Tracer::Instance().SetThreadName("connect");
+            log_session() = _sessionName;
+            InitializeConnection();
+
+            int64_t expected = 0;
+            int64_t connected = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - _startedAt).count();
+            if (_startupToConnectedMicroseconds.compare_exchange_strong(expected, connected))
+            {
+                log_t("Connection initialized ", connected / 1000, "ms after start up");
+            }
+        });
+}
+
+void DialogManager::WaitForConnectThread()
+{
+    if (_connectThread.joinable())
+    {
+        _connectThread.join();
+    }
+}
+
 void DialogManager::InitializeConnection()
 {
-    auto future = _dialogServiceConnector->ConnectAsync();
+    TraceSpan span("connector", "InitializeConnection");
+    InitializeConnectionManager();
+    if (!_connectionStarted)
+    {
+        _connectionManager->Start();
+        _connectionStarted = true;
+    }
+    else
+    {
+        _dialogService->Connect();
+    }
     log_t("Creating prime activity");
     nlohmann::json keywordPrimingActivity =
     {
@@ -451,7 +1109,8 @@ void DialogManager::InitializeConnection()
     };
     auto keywordPrimingActivityText = keywordPrimingActivity.dump();
     log_t("Sending inform-of-keyword activity: ", keywordPrimingActivityText);
-    auto stringFuture = _dialogServiceConnector->SendActivityAsync(keywordPrimingActivityText);
+    _dialogService->SendActivity(keywordPrimingActivityText);
+    _connectionManager->NoteActivity();
 
     log_t("Connector successfully initialized!");
 }
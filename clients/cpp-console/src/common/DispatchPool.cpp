@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "DispatchPool.h"
+#include "Tracer.h"
+
+using namespace std;
+
+DispatchPool::DispatchPool(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&DispatchPool::WorkerThreadMain, this);
+    }
+}
+
+DispatchPool::~DispatchPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_taskReady.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void DispatchPool::Submit(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskReady.notify_one();
+}
+
+void DispatchPool::WorkerThreadMain()
+{
+    Tracer::Instance().SetThreadName("dispatch");
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_taskReady.wait(lock, [this] { return !m_running || !m_tasks.empty(); });
+        if (m_tasks.empty())
+        {
+            // only stop once everything submitted has run, so nobody is left waiting on a task
+            return;
+        }
+
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        m_tasksRun++;
+        lock.lock();
+    }
+}
@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <experimental/filesystem>
+#include <system_error>
+#include "FileCache.h"
+
+using namespace std;
+namespace fs = std::experimental::filesystem;
+
+FileStamp FileStamp::Of(const string& path)
+{
+    FileStamp stamp;
+    error_code error;
+    auto modified = fs::last_write_time(path, error);
+    if (error)
+    {
+        return stamp;
+    }
+    auto size = fs::file_size(path, error);
+    if (error)
+    {
+        return stamp;
+    }
+
+    stamp.exists = true;
+    stamp.modified = (int64_t)modified.time_since_epoch().count();
+    stamp.size = (uint64_t)size;
+    return stamp;
+}
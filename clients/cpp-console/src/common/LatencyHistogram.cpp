@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "LatencyHistogram.h"
+
+size_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+    if (value < SubBucketCount)
+    {
+        return (size_t)value;
+    }
+
+    // the highest set bit picks the power of two, the SubBucketBits bits below it pick the sub bucket
+    int magnitude = 63;
+    while ((value >> magnitude) == 0)
+    {
+        magnitude--;
+    }
+    int shift = magnitude - SubBucketBits;
+    return (size_t)(SubBucketCount * (shift + 1) + (value >> shift) - SubBucketCount);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+    if (index < SubBucketCount)
+    {
+        return index;
+    }
+
+    int shift = (int)(index / SubBucketCount) - 1;
+    uint64_t subBucket = SubBucketCount + index % SubBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t microseconds)
+{
+    size_t index = BucketIndex(microseconds);
+    if (index >= BucketCount)
+    {
+        index = BucketCount - 1;
+    }
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (microseconds > max && !m_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::Record(std::chrono::steady_clock::duration duration)
+{
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    Record(microseconds < 0 ? 0 : (uint64_t)microseconds);
+}
+
+uint64_t LatencyHistogram::Min() const
+{
+    for (size_t i = 0; i < BucketCount; i++)
+    {
+        if (m_buckets[i].load(std::memory_order_relaxed) > 0)
+        {
+            return BucketUpperBound(i);
+        }
+    }
+    return 0;
+}
+
+double LatencyHistogram::Mean() const
+{
+    uint64_t count = Count();
+    return count == 0 ? 0.0 : (double)m_sum.load(std::memory_order_relaxed) / count;
+}
+
+uint64_t LatencyHistogram::Percentile(double percent) const
+{
+    uint64_t count = Count();
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(percent / 100.0 * count + 0.5);
+    if (target == 0)
+    {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; i++)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            // never report more than the largest value actually recorded
+            uint64_t bound = BucketUpperBound(i);
+            return bound < Max() ? bound : Max();
+        }
+    }
+    return Max();
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
@@ -0,0 +1,545 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "log.h"
+#include "LocalDialogService.h"
+#include "MappedAudioPlayerStream.h"
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+using namespace std;
+using namespace Microsoft::CognitiveServices::Speech;
+
+namespace
+{
+    // TTS audio is 16 khz 16 bit mono, the SDK's default output format.
+    constexpr uint32_t TtsSamplesPerSecond = 16000;
+    constexpr double ToneHz = 440.0;
+    constexpr double ToneAmplitude = 2000.0;
+
+    /// <summary>
+    /// A fully buffered tone standing in for synthesized speech.
+    /// </summary>
+    class ToneAudioStream : public IAudioPlayerStream
+    {
+    public:
+        ToneAudioStream(chrono::milliseconds duration)
+        {
+            size_t samples = (size_t)(TtsSamplesPerSecond * duration.count() / 1000);
+            m_data.resize(samples * sizeof(int16_t));
+            int16_t* pcm = (int16_t*)m_data.data();
+            for (size_t i = 0; i < samples; i++)
+            {
+                pcm[i] = (int16_t)(ToneAmplitude * sin(2.0 * 3.14159265358979 * ToneHz * i / TtsSamplesPerSecond));
+            }
+        }
+
+        virtual unsigned int Read(unsigned char* buffer, size_t bufferSize) final
+        {
+            const unsigned char* slice;
+            unsigned int bytes = ReadSlice(&slice, bufferSize);
+            if (bytes > 0)
+            {
+                memcpy(buffer, slice, bytes);
+            }
+            return bytes;
+        }
+
+        virtual unsigned int TryRead(unsigned char* buffer, size_t bufferSize) final
+        {
+            return Read(buffer, bufferSize);
+        }
+
+        virtual size_t Available() final
+        {
+            return m_data.size() - m_position;
+        }
+
+        virtual bool IsEndOfStream() final
+        {
+            return m_position == m_data.size();
+        }
+
+        virtual bool IsFullyBuffered() final
+        {
+            return true;
+        }
+
+        virtual void SetReadyCallback(function<void()> callback) final
+        {
+            // everything is already here
+            if (callback)
+            {
+                callback();
+            }
+        }
+
+        virtual bool SupportsSlices() final
+        {
+            return true;
+        }
+
+        virtual unsigned int ReadSlice(const unsigned char** slice, size_t maxBytes) final
+        {
+            size_t bytes = min(maxBytes, Available());
+            *slice = bytes > 0 ? m_data.data() + m_position : nullptr;
+            m_position += bytes;
+            return (unsigned int)bytes;
+        }
+
+    private:
+        vector<unsigned char> m_data;
+        size_t m_position = 0;
+    };
+
+    shared_ptr<IAudioPlayerStream> CreateTtsAudio(const LocalDialogService::Turn& turn)
+    {
+        if (!turn.ttsFile.empty())
+        {
+            auto file = make_shared<AudioPlayer::MappedAudioPlayerStream>(turn.ttsFile);
+            if (file->IsValid())
+            {
+                return file;
+            }
+            log_t("Local dialog service could not read ", turn.ttsFile, ", generating a tone instead");
+        }
+        if (turn.ttsDuration.count() > 0)
+        {
+            return make_shared<ToneAudioStream>(turn.ttsDuration);
+        }
+        return nullptr;
+    }
+
+    string CreateActivity(const LocalDialogService::Turn& turn, uint64_t id)
+    {
+        nlohmann::json activity =
+        {
+            { "type", "message" },
+            { "id", "local-activity-" + to_string(id) },
+            { "text", turn.reply },
+            { "speak", turn.reply },
+            { "inputHint", turn.expectingInput ? "expectingInput" : "acceptingInput" }
+        };
+        if (!turn.activity.empty())
+        {
+            activity.update(nlohmann::json::parse(turn.activity));
+        }
+        return activity.dump();
+    }
+}
+
+LocalDialogService::LocalDialogService(Script script, bool pushedInput)
+{
+    m_script = std::move(script);
+    if (m_script.turns.empty())
+    {
+        m_script.turns.push_back(Turn());
+    }
+    m_pushedInput = pushedInput;
+    m_workerThread = thread(&LocalDialogService::WorkerThreadMain, this);
+}
+
+LocalDialogService::~LocalDialogService()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_one();
+    if (m_workerThread.joinable())
+    {
+        m_workerThread.join();
+    }
+}
+
+unique_ptr<LocalDialogService> LocalDialogService::FromScriptFile(const string& path, bool pushedInput)
+{
+    ifstream input(path);
+    if (!input)
+    {
+        log_t("Could not open the local dialog script ", path);
+        return nullptr;
+    }
+
+    Script script;
+    try
+    {
+        nlohmann::json j;
+        input >> j;
+
+        script.connectDelay = chrono::milliseconds(j.value("ConnectDelayMs", 0));
+        script.keywordAfter = chrono::milliseconds(j.value("KeywordAfterMs", 0));
+        script.recognizingDelay = chrono::milliseconds(j.value("RecognizingDelayMs", 0));
+        script.recognizedDelay = chrono::milliseconds(j.value("RecognizedDelayMs", 0));
+        script.activityDelay = chrono::milliseconds(j.value("ActivityDelayMs", 0));
+        if (j.contains("Turns"))
+        {
+            for (auto& t : j["Turns"])
+            {
+                Turn turn;
+                turn.text = t.value("Text", turn.text);
+                turn.reply = t.value("Reply", turn.reply);
+                turn.ttsDuration = chrono::milliseconds(t.value("TtsMs", (int)turn.ttsDuration.count()));
+                turn.ttsFile = t.value("TtsFile", "");
+                turn.expectingInput = t.value("ExpectingInput", false);
+                if (t.contains("Activity"))
+                {
+                    turn.activity = t["Activity"].dump();
+                }
+                script.turns.push_back(std::move(turn));
+            }
+        }
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        log_t("Could not parse the local dialog script ", path, ": ", e.what());
+        return nullptr;
+    }
+
+    log_t("Using the local dialog service with ", script.turns.size(), " scripted turn(s) from ", path);
+    return make_unique<LocalDialogService>(std::move(script), pushedInput);
+}
+
+void LocalDialogService::SetHandlers(const DialogServiceHandlers& handlers)
+{
+    lock_guard<mutex> lock(m_handlersMutex);
+    m_handlers = handlers;
+}
+
+void LocalDialogService::SetConnectionHandlers(function<void()> connected, function<void()> disconnected)
+{
+    lock_guard<mutex> lock(m_handlersMutex);
+    m_onConnected = std::move(connected);
+    m_onDisconnected = std::move(disconnected);
+}
+
+void LocalDialogService::Connect()
+{
+    TimePoint connectedAt;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        connectedAt = ConnectLocked(chrono::steady_clock::now());
+    }
+    // like the connector's, whose future waits in its destructor, Connect returns once the connection is up
+    this_thread::sleep_until(connectedAt);
+}
+
+void LocalDialogService::Disconnect()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_connected)
+    {
+        return;
+    }
+
+    // like the real service, dropping the connection abandons the session in progress
+    m_connected = false;
+    m_listening = false;
+    m_awaitingInputEnd = false;
+    m_epoch++;
+    Schedule(chrono::steady_clock::now(), [this]
+    {
+        lock_guard<mutex> lock(m_handlersMutex);
+        if (m_onDisconnected)
+        {
+            m_onDisconnected();
+        }
+    });
+}
+
+void LocalDialogService::ListenOnce()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_listening)
+    {
+        return;
+    }
+    StartSessionLocked(ConnectLocked(chrono::steady_clock::now()), false);
+}
+
+void LocalDialogService::StartKeywordRecognition(const string&)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_keywordArmed)
+    {
+        return;
+    }
+    m_keywordArmed = true;
+    if (m_script.keywordAfter.count() > 0)
+    {
+        ScheduleKeywordLocked(chrono::steady_clock::now() + m_script.keywordAfter);
+    }
+}
+
+void LocalDialogService::StopKeywordRecognition()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_keywordArmed = false;
+    m_keywordGeneration++;
+}
+
+void LocalDialogService::SendActivity(const string&)
+{
+    // the stand-in has no bot to deliver activities to
+}
+
+void LocalDialogService::WriteAudio(const uint8_t*, uint32_t size)
+{
+    m_audioBytes += size;
+}
+
+void LocalDialogService::CloseAudio()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_inputClosed = true;
+    if (m_awaitingInputEnd)
+    {
+        m_awaitingInputEnd = false;
+        m_inputConsumed = true;
+        FinishSessionLocked(chrono::steady_clock::now(), true);
+    }
+}
+
+void LocalDialogService::Schedule(TimePoint at, function<void()> action)
+{
+    m_actions.emplace(at, std::move(action));
+    m_wakeUp.notify_one();
+}
+
+LocalDialogService::TimePoint LocalDialogService::ConnectLocked(TimePoint at)
+{
+    if (m_connected)
+    {
+        return max(at, m_connectedAt);
+    }
+
+    m_connected = true;
+    m_connectedAt = at + m_script.connectDelay;
+    Schedule(m_connectedAt, [this]
+    {
+        lock_guard<mutex> lock(m_handlersMutex);
+        if (m_onConnected)
+        {
+            m_onConnected();
+        }
+    });
+    return m_connectedAt;
+}
+
+void LocalDialogService::ScheduleKeywordLocked(TimePoint at)
+{
+    uint64_t generation = m_keywordGeneration;
+    Schedule(at, [this, generation]
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_keywordArmed || generation != m_keywordGeneration)
+        {
+            return;
+        }
+        if (m_listening)
+        {
+            // a session is already running, so try again once it has had time to finish
+            ScheduleKeywordLocked(chrono::steady_clock::now() + m_script.keywordAfter);
+            return;
+        }
+        StartSessionLocked(ConnectLocked(chrono::steady_clock::now()), true);
+    });
+}
+
+void LocalDialogService::StartSessionLocked(TimePoint at, bool keyword)
+{
+    m_listening = true;
+    m_keywordSession = keyword;
+    m_sessionId = "local-session-" + to_string(++m_sessions);
+    uint64_t epoch = m_epoch;
+    string sessionId = m_sessionId;
+
+    Schedule(at, [this, epoch, sessionId, keyword]
+    {
+        Raise(epoch, [&](const DialogServiceHandlers& handlers)
+        {
+            if (handlers.sessionStarted)
+            {
+                handlers.sessionStarted(sessionId);
+            }
+            if (keyword && handlers.recognized)
+            {
+                handlers.recognized(ResultReason::RecognizedKeyword, "keyword");
+            }
+        });
+    });
+
+    const Turn& turn = m_script.turns[m_nextTurn % m_script.turns.size()];
+    m_recognizingPending = false;
+    if (m_script.recognizingDelay.count() > 0)
+    {
+        // the first word or so of the utterance
+        string partial = turn.text.substr(0, turn.text.find(' '));
+        m_recognizingAction = m_actions.emplace(at + m_script.recognizingDelay, [this, epoch, partial]
+        {
+            Raise(epoch, [&](const DialogServiceHandlers& handlers)
+            {
+                if (handlers.recognizing)
+                {
+                    handlers.recognizing(ResultReason::RecognizingSpeech, partial);
+                }
+            });
+        });
+        m_recognizingPending = true;
+        m_wakeUp.notify_one();
+    }
+
+    if (!m_pushedInput)
+    {
+        FinishSessionLocked(at, true);
+    }
+    else if (!m_inputClosed)
+    {
+        m_awaitingInputEnd = true;
+    }
+    else
+    {
+        // audio that was closed before listening started is recognized once; after that there is nothing to hear
+        bool matched = !m_inputConsumed;
+        m_inputConsumed = true;
+        FinishSessionLocked(at, matched);
+    }
+}
+
+void LocalDialogService::FinishSessionLocked(TimePoint inputEnd, bool matched)
+{
+    uint64_t epoch = m_epoch;
+    string sessionId = m_sessionId;
+    TimePoint recognizedAt = inputEnd + m_script.recognizedDelay;
+
+    // an intermediate result never follows the final one
+    if (m_recognizingPending && m_recognizingAction->first >= recognizedAt)
+    {
+        m_actions.erase(m_recognizingAction);
+    }
+    m_recognizingPending = false;
+
+    const Turn& turn = m_script.turns[m_nextTurn % m_script.turns.size()];
+    bool rearmKeyword = m_keywordSession;
+    uint64_t keywordGeneration = m_keywordGeneration;
+    string text = matched ? turn.text : "";
+    if (matched)
+    {
+        m_nextTurn++;
+    }
+
+    Schedule(recognizedAt, [this, epoch, sessionId, matched, text, rearmKeyword, keywordGeneration]
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (epoch != m_epoch)
+            {
+                return;
+            }
+            m_listening = false;
+            if (!matched && rearmKeyword && m_keywordArmed && keywordGeneration == m_keywordGeneration && m_script.keywordAfter.count() > 0)
+            {
+                ScheduleKeywordLocked(chrono::steady_clock::now() + m_script.keywordAfter);
+            }
+        }
+        if (!matched)
+        {
+            m_turnsCompleted++;
+        }
+        Raise(epoch, [&](const DialogServiceHandlers& handlers)
+        {
+            if (handlers.recognized)
+            {
+                handlers.recognized(matched ? ResultReason::RecognizedSpeech : ResultReason::NoMatch, text);
+            }
+            if (handlers.sessionStopped)
+            {
+                handlers.sessionStopped(sessionId);
+            }
+        });
+    });
+
+    if (!matched)
+    {
+        return;
+    }
+
+    Turn reply = turn;
+    Schedule(recognizedAt + m_script.activityDelay, [this, epoch, reply, rearmKeyword, keywordGeneration]
+    {
+        uint64_t id = ++m_activitiesSent;
+        string activity = CreateActivity(reply, id);
+        auto audio = CreateTtsAudio(reply);
+        m_turnsCompleted++;
+        Raise(epoch, [&](const DialogServiceHandlers& handlers)
+        {
+            if (handlers.activityReceived)
+            {
+                handlers.activityReceived(activity, audio);
+            }
+        });
+
+        lock_guard<mutex> lock(m_mutex);
+        if (rearmKeyword && m_keywordArmed && keywordGeneration == m_keywordGeneration && m_script.keywordAfter.count() > 0)
+        {
+            ScheduleKeywordLocked(chrono::steady_clock::now() + m_script.keywordAfter);
+        }
+    });
+}
+
+void LocalDialogService::Raise(uint64_t epoch, const function<void(const DialogServiceHandlers&)>& callback)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (epoch != m_epoch)
+        {
+            return;
+        }
+    }
+    lock_guard<mutex> lock(m_handlersMutex);
+    callback(m_handlers);
+}
+
+void LocalDialogService::WorkerThreadMain()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (m_running)
+    {
+        if (m_actions.empty())
+        {
+            m_wakeUp.wait(lock);
+            continue;
+        }
+
+        auto next = m_actions.begin();
+        if (chrono::steady_clock::now() < next->first)
+        {
+            m_wakeUp.wait_until(lock, next->first);
+            continue;
+        }
+
+        auto action = std::move(next->second);
+        if (m_recognizingPending && next == m_recognizingAction)
+        {
+            // it is about to run, so it can no longer be withdrawn
+            m_recognizingPending = false;
+        }
+        m_actions.erase(next);
+
+        // actions take the locks they need themselves
+        lock.unlock();
+        action();
+        lock.lock();
+    }
+}
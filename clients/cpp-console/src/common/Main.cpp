@@ -6,8 +6,10 @@
 #include <fstream>
 #include "log.h"
 #include "AgentConfiguration.h"
+#include "BatchRunner.h"
 #include "DialogManager.h"
 #include "DeviceStatusIndicators.h"
+#include "SessionHost.h"
 #include "speechapi_cxx.h"
 
 //the pragma here suppresses warnings from the 3rd party header
@@ -26,6 +28,8 @@ using namespace Microsoft::CognitiveServices::Speech::Audio;
 
 void DisplayKeystrokeOptions(DialogManager&);
 void HandleKeystrokeOptions(DialogManager&, string);
+int RunBatch(shared_ptr<AgentConfiguration>, int, char**);
+int RunHost(int, char**);
 
 int main(int argc, char** argv)
 {
@@ -33,9 +37,16 @@ int main(int argc, char** argv)
     {
         log("Usage with Microphone Input:\n", argv[0], " config_file_path\n");
         log("Usage with Audio File Input:\n", argv[0], " config_file_path audio_file_path\n");
+        log("Usage for Batch Evaluation:\n", argv[0], " config_file_path --batch wav_directory_or_manifest [--concurrency N] [--local [response_delay_ms]] [--results results_file]\n");
+        log("Usage for Several Sessions in One Process:\n", argv[0], " --host config_file_path [config_file_path ...] [--dispatch-threads N]\n");
         return 0;
     }
 
+    if (string(argv[1]) == "--host")
+    {
+        return RunHost(argc, argv);
+    }
+
     string configFilePath = argv[1];
     string wavFilePath = "";
 
@@ -52,6 +63,15 @@ int main(int argc, char** argv)
         log_t(agentConfig->LoadMessage());
         return (int)agentConfig->LoadResult();
     }
+    if (!agentConfig->_logLevel.empty() && !log_set_level(agentConfig->_logLevel))
+    {
+        log_t("Unknown log level ", agentConfig->_logLevel, ", logging at info");
+    }
+
+    if (wavFilePath == "--batch")
+    {
+        return RunBatch(agentConfig, argc, argv);
+    }
 
     std::shared_ptr<DialogManager> dialogManager;
     string keystroke = "";
@@ -76,6 +96,111 @@ int main(int argc, char** argv)
     cin >> keystroke;
     HandleKeystrokeOptions(*dialogManager, keystroke);
 
+    AsyncLogger::Instance().Flush();
+    fprintf(stdout, "Closing down and freeing variables.\n");
+
+    return 0;
+}
+
+int RunBatch(shared_ptr<AgentConfiguration> agentConfig, int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        log_t("--batch needs a directory of WAV files or a manifest listing them");
+        return 1;
+    }
+
+    BatchRunner::Options options;
+    for (int i = 4; i < argc; i++)
+    {
+        string option = argv[i];
+        if (option == "--concurrency" && i + 1 < argc)
+        {
+            options.concurrency = (size_t)max(atoi(argv[++i]), 1);
+        }
+        else if (option == "--local")
+        {
+            options.local = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0]))
+            {
+                options.localResponseDelay = chrono::milliseconds(atoi(argv[++i]));
+            }
+        }
+        else if (option == "--results" && i + 1 < argc)
+        {
+            options.resultsPath = argv[++i];
+        }
+        else
+        {
+            log_t("Unknown batch option: ", option);
+            return 1;
+        }
+    }
+
+    vector<string> inputs = BatchRunner::LoadInputs(argv[3]);
+    if (inputs.empty())
+    {
+        log_t("No WAV files found in ", argv[3]);
+        return 1;
+    }
+
+    BatchRunner runner(agentConfig, options);
+    return runner.Run(inputs) == 0 ? 0 : 1;
+}
+
+int RunHost(int argc, char** argv)
+{
+    vector<string> configFilePaths;
+    size_t dispatchThreads = 1;
+    for (int i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+        if (option == "--dispatch-threads" && i + 1 < argc)
+        {
+            dispatchThreads = (size_t)max(atoi(argv[++i]), 1);
+        }
+        else
+        {
+            configFilePaths.push_back(option);
+        }
+    }
+
+    if (configFilePaths.empty())
+    {
+        log_t("--host needs at least one configuration file");
+        return 1;
+    }
+
+    SessionHost host(dispatchThreads);
+    int result = host.Start(configFilePaths);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    string keystroke = "";
+    while (keystroke != "x")
+    {
+        // as in DisplayKeystrokeOptions, queued log lines go out before the menu
+        AsyncLogger::Instance().Flush();
+        fprintf(stdout, "Commands:\n");
+        fprintf(stdout, "r [report CPU and memory]\n");
+        fprintf(stdout, "t [write trace]\n");
+        fprintf(stdout, "x [exit]\n");
+        cin >> keystroke;
+        if (keystroke == "r")
+        {
+            host.Report();
+        }
+        if (keystroke == "t" && !host.Sessions().empty())
+        {
+            // the sessions share one tracer, so the first session's TraceFile gets all of them
+            host.Sessions().front().dialogManager->DumpTrace();
+        }
+    }
+
+    host.Report();
+    AsyncLogger::Instance().Flush();
     fprintf(stdout, "Closing down and freeing variables.\n");
 
     return 0;
@@ -83,6 +208,8 @@ int main(int argc, char** argv)
 
 void DisplayKeystrokeOptions(DialogManager& dialogManager)
 {
+    // log lines are written out by the logger's own thread, so let them go first to keep them above the menu
+    AsyncLogger::Instance().Flush();
     fprintf(stdout, "Commands:\n");
     fprintf(stdout, "1 [listen once]\n");
     fprintf(stdout, "2 [stop]\n");
@@ -92,6 +219,8 @@ void DisplayKeystrokeOptions(DialogManager& dialogManager)
         fprintf(stdout, "4 [start keyword listening]\n");
         fprintf(stdout, "5 [stop keyword listening]\n");
     }
+    fprintf(stdout, "6 [print turn latency timeline]\n");
+    fprintf(stdout, "7 [write trace]\n");
     fprintf(stdout, "x [exit]\n");
     if (dialogManager.IsMuted())
     {
@@ -124,6 +253,14 @@ void HandleKeystrokeOptions(DialogManager& dialogManager, string keystroke)
         {
             dialogManager.StopKws();
         }
+        if (keystroke == "6")
+        {
+            dialogManager.DumpTurnTimeline();
+        }
+        if (keystroke == "7")
+        {
+            dialogManager.DumpTrace();
+        }
         DisplayKeystrokeOptions(dialogManager);
     }
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "MappedAudioPlayerStream.h"
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef WINDOWS
+#include <Windows.h>
+#endif
+
+using namespace AudioPlayer;
+
+MappedAudioPlayerStream::MappedAudioPlayerStream(const std::string& filePath)
+{
+    if (!Map(filePath))
+    {
+        fprintf(stderr, "Failed to map audio file %s\n", filePath.c_str());
+        return;
+    }
+
+    m_parseResult = WavFile::ParseHeader(m_mapping, m_mappingSize, m_info);
+    if (m_parseResult != WavFile::WavParseResult::Success)
+    {
+        fprintf(stderr, "Failed to parse %s: %s\n", filePath.c_str(), WavFile::ToString(m_parseResult).c_str());
+        Unmap();
+        return;
+    }
+
+    m_data = m_mapping + m_info.dataOffset;
+}
+
+MappedAudioPlayerStream::~MappedAudioPlayerStream()
+{
+    Unmap();
+}
+
+#ifdef LINUX
+bool MappedAudioPlayerStream::Map(const std::string& filePath)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // MAP_POPULATE faults the pages in now so that playback does not take page faults per period
+    void* mapping = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(mapping, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+    m_mapping = (const unsigned char*)mapping;
+    m_mappingSize = (size_t)fileStat.st_size;
+    return true;
+}
+
+void MappedAudioPlayerStream::Unmap()
+{
+    if (m_mapping != nullptr)
+    {
+        munmap((void*)m_mapping, m_mappingSize);
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_data = nullptr;
+}
+#endif
+
+#ifdef WINDOWS
+bool MappedAudioPlayerStream::Map(const std::string& filePath)
+{
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_mapping = (const unsigned char*)view;
+    m_mappingSize = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedAudioPlayerStream::Unmap()
+{
+    if (m_mapping != nullptr)
+    {
+        UnmapViewOfFile(m_mapping);
+    }
+    if (m_mappingHandle != nullptr)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr)
+    {
+        CloseHandle(m_fileHandle);
+    }
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_data = nullptr;
+}
+#endif
+
+unsigned int MappedAudioPlayerStream::ReadSlice(const unsigned char** slice, size_t maxBytes)
+{
+    size_t bytes = std::min(maxBytes, Available());
+    *slice = bytes > 0 ? m_data + m_position : nullptr;
+    m_position += bytes;
+    return (unsigned int)bytes;
+}
+
+unsigned int MappedAudioPlayerStream::Read(unsigned char* buffer, size_t bufferSize)
+{
+    const unsigned char* slice;
+    unsigned int bytes = ReadSlice(&slice, bufferSize);
+    if (bytes > 0)
+    {
+        memcpy(buffer, slice, bytes);
+    }
+    return bytes;
+}
+
+unsigned int MappedAudioPlayerStream::TryRead(unsigned char* buffer, size_t bufferSize)
+{
+    // the whole file is in memory so a read never waits
+    return Read(buffer, bufferSize);
+}
+
+size_t MappedAudioPlayerStream::Available()
+{
+    return m_data == nullptr ? 0 : m_info.dataLength - m_position;
+}
+
+bool MappedAudioPlayerStream::IsEndOfStream()
+{
+    return Available() == 0;
+}
+
+void MappedAudioPlayerStream::SetReadyCallback(std::function<void()> callback)
+{
+    // always ready
+    if (callback)
+    {
+        callback();
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <thread>
+#include "PushPacer.h"
+
+using namespace std;
+
+constexpr uint32_t PushPacer::ChunkMs;
+constexpr double PushPacer::PushStreamBytesPerSecond;
+
+PushPacer::PushPacer(double speed)
+{
+    m_speed = speed;
+    m_start = chrono::steady_clock::now();
+}
+
+uint32_t PushPacer::InputBytesPerChunk(const WavFile::WavFormat& format)
+{
+    if (format.blockAlign == 0 || format.samplesPerSecond == 0)
+    {
+        // 20ms of the push stream's own format
+        return 640;
+    }
+    return max<uint32_t>(format.blockAlign * (format.samplesPerSecond * ChunkMs / 1000), 1);
+}
+
+void PushPacer::WaitForNextChunk()
+{
+    if (m_speed <= 0)
+    {
+        return;
+    }
+
+    auto due = m_start + chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>((double)m_pushedBytes / PushStreamBytesPerSecond / m_speed));
+    auto now = chrono::steady_clock::now();
+    if (now < due)
+    {
+        this_thread::sleep_until(due);
+        now = chrono::steady_clock::now();
+    }
+    m_maxLateness = max(m_maxLateness, now - due);
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "ResourceUsage.h"
+
+#ifdef LINUX
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef WINDOWS
+#include <Windows.h>
+#include <psapi.h>
+#endif
+
+using namespace std;
+
+#ifdef LINUX
+namespace
+{
+    chrono::microseconds ToMicroseconds(const timeval& time)
+    {
+        return chrono::seconds(time.tv_sec) + chrono::microseconds(time.tv_usec);
+    }
+}
+
+chrono::microseconds ResourceUsage::ProcessCpuTime()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return chrono::microseconds(0);
+    }
+    return ToMicroseconds(usage.ru_utime) + ToMicroseconds(usage.ru_stime);
+}
+
+chrono::microseconds ResourceUsage::ThreadCpuTime()
+{
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    {
+        return chrono::microseconds(0);
+    }
+    return chrono::duration_cast<chrono::microseconds>(chrono::seconds(time.tv_sec) + chrono::nanoseconds(time.tv_nsec));
+}
+
+uint64_t ResourceUsage::ResidentBytes()
+{
+    // the second field of statm is the resident set in pages
+    unsigned long long totalPages = 0;
+    unsigned long long residentPages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr)
+    {
+        return 0;
+    }
+    int fields = fscanf(statm, "%llu %llu", &totalPages, &residentPages);
+    fclose(statm);
+    if (fields != 2)
+    {
+        return 0;
+    }
+    return residentPages * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+uint64_t ResourceUsage::PeakResidentBytes()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    // reported in kilobytes on Linux
+    return (uint64_t)usage.ru_maxrss * 1024;
+}
+#endif
+
+#ifdef WINDOWS
+namespace
+{
+    chrono::microseconds ToMicroseconds(const FILETIME& time)
+    {
+        // FILETIME counts 100ns ticks
+        ULARGE_INTEGER ticks;
+        ticks.LowPart = time.dwLowDateTime;
+        ticks.HighPart = time.dwHighDateTime;
+        return chrono::microseconds(ticks.QuadPart / 10);
+    }
+}
+
+chrono::microseconds ResourceUsage::ProcessCpuTime()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return chrono::microseconds(0);
+    }
+    return ToMicroseconds(kernel) + ToMicroseconds(user);
+}
+
+chrono::microseconds ResourceUsage::ThreadCpuTime()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        return chrono::microseconds(0);
+    }
+    return ToMicroseconds(kernel) + ToMicroseconds(user);
+}
+
+uint64_t ResourceUsage::ResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+uint64_t ResourceUsage::PeakResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+#endif
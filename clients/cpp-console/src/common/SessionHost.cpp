@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "SessionHost.h"
+#include "AgentConfiguration.h"
+#include "DialogManager.h"
+#include "ResourceUsage.h"
+#include "log.h"
+
+using namespace std;
+
+namespace
+{
+    double ToMegabytes(uint64_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    // Sessions are named after their configuration file without its directory or extension.
+    string SessionNameFor(const string& configFilePath)
+    {
+        size_t start = configFilePath.find_last_of("/\\");
+        start = start == string::npos ? 0 : start + 1;
+        size_t end = configFilePath.find_last_of('.');
+        if (end == string::npos || end < start)
+        {
+            end = configFilePath.length();
+        }
+        return configFilePath.substr(start, end - start);
+    }
+}
+
+SessionHost::SessionHost(size_t dispatchThreads)
+{
+    m_dispatchPool = make_shared<DispatchPool>(dispatchThreads);
+}
+
+SessionHost::~SessionHost()
+{
+    // stop the sessions before the pool they dispatch on
+    m_sessions.clear();
+}
+
+int SessionHost::Start(const vector<string>& configFilePaths)
+{
+    vector<shared_ptr<AgentConfiguration>> configs;
+    for (auto& path : configFilePaths)
+    {
+        log_t("Loading configuration from file: ", path);
+        auto config = AgentConfiguration::LoadFromFile(path);
+        if (config->LoadResult() != AgentConfigurationLoadResult::Success)
+        {
+            log_t(path, ": ", config->LoadMessage());
+            return (int)config->LoadResult();
+        }
+        // the threshold is process wide, so the last configuration that sets one wins
+        if (!config->_logLevel.empty() && !log_set_level(config->_logLevel))
+        {
+            log_t(path, ": unknown log level ", config->_logLevel, ", logging at info");
+        }
+        configs.push_back(config);
+    }
+
+    m_started = chrono::steady_clock::now();
+    m_processCpuAtStart = ResourceUsage::ProcessCpuTime();
+    m_residentBytesAtStart = ResourceUsage::ResidentBytes();
+
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        Session session;
+        session.name = SessionNameFor(configFilePaths[i]);
+        for (auto& other : m_sessions)
+        {
+            if (other.name == session.name)
+            {
+                session.name += "#" + to_string(i);
+                break;
+            }
+        }
+
+        uint64_t residentBefore = ResourceUsage::ResidentBytes();
+        // tag the start up logging with the session too
+        log_session() = session.name;
+        session.dialogManager = make_shared<DialogManager>(configs[i], m_dispatchPool, session.name);
+        log_session().clear();
+        uint64_t residentAfter = ResourceUsage::ResidentBytes();
+        session.residentBytes = residentAfter > residentBefore ? residentAfter - residentBefore : 0;
+        m_sessions.push_back(session);
+    }
+
+    log_t("Started ", m_sessions.size(), " session(s) on ", m_dispatchPool->ThreadCount(), " dispatch thread(s)");
+    return 0;
+}
+
+void SessionHost::Report()
+{
+    uint64_t residentBytes = ResourceUsage::ResidentBytes();
+    auto processCpu = ResourceUsage::ProcessCpuTime() - m_processCpuAtStart;
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - m_started).count();
+
+    chrono::microseconds dispatchCpu{ 0 };
+    uint64_t events = 0;
+    for (auto& session : m_sessions)
+    {
+        auto sessionCpu = session.dialogManager->DispatchCpuTime();
+
+        log_t("Session ", session.name, ": ", session.dialogManager->EventsDispatched(), " events, dispatch CPU ",
+            sessionCpu.count() / 1000.0, "ms, ", ToMegabytes(session.residentBytes), "MB resident");
+        dispatchCpu += sessionCpu;
+        events += session.dialogManager->EventsDispatched();
+    }
+
+    log_t("All sessions: ", events, " events, dispatch CPU ", dispatchCpu.count() / 1000.0, "ms, process CPU ",
+        processCpu.count() / 1000.0, "ms (", wallSeconds > 0 ? 100.0 * processCpu.count() / 1e6 / wallSeconds : 0.0,
+        "% of a core) over ", wallSeconds, "s, of which ", (processCpu - dispatchCpu).count() / 1000.0, "ms outside dispatch");
+    log_t("Resident ", ToMegabytes(residentBytes), "MB, ", ToMegabytes(residentBytes - min(residentBytes, m_residentBytesAtStart)),
+        "MB for the sessions, peak ", ToMegabytes(ResourceUsage::PeakResidentBytes()), "MB, ", m_dispatchPool->TasksRun(), " dispatch tasks run");
+}
@@ -0,0 +1,201 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "AudioPlayerStreamImpl.h"
+#include "SpeechDialogService.h"
+#include "Tracer.h"
+
+using namespace std;
+using namespace Microsoft::CognitiveServices::Speech;
+using namespace Microsoft::CognitiveServices::Speech::Audio;
+using namespace Microsoft::CognitiveServices::Speech::Dialog;
+using namespace AudioPlayer;
+
+SpeechDialogService::SpeechDialogService(shared_ptr<DialogServiceConnector> connector, shared_ptr<PushAudioInputStream> pushStream)
+{
+    m_connector = connector;
+    m_pushStream = pushStream;
+    m_callbacks = make_shared<Callbacks>();
+    ConnectSignals();
+}
+
+SpeechDialogService::~SpeechDialogService()
+{
+    DisconnectSignals();
+    // waits for a callback in flight; one the SDK starts after this finds no handlers
+    SetHandlers(DialogServiceHandlers());
+    SetConnectionHandlers(nullptr, nullptr);
+}
+
+void SpeechDialogService::ConnectSignals()
+{
+    auto callbacks = m_callbacks;
+    m_connector->SessionStarted += [callbacks](const SessionEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.sessionStarted)
+        {
+            callbacks->handlers.sessionStarted(event.SessionId);
+        }
+    };
+    m_connector->SessionStopped += [callbacks](const SessionEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.sessionStopped)
+        {
+            callbacks->handlers.sessionStopped(event.SessionId);
+        }
+    };
+    m_connector->Recognizing += [callbacks](const SpeechRecognitionEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.recognizing)
+        {
+            callbacks->handlers.recognizing(event.Result->Reason, event.Result->Text);
+        }
+    };
+    m_connector->Recognized += [callbacks](const SpeechRecognitionEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.recognized)
+        {
+            callbacks->handlers.recognized(event.Result->Reason, event.Result->Text);
+        }
+    };
+    m_connector->Canceled += [callbacks](const SpeechRecognitionCanceledEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.canceled)
+        {
+            callbacks->handlers.canceled(event.Reason, event.ErrorDetails);
+        }
+    };
+    m_connector->ActivityReceived += [callbacks](const ActivityReceivedEventArgs& event)
+    {
+        lock_guard<mutex> lock(callbacks->mutex);
+        if (callbacks->handlers.activityReceived)
+        {
+            shared_ptr<IAudioPlayerStream> audio;
+            if (event.HasAudio())
+            {
+                audio = make_shared<AudioPlayerStreamImpl>(event.GetAudio());
+            }
+            callbacks->handlers.activityReceived(event.GetActivity(), audio);
+        }
+    };
+}
+
+void SpeechDialogService::DisconnectSignals()
+{
+    m_connector->SessionStarted.DisconnectAll();
+    m_connector->SessionStopped.DisconnectAll();
+    m_connector->Recognizing.DisconnectAll();
+    m_connector->Recognized.DisconnectAll();
+    m_connector->Canceled.DisconnectAll();
+    m_connector->ActivityReceived.DisconnectAll();
+    if (m_connection)
+    {
+        m_connection->Connected.DisconnectAll();
+        m_connection->Disconnected.DisconnectAll();
+    }
+}
+
+void SpeechDialogService::SetHandlers(const DialogServiceHandlers& handlers)
+{
+    lock_guard<mutex> lock(m_callbacks->mutex);
+    m_callbacks->handlers = handlers;
+}
+
+void SpeechDialogService::SetConnectionHandlers(function<void()> connected, function<void()> disconnected)
+{
+    if (!m_connection && (connected || disconnected))
+    {
+        m_connection = Connection::FromDialogServiceConnector(m_connector);
+        auto callbacks = m_callbacks;
+        m_connection->Connected += [callbacks](const ConnectionEventArgs&)
+        {
+            lock_guard<mutex> lock(callbacks->mutex);
+            if (callbacks->connected)
+            {
+                callbacks->connected();
+            }
+        };
+        m_connection->Disconnected += [callbacks](const ConnectionEventArgs&)
+        {
+            lock_guard<mutex> lock(callbacks->mutex);
+            if (callbacks->disconnected)
+            {
+                callbacks->disconnected();
+            }
+        };
+    }
+
+    lock_guard<mutex> lock(m_callbacks->mutex);
+    m_callbacks->connected = std::move(connected);
+    m_callbacks->disconnected = std::move(disconnected);
+}
+
+void SpeechDialogService::Connect()
+{
+    TraceSpan span("connector", "Connect");
+    auto future = m_connector->ConnectAsync();
+}
+
+void SpeechDialogService::Disconnect()
+{
+    TraceSpan span("connector", "Disconnect");
+    auto future = m_connector->DisconnectAsync();
+}
+
+void SpeechDialogService::ListenOnce()
+{
+    TraceSpan span("connector", "ListenOnce");
+    lock_guard<mutex> lock(m_listenMutex);
+    m_listen = m_connector->ListenOnceAsync();
+}
+
+void SpeechDialogService::StartKeywordRecognition(const string& modelPath)
+{
+    TraceSpan span("connector", "StartKeywordRecognition");
+    shared_ptr<KeywordRecognitionModel> model;
+    {
+        TraceSpan loadSpan("connector", "LoadKeywordModel");
+        model = KeywordModelCache().Get(modelPath);
+    }
+    auto future = m_connector->StartKeywordRecognitionAsync(model);
+}
+
+FileCache<KeywordRecognitionModel>& SpeechDialogService::KeywordModelCache()
+{
+    static FileCache<KeywordRecognitionModel> cache([](const string& path) { return KeywordRecognitionModel::FromFile(path); });
+    return cache;
+}
+
+void SpeechDialogService::StopKeywordRecognition()
+{
+    TraceSpan span("connector", "StopKeywordRecognition");
+    auto future = m_connector->StopKeywordRecognitionAsync();
+}
+
+void SpeechDialogService::SendActivity(const string& activity)
+{
+    TraceSpan span("connector", "SendActivity");
+    auto future = m_connector->SendActivityAsync(activity);
+}
+
+void SpeechDialogService::WriteAudio(const uint8_t* data, uint32_t size)
+{
+    if (m_pushStream)
+    {
+        m_pushStream->Write(const_cast<uint8_t*>(data), size);
+    }
+}
+
+void SpeechDialogService::CloseAudio()
+{
+    TraceSpan span("connector", "CloseAudio");
+    if (m_pushStream)
+    {
+        m_pushStream->Close();
+    }
+}
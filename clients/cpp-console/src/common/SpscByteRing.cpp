@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "SpscByteRing.h"
+
+using namespace AudioPlayer;
+
+SpscByteRing::SpscByteRing(PooledBuffer storage) : m_storage(std::move(storage))
+{
+    size_t capacity = 1;
+    while (capacity * 2 <= m_storage.Capacity())
+    {
+        capacity *= 2;
+    }
+    m_mask = m_storage.Capacity() == 0 ? 0 : capacity - 1;
+}
+
+bool SpscByteRing::Write(const unsigned char* data, size_t size)
+{
+    size_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+    size_t readPosition = m_readPosition.load(std::memory_order_acquire);
+
+    if (m_storage.Capacity() == 0 || size > Capacity() - (writePosition - readPosition))
+    {
+        return false;
+    }
+
+    size_t index = writePosition & m_mask;
+    size_t firstPart = std::min(size, Capacity() - index);
+    memcpy(m_storage.Data() + index, data, firstPart);
+    memcpy(m_storage.Data(), data + firstPart, size - firstPart);
+
+    m_writePosition.store(writePosition + size, std::memory_order_release);
+    return true;
+}
+
+size_t SpscByteRing::ReadableRegion(const unsigned char** region) const
+{
+    size_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+    size_t writePosition = m_writePosition.load(std::memory_order_acquire);
+
+    size_t index = readPosition & m_mask;
+    *region = m_storage.Data() + index;
+    return std::min(writePosition - readPosition, Capacity() - index);
+}
+
+void SpscByteRing::Consume(size_t size)
+{
+    m_readPosition.store(m_readPosition.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t SpscByteRing::Size() const
+{
+    return m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire);
+}
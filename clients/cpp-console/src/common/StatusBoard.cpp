@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstring>
+#include "StatusBoard.h"
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef WINDOWS
+#include <Windows.h>
+#endif
+
+using namespace std;
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t) && alignof(atomic<uint32_t>) == alignof(uint32_t),
+    "the sequence is shared with C readers as a plain uint32_t");
+
+StatusBoard::~StatusBoard()
+{
+    Close();
+}
+
+atomic<uint32_t>& StatusBoard::Sequence()
+{
+    return *reinterpret_cast<atomic<uint32_t>*>(&m_segment->sequence);
+}
+
+void StatusBoard::Update(const function<void(StatusBoardFields& fields)>& change)
+{
+    lock_guard<mutex> lock(m_writeMutex);
+    if (m_segment == nullptr)
+    {
+        return;
+    }
+
+    change(m_fields);
+    m_fields.updatedUs = NowMicroseconds();
+
+    auto& sequence = Sequence();
+    uint32_t start = sequence.load(memory_order_relaxed);
+    sequence.store(start + 1, memory_order_relaxed);
+    // keeps the field stores from moving above the odd sequence
+    atomic_thread_fence(memory_order_release);
+    memcpy(&m_segment->fields, &m_fields, sizeof(m_fields));
+    sequence.store(start + 2, memory_order_release);
+}
+
+uint64_t StatusBoard::ToMicroseconds(chrono::steady_clock::time_point time)
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux and QueryPerformanceCounter on Windows, the clocks readers use
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+uint64_t StatusBoard::NowMicroseconds()
+{
+    return ToMicroseconds(chrono::steady_clock::now());
+}
+
+#ifdef LINUX
+int StatusBoard::Open(const string& name)
+{
+    Close();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(StatusBoardSegment)) != 0)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return -1;
+    }
+    void* mapped = mmap(nullptr, sizeof(StatusBoardSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return -1;
+    }
+
+    m_name = name;
+    m_segment = static_cast<StatusBoardSegment*>(mapped);
+    m_segment->magic = STATUS_BOARD_MAGIC;
+    m_segment->version = STATUS_BOARD_VERSION;
+    m_segment->fieldsSize = sizeof(StatusBoardFields);
+    m_segment->writerPid = (uint32_t)getpid();
+    // a segment left behind by a writer that died mid update has an odd sequence; even it out
+    Sequence().store((Sequence().load() + 1) & ~1u);
+    Update([](StatusBoardFields& fields) {});
+    return 0;
+}
+
+void StatusBoard::Close()
+{
+    lock_guard<mutex> lock(m_writeMutex);
+    if (m_segment != nullptr)
+    {
+        munmap(m_segment, sizeof(StatusBoardSegment));
+        shm_unlink(m_name.c_str());
+        m_segment = nullptr;
+    }
+}
+#endif
+
+#ifdef WINDOWS
+int StatusBoard::Open(const string& name)
+{
+    Close();
+
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(StatusBoardSegment), name.c_str());
+    if (mapping == nullptr)
+    {
+        return -1;
+    }
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StatusBoardSegment));
+    if (mapped == nullptr)
+    {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    m_name = name;
+    m_mapping = mapping;
+    m_segment = static_cast<StatusBoardSegment*>(mapped);
+    m_segment->magic = STATUS_BOARD_MAGIC;
+    m_segment->version = STATUS_BOARD_VERSION;
+    m_segment->fieldsSize = sizeof(StatusBoardFields);
+    m_segment->writerPid = (uint32_t)GetCurrentProcessId();
+    Sequence().store((Sequence().load() + 1) & ~1u);
+    Update([](StatusBoardFields& fields) {});
+    return 0;
+}
+
+void StatusBoard::Close()
+{
+    lock_guard<mutex> lock(m_writeMutex);
+    if (m_segment != nullptr)
+    {
+        UnmapViewOfFile(m_segment);
+        CloseHandle((HANDLE)m_mapping);
+        m_segment = nullptr;
+        m_mapping = nullptr;
+    }
+}
+#endif
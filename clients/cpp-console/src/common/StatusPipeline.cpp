@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "StatusPipeline.h"
+#include "Tracer.h"
+
+using namespace std;
+
+StatusPipeline::StatusPipeline(chrono::milliseconds coalesceWindow, Indicator indicator)
+{
+    m_coalesceWindow = coalesceWindow;
+    m_indicator = indicator ? indicator : [](DeviceStatus status, bool muted) { DeviceStatusIndicators::SetStatus(status, muted); };
+    m_deliveryThread = thread(&StatusPipeline::DeliveryThreadMain, this);
+}
+
+StatusPipeline::~StatusPipeline()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_updated.notify_one();
+    m_deliveryThread.join();
+}
+
+void StatusPipeline::Post(DeviceStatus status, bool muted)
+{
+    Update update;
+    update.status = status;
+    update.muted = muted;
+    update.posted = chrono::steady_clock::now();
+    Tracer::Instance().Instant("status", "Post", update.posted);
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_hasPosted && update.SameAs(m_lastPosted))
+        {
+            m_suppressed++;
+            return;
+        }
+        if (m_hasPending)
+        {
+            // the status it would have shown is replaced before anyone saw it
+            m_suppressed++;
+        }
+        m_lastPosted = update;
+        m_hasPosted = true;
+        m_pending = update;
+        m_hasPending = true;
+    }
+    m_updated.notify_one();
+}
+
+void StatusPipeline::DeliveryThreadMain()
+{
+    Tracer::Instance().SetThreadName("status");
+    Update shown;
+    bool hasShown = false;
+    auto windowEnd = chrono::steady_clock::time_point::min();
+
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_updated.wait(lock, [this] { return m_hasPending || m_stopping; });
+        if (!m_hasPending)
+        {
+            return;
+        }
+
+        // hold changes that follow a delivery closely so a burst ends up as one delivery of its latest status
+        if (!m_stopping && chrono::steady_clock::now() < windowEnd)
+        {
+            m_updated.wait_until(lock, windowEnd, [this] { return m_stopping; });
+        }
+
+        Update update = m_pending;
+        m_hasPending = false;
+        if (hasShown && update.SameAs(shown))
+        {
+            // the burst came back to what is already shown, e.g. Detecting, Listening, Detecting
+            m_suppressed++;
+            continue;
+        }
+
+        lock.unlock();
+        {
+            TraceSpan span("status", "Indicate");
+            m_indicator(update.status, update.muted);
+        }
+        auto delivered = chrono::steady_clock::now();
+        m_indicatorLatency.Record(delivered - update.posted);
+        m_delivered++;
+        shown = update;
+        hasShown = true;
+        windowEnd = delivered + m_coalesceWindow;
+        lock.lock();
+    }
+}
@@ -0,0 +1,247 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include "Tracer.h"
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+#ifdef LINUX
+#include <unistd.h>
+#endif
+
+#ifdef WINDOWS
+#include <Windows.h>
+#endif
+
+using namespace std;
+
+constexpr size_t Tracer::EventsPerThread;
+constexpr size_t Tracer::MaxThreads;
+
+namespace
+{
+    int64_t Microseconds(chrono::steady_clock::time_point at)
+    {
+        return chrono::duration_cast<chrono::microseconds>(at.time_since_epoch()).count();
+    }
+
+    uint32_t ProcessId()
+    {
+#ifdef LINUX
+        return (uint32_t)getpid();
+#elif defined(WINDOWS)
+        return (uint32_t)GetCurrentProcessId();
+#else
+        return 0;
+#endif
+    }
+
+    // Kept apart from the ring so naming a thread does not allocate one while tracing is off.
+    thread_local const char* t_threadName = nullptr;
+}
+
+Tracer& Tracer::Instance()
+{
+    // never destroyed, so threads still running at exit can keep recording
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+}
+
+Tracer::RingOwner::~RingOwner()
+{
+    if (ring != nullptr)
+    {
+        Tracer::Instance().ReleaseRing(ring);
+    }
+}
+
+Tracer::Ring*& Tracer::CurrentRing()
+{
+    static thread_local RingOwner owner;
+    return owner.ring;
+}
+
+Tracer::Ring* Tracer::ThreadRing()
+{
+    // nullptr until the thread's first event, then its ring, or nullptr for good if there were none left
+    Ring*& ring = CurrentRing();
+    static thread_local bool outOfRings = false;
+    if (ring != nullptr || outOfRings)
+    {
+        return ring;
+    }
+
+    lock_guard<mutex> lock(m_ringsMutex);
+    if (!m_freeRings.empty())
+    {
+        // the head carries on from the exited thread's last event, so every index keeps a sequence of its own
+        ring = m_freeRings.back();
+        m_freeRings.pop_back();
+        ring->first.store(ring->head.load(memory_order_relaxed), memory_order_relaxed);
+    }
+    else if (m_rings.size() < MaxThreads)
+    {
+        unique_ptr<Ring> newRing(new Ring());
+        newRing->events.reset(new Event[EventsPerThread]);
+        ring = newRing.get();
+        m_rings.push_back(std::move(newRing));
+    }
+    else
+    {
+        outOfRings = true;
+        return nullptr;
+    }
+    ring->threadId.store(++m_lastThreadId, memory_order_relaxed);
+    ring->threadName.store(t_threadName, memory_order_relaxed);
+    return ring;
+}
+
+void Tracer::ReleaseRing(Ring* ring)
+{
+    lock_guard<mutex> lock(m_ringsMutex);
+    m_freeRings.push_back(ring);
+}
+
+void Tracer::Record(const char* category, const char* name, int64_t start, int64_t duration)
+{
+    Ring* ring = ThreadRing();
+    if (ring == nullptr)
+    {
+        m_eventsDropped++;
+        return;
+    }
+
+    // only this thread writes the ring, so the head needs no read-modify-write
+    uint64_t index = ring->head.load(memory_order_relaxed);
+    Event& event = ring->events[index % EventsPerThread];
+    event.sequence.store(2 * index + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event.category.store(category, memory_order_relaxed);
+    event.name.store(name, memory_order_relaxed);
+    event.start.store(start, memory_order_relaxed);
+    event.duration.store(duration, memory_order_relaxed);
+    event.sequence.store(2 * index + 2, memory_order_release);
+    ring->head.store(index + 1, memory_order_release);
+}
+
+void Tracer::Complete(const char* category, const char* name, chrono::steady_clock::time_point start,
+    chrono::steady_clock::time_point end)
+{
+    if (Enabled())
+    {
+        Record(category, name, Microseconds(start), chrono::duration_cast<chrono::microseconds>(end - start).count());
+    }
+}
+
+void Tracer::Instant(const char* category, const char* name, chrono::steady_clock::time_point at)
+{
+    if (Enabled())
+    {
+        Record(category, name, Microseconds(at), -1);
+    }
+}
+
+void Tracer::SetThreadName(const char* name)
+{
+    t_threadName = name;
+    Ring* ring = CurrentRing();
+    if (ring != nullptr)
+    {
+        ring->threadName.store(name, memory_order_relaxed);
+    }
+}
+
+uint64_t Tracer::EventsRecorded()
+{
+    lock_guard<mutex> lock(m_ringsMutex);
+    uint64_t recorded = 0;
+    for (auto& ring : m_rings)
+    {
+        recorded += ring->head.load();
+    }
+    return recorded;
+}
+
+string Tracer::ToChromeTraceJson()
+{
+    vector<Ring*> rings;
+    {
+        lock_guard<mutex> lock(m_ringsMutex);
+        for (auto& ring : m_rings)
+        {
+            rings.push_back(ring.get());
+        }
+    }
+
+    uint32_t pid = ProcessId();
+    nlohmann::json events = nlohmann::json::array();
+    for (Ring* ring : rings)
+    {
+        uint32_t threadId = ring->threadId.load(memory_order_relaxed);
+        const char* threadName = ring->threadName.load(memory_order_relaxed);
+        if (threadName != nullptr)
+        {
+            events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", pid }, { "tid", threadId },
+                { "args", { { "name", threadName } } } });
+        }
+
+        uint64_t head = ring->head.load(memory_order_acquire);
+        uint64_t first = max(ring->first.load(memory_order_relaxed), head > EventsPerThread ? head - EventsPerThread : 0);
+        for (uint64_t index = first; index < head; index++)
+        {
+            Event& event = ring->events[index % EventsPerThread];
+            uint64_t sequence = event.sequence.load(memory_order_acquire);
+            if (sequence != 2 * index + 2)
+            {
+                // already overwritten by a newer event
+                continue;
+            }
+            const char* category = event.category.load(memory_order_relaxed);
+            const char* name = event.name.load(memory_order_relaxed);
+            int64_t start = event.start.load(memory_order_relaxed);
+            int64_t duration = event.duration.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (event.sequence.load(memory_order_relaxed) != sequence)
+            {
+                continue;
+            }
+
+            nlohmann::json traceEvent = { { "name", name }, { "cat", category }, { "ts", start }, { "pid", pid }, { "tid", threadId } };
+            if (duration < 0)
+            {
+                traceEvent["ph"] = "i";
+                traceEvent["s"] = "t";
+            }
+            else
+            {
+                traceEvent["ph"] = "X";
+                traceEvent["dur"] = duration;
+            }
+            events.push_back(std::move(traceEvent));
+        }
+    }
+
+    nlohmann::json trace = { { "traceEvents", std::move(events) }, { "displayTimeUnit", "ms" } };
+    return trace.dump();
+}
+
+int Tracer::WriteChromeTrace(const string& path)
+{
+    ofstream out(path, ios::out | ios::trunc);
+    if (!out)
+    {
+        return -1;
+    }
+    out << ToChromeTraceJson();
+    return out.good() ? 0 : -1;
+}
@@ -0,0 +1,270 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <algorithm>
+#include <chrono>
+#include <experimental/filesystem>
+#include <utility>
+#include "log.h"
+#include "TtsRecorder.h"
+
+#ifdef LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef WINDOWS
+#include <Windows.h>
+#endif
+
+using namespace AudioPlayer;
+
+namespace
+{
+    // How often the writer wakes up to drain the rings. A turn ring holds about a second of audio at 16khz.
+    constexpr int WriterIntervalMilliseconds = 20;
+
+    std::string SanitizeFileName(const std::string& name)
+    {
+        std::string result = name;
+        for (auto& c : result)
+        {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+            if (!valid)
+            {
+                c = '_';
+            }
+        }
+        return result;
+    }
+
+    // Lowers both the CPU and the I/O priority of the calling thread so recording never competes with playback.
+    void LowerCurrentThreadPriority()
+    {
+#ifdef LINUX
+        // on Linux the nice value is per thread and also lowers the thread's I/O priority
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+#endif
+#ifdef WINDOWS
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+    }
+}
+
+TtsRecorder::Turn::Turn(const std::string& path, PooledBuffer ringStorage) : m_path(path), m_ring(std::move(ringStorage))
+{
+}
+
+void TtsRecorder::Turn::Write(const unsigned char* data, size_t size)
+{
+    if (size > 0 && !m_ring.Write(data, size))
+    {
+        m_droppedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+TtsRecorder::TtsRecorder(const std::string& directory, const WavFile::WavFormat& format)
+{
+    m_directory = directory;
+    m_format = format;
+
+    std::error_code error;
+    std::experimental::filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        fprintf(stderr, "TtsRecorder: unable to create %s: %s\n", m_directory.c_str(), error.message().c_str());
+    }
+
+    m_writer = std::thread(&TtsRecorder::WriterThreadMain, this);
+}
+
+TtsRecorder::~TtsRecorder()
+{
+    m_stopping = true;
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+}
+
+std::shared_ptr<TtsRecorder::Turn> TtsRecorder::StartTurn(const std::string& sessionId, const std::string& activityId)
+{
+    std::lock_guard<std::mutex> lock(m_turnsMutex);
+    m_turnCount++;
+
+    std::string name = SanitizeFileName(sessionId.empty() ? "nosession" : sessionId) + "_" +
+        SanitizeFileName(activityId.empty() ? "turn" + std::to_string(m_turnCount) : activityId);
+
+    auto turn = std::make_shared<Turn>(m_directory + "/" + name + ".wav", AudioBufferPool::ChunkPool().Acquire());
+    m_turns.push_back(turn);
+    return turn;
+}
+
+WavFile::WavFormat TtsRecorder::DefaultFormat()
+{
+    WavFile::WavFormat format;
+    format.formatTag = WavFile::FormatPcm;
+    format.channels = 1;
+    format.samplesPerSecond = 16000;
+    format.bitsPerSample = 16;
+    format.blockAlign = 2;
+    format.averageBytesPerSecond = 32000;
+    return format;
+}
+
+void TtsRecorder::WriterThreadMain()
+{
+    LowerCurrentThreadPriority();
+
+    bool stopping = false;
+    while (!stopping)
+    {
+        // read the flag before draining so the final pass sees everything written before the destructor ran
+        stopping = m_stopping.load();
+
+        {
+            std::lock_guard<std::mutex> lock(m_turnsMutex);
+            m_writerTurns.assign(m_turns.begin(), m_turns.end());
+        }
+
+        for (auto& turn : m_writerTurns)
+        {
+            // check for the end before draining so no audio written before Finish is left behind
+            bool finished = turn->m_finished.load(std::memory_order_acquire);
+            Drain(*turn);
+            if (finished || stopping)
+            {
+                Close(*turn);
+                std::lock_guard<std::mutex> lock(m_turnsMutex);
+                m_turns.erase(std::find(m_turns.begin(), m_turns.end(), turn));
+            }
+        }
+        m_writerTurns.clear();
+
+        if (!stopping)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(WriterIntervalMilliseconds));
+        }
+    }
+}
+
+void TtsRecorder::Drain(Turn& turn)
+{
+    if (turn.m_file == nullptr && !turn.m_failed)
+    {
+        turn.m_file = fopen(turn.m_path.c_str(), "wb");
+        if (turn.m_file == nullptr)
+        {
+            fprintf(stderr, "TtsRecorder: unable to create %s\n", turn.m_path.c_str());
+            turn.m_failed = true;
+        }
+        else
+        {
+            // the lengths are filled in when the turn is closed
+            unsigned char header[WavFile::CanonicalHeaderSize];
+            WavFile::WriteHeader(m_format, 0, header);
+            fwrite(header, 1, sizeof(header), turn.m_file);
+        }
+    }
+
+    const unsigned char* region;
+    size_t length;
+    while ((length = turn.m_ring.ReadableRegion(&region)) > 0)
+    {
+        if (turn.m_file != nullptr)
+        {
+            turn.m_bytesWritten += (uint32_t)fwrite(region, 1, length, turn.m_file);
+        }
+        turn.m_ring.Consume(length);
+    }
+}
+
+void TtsRecorder::Close(Turn& turn)
+{
+    uint64_t dropped = turn.DroppedBytes();
+    m_droppedBytes += dropped;
+
+    if (turn.m_file == nullptr)
+    {
+        return;
+    }
+
+    unsigned char header[WavFile::CanonicalHeaderSize];
+    WavFile::WriteHeader(m_format, turn.m_bytesWritten, header);
+    fseek(turn.m_file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), turn.m_file);
+    fclose(turn.m_file);
+    turn.m_file = nullptr;
+    m_recordedTurns++;
+
+    log_t("Recorded TTS to ", turn.m_path, " (", turn.m_bytesWritten, " bytes, ", dropped, " bytes dropped)");
+}
+
+TeeAudioPlayerStream::TeeAudioPlayerStream(std::shared_ptr<IAudioPlayerStream> source, std::shared_ptr<TtsRecorder::Turn> turn)
+{
+    m_source = source;
+    m_turn = turn;
+}
+
+TeeAudioPlayerStream::~TeeAudioPlayerStream()
+{
+    m_turn->Finish();
+}
+
+unsigned int TeeAudioPlayerStream::Record(const unsigned char* data, unsigned int size)
+{
+    m_turn->Write(data, size);
+    if (m_source->IsEndOfStream())
+    {
+        m_turn->Finish();
+    }
+    return size;
+}
+
+unsigned int TeeAudioPlayerStream::Read(unsigned char* buffer, size_t bufferSize)
+{
+    return Record(buffer, m_source->Read(buffer, bufferSize));
+}
+
+unsigned int TeeAudioPlayerStream::TryRead(unsigned char* buffer, size_t bufferSize)
+{
+    return Record(buffer, m_source->TryRead(buffer, bufferSize));
+}
+
+size_t TeeAudioPlayerStream::Available()
+{
+    return m_source->Available();
+}
+
+bool TeeAudioPlayerStream::IsEndOfStream()
+{
+    return m_source->IsEndOfStream();
+}
+
+bool TeeAudioPlayerStream::IsFullyBuffered()
+{
+    return m_source->IsFullyBuffered();
+}
+
+void TeeAudioPlayerStream::SetReadyCallback(std::function<void()> callback)
+{
+    m_source->SetReadyCallback(callback);
+}
+
+bool TeeAudioPlayerStream::SupportsSlices()
+{
+    return m_source->SupportsSlices();
+}
+
+unsigned int TeeAudioPlayerStream::ReadSlice(const unsigned char** slice, size_t maxBytes)
+{
+    unsigned int size = m_source->ReadSlice(slice, maxBytes);
+    return Record(*slice, size);
+}
+
+void TeeAudioPlayerStream::Discard()
+{
+    m_source->Discard();
+}
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include "TurnTracker.h"
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+using namespace std;
+
+constexpr size_t TurnTracker::StageCount;
+
+namespace
+{
+    nlohmann::json HistogramJson(const LatencyHistogram& histogram)
+    {
+        return nlohmann::json
+        {
+            { "count", histogram.Count() },
+            { "min", histogram.Min() },
+            { "mean", histogram.Mean() },
+            { "p50", histogram.Percentile(50.0) },
+            { "p90", histogram.Percentile(90.0) },
+            { "p99", histogram.Percentile(99.0) },
+            { "max", histogram.Max() }
+        };
+    }
+}
+
+uint64_t TurnTracker::StartTurn(chrono::steady_clock::time_point at)
+{
+    // bump the turn first so late marks for the old turn are dropped rather than landing in this one
+    uint64_t turn = ++m_turn;
+    for (size_t i = 1; i < StageCount; i++)
+    {
+        m_marks[i] = 0;
+    }
+    m_marks[0] = at.time_since_epoch().count();
+    return turn;
+}
+
+bool TurnTracker::Mark(Stage stage, chrono::steady_clock::time_point at)
+{
+    return Mark(m_turn.load(), stage, at);
+}
+
+bool TurnTracker::Mark(uint64_t turn, Stage stage, chrono::steady_clock::time_point at)
+{
+    size_t index = (size_t)stage;
+    if (turn == 0 || turn != m_turn.load() || index == 0)
+    {
+        return false;
+    }
+
+    int64_t ticks = at.time_since_epoch().count();
+    int64_t expected = 0;
+    if (!m_marks[index].compare_exchange_strong(expected, ticks))
+    {
+        return false;
+    }
+
+    int64_t start = m_marks[0];
+    int64_t previous = start;
+    for (size_t i = index - 1; i > 0; i--)
+    {
+        int64_t mark = m_marks[i];
+        if (mark != 0)
+        {
+            previous = mark;
+            break;
+        }
+    }
+
+    // a stage can land before its predecessor, e.g. first audible is estimated ahead of time, so clamp at zero
+    auto sinceStart = chrono::steady_clock::duration(max<int64_t>(ticks - start, 0));
+    auto sincePrevious = chrono::steady_clock::duration(max<int64_t>(ticks - previous, 0));
+    m_sinceTurnStart[index].Record(sinceStart);
+    m_sincePreviousStage[index].Record(sincePrevious);
+    return true;
+}
+
+chrono::steady_clock::duration TurnTracker::Elapsed(uint64_t turn, chrono::steady_clock::time_point at) const
+{
+    int64_t start = m_marks[0];
+    if (turn == 0 || turn != m_turn.load() || start == 0)
+    {
+        return chrono::steady_clock::duration::zero();
+    }
+    return chrono::steady_clock::duration(max<int64_t>(at.time_since_epoch().count() - start, 0));
+}
+
+const char* TurnTracker::StageName(Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::TurnStarted: return "turnStarted";
+    case Stage::FirstRecognizing: return "firstRecognizing";
+    case Stage::FinalRecognized: return "finalRecognized";
+    case Stage::FirstActivity: return "firstActivity";
+    case Stage::FirstAudioByte: return "firstAudioByte";
+    case Stage::FirstAudible: return "firstAudible";
+    case Stage::PlaybackEnded: return "playbackEnded";
+    }
+    return "unknown";
+}
+
+string TurnTracker::ToJson() const
+{
+    nlohmann::json stages = nlohmann::json::array();
+    for (size_t i = 1; i < StageCount; i++)
+    {
+        stages.push_back(
+            {
+                { "stage", StageName((Stage)i) },
+                { "sinceTurnStartUs", HistogramJson(m_sinceTurnStart[i]) },
+                { "sincePreviousStageUs", HistogramJson(m_sincePreviousStage[i]) }
+            });
+    }
+
+    nlohmann::json timeline =
+    {
+        { "turns", m_turn.load() },
+        { "stages", stages }
+    };
+    return timeline.dump(2);
+}
@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstring>
+#include "WavHeader.h"
+
+using namespace WavFile;
+
+namespace
+{
+    uint16_t ReadUInt16(const unsigned char* p)
+    {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    uint32_t ReadUInt32(const unsigned char* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    void WriteUInt16(unsigned char* p, uint16_t value)
+    {
+        p[0] = (unsigned char)(value & 0xFF);
+        p[1] = (unsigned char)(value >> 8);
+    }
+
+    void WriteUInt32(unsigned char* p, uint32_t value)
+    {
+        WriteUInt16(p, (uint16_t)(value & 0xFFFF));
+        WriteUInt16(p + 2, (uint16_t)(value >> 16));
+    }
+}
+
+WavParseResult WavFile::ParseHeader(const unsigned char* data, size_t size, WavFileInfo& info)
+{
+    if (size < 12)
+    {
+        return WavParseResult::Truncated;
+    }
+    if (memcmp(data, "RIFF", 4) != 0)
+    {
+        return WavParseResult::NotRiff;
+    }
+    if (memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return WavParseResult::NotWave;
+    }
+
+    bool foundFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        const unsigned char* chunk = data + offset;
+        uint32_t chunkSize = ReadUInt32(chunk + 4);
+        size_t body = offset + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16 || body + 16 > size)
+            {
+                return WavParseResult::Truncated;
+            }
+            info.format.formatTag = ReadUInt16(chunk + 8);
+            info.format.channels = ReadUInt16(chunk + 10);
+            info.format.samplesPerSecond = ReadUInt32(chunk + 12);
+            info.format.averageBytesPerSecond = ReadUInt32(chunk + 16);
+            info.format.blockAlign = ReadUInt16(chunk + 20);
+            info.format.bitsPerSample = ReadUInt16(chunk + 22);
+
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the first two bytes of the sub format GUID
+            if (info.format.formatTag == FormatExtensible && chunkSize >= 40 && body + 40 <= size)
+            {
+                info.format.formatTag = ReadUInt16(chunk + 32);
+            }
+            foundFormat = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!foundFormat)
+            {
+                return WavParseResult::MissingFormat;
+            }
+            info.dataOffset = body;
+            // recordings that were never finalized often carry a zero or maximum size, so trust the file length
+            info.dataLength = (chunkSize == 0 || body + chunkSize > size) ? size - body : chunkSize;
+            return WavParseResult::Success;
+        }
+
+        // chunks are padded to an even number of bytes
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    return foundFormat ? WavParseResult::MissingData : WavParseResult::MissingFormat;
+}
+
+WavParseResult WavFile::ReadHeader(std::istream& stream, WavFileInfo& info)
+{
+    unsigned char header[40];
+    if (!stream.read((char*)header, 12))
+    {
+        return WavParseResult::Truncated;
+    }
+    if (memcmp(header, "RIFF", 4) != 0)
+    {
+        return WavParseResult::NotRiff;
+    }
+    if (memcmp(header + 8, "WAVE", 4) != 0)
+    {
+        return WavParseResult::NotWave;
+    }
+
+    bool foundFormat = false;
+    while (stream.read((char*)header, 8))
+    {
+        uint32_t chunkSize = ReadUInt32(header + 4);
+        uint32_t paddedSize = chunkSize + (chunkSize & 1);
+
+        if (memcmp(header, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16)
+            {
+                return WavParseResult::Truncated;
+            }
+            uint32_t toRead = chunkSize < sizeof(header) ? chunkSize : (uint32_t)sizeof(header);
+            if (!stream.read((char*)header, toRead))
+            {
+                return WavParseResult::Truncated;
+            }
+            info.format.formatTag = ReadUInt16(header);
+            info.format.channels = ReadUInt16(header + 2);
+            info.format.samplesPerSecond = ReadUInt32(header + 4);
+            info.format.averageBytesPerSecond = ReadUInt32(header + 8);
+            info.format.blockAlign = ReadUInt16(header + 12);
+            info.format.bitsPerSample = ReadUInt16(header + 14);
+            if (info.format.formatTag == FormatExtensible && toRead >= 40)
+            {
+                info.format.formatTag = ReadUInt16(header + 24);
+            }
+            stream.seekg(paddedSize - toRead, std::ios_base::cur);
+            foundFormat = true;
+        }
+        else if (memcmp(header, "data", 4) == 0)
+        {
+            if (!foundFormat)
+            {
+                return WavParseResult::MissingFormat;
+            }
+            info.dataOffset = (size_t)stream.tellg();
+            info.dataLength = chunkSize == 0xFFFFFFFF ? 0 : chunkSize;
+            return WavParseResult::Success;
+        }
+        else
+        {
+            stream.seekg(paddedSize, std::ios_base::cur);
+        }
+    }
+
+    return foundFormat ? WavParseResult::MissingData : WavParseResult::MissingFormat;
+}
+
+void WavFile::WriteHeader(const WavFormat& format, uint32_t dataLength, unsigned char* header)
+{
+    memcpy(header, "RIFF", 4);
+    WriteUInt32(header + 4, (uint32_t)(CanonicalHeaderSize - 8 + dataLength));
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + 12, "fmt ", 4);
+    WriteUInt32(header + 16, 16);
+    WriteUInt16(header + 20, format.formatTag);
+    WriteUInt16(header + 22, format.channels);
+    WriteUInt32(header + 24, format.samplesPerSecond);
+    WriteUInt32(header + 28, format.averageBytesPerSecond);
+    WriteUInt16(header + 32, format.blockAlign);
+    WriteUInt16(header + 34, format.bitsPerSample);
+
+    memcpy(header + 36, "data", 4);
+    WriteUInt32(header + 40, dataLength);
+}
+
+std::string WavFile::ToString(WavParseResult result)
+{
+    switch (result)
+    {
+    case WavParseResult::Success:
+        return "Success";
+    case WavParseResult::NotRiff:
+        return "File is not a RIFF file.";
+    case WavParseResult::NotWave:
+        return "RIFF file is not a WAVE file.";
+    case WavParseResult::MissingFormat:
+        return "WAVE file has no fmt chunk before its data.";
+    case WavParseResult::MissingData:
+        return "WAVE file has no data chunk.";
+    case WavParseResult::Truncated:
+    default:
+        return "WAVE header is truncated.";
+    }
+}
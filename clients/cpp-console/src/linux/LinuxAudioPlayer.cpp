@@ -9,6 +9,7 @@
 #include <mutex>
 #include <alsa/asoundlib.h>
 #include "LinuxAudioPlayer.h"
+#include "Tracer.h"
 
 using namespace AudioPlayer;
 
@@ -153,80 +154,194 @@ int LinuxAudioPlayer::GetBufferSize()
 
 void LinuxAudioPlayer::PlayerThreadMain()
 {
-    while (!m_shuttingDown)
+    Tracer::Instance().SetThreadName("player");
+    while (true)
     {
-        // here we will wait to be woken up since there is no audio left to play
+        // here we will wait to be woken up since there is no audio left to play. Everything that wakes us changes
+        // what the predicate checks and notifies under the lock, so an entry queued or a barge in posted while we
+        // were busy is seen here instead of waiting for the next Play
         std::unique_lock<std::mutex> lk{ m_threadMutex };
-        m_conditionVariable.wait(lk);
+        m_conditionVariable.wait(lk, [this]()
+            {
+                return m_shuttingDown || m_bargeIn.Pending() || !m_audioQueue.Empty();
+            });
+        if (m_shuttingDown)
+        {
+            break;
+        }
         lk.unlock();
+        if (m_bargeIn.Pending())
+        {
+            CompleteBargeIn(false);
+        }
         if (m_state == AudioPlayerState::PAUSED)
         {
             snd_pcm_prepare(m_playback_handle);
         }
 
-        while (m_audioQueue.size() > 0)
+        AudioPlayerEntry* entry;
+        while ((entry = m_audioQueue.BeginNext()) != nullptr)
         {
+            TraceSpan span("player", "PlayEntry");
             m_state = AudioPlayerState::PLAYING;
-            std::shared_ptr<AudioPlayerEntry> entry = std::make_shared<AudioPlayerEntry>(m_audioQueue.front());
-            m_queueMutex.lock();
-            if (!m_audioQueue.empty())
-            {
-                //remove the item we just used.
-                m_audioQueue.pop_front();
-            }
-            m_queueMutex.unlock();
-            if (entry == nullptr)
-            {
-                continue;
-            }
             switch (entry->m_entryType)
             {
             case PlayerEntryType::BYTE_ARRAY:
-                PlayByteBuffer(entry);
+                PlayByteBuffer(*entry);
                 break;
             case PlayerEntryType::PULL_AUDIO_OUTPUT_STREAM:
-                PlayAudioPlayerStream(entry);
+                PlayAudioPlayerStream(*entry);
                 break;
             default:
                 fprintf(stderr, "Unknown Audio Player Entry type\n");
             }
+            m_audioQueue.EndCurrent();
+
+            if (m_bargeIn.Pending())
+            {
+                CompleteBargeIn(true);
+            }
         }
         m_state = AudioPlayerState::PAUSED;
     }
 
 }
 
-void LinuxAudioPlayer::PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry> pEntry)
+void LinuxAudioPlayer::CompleteBargeIn(bool wasPlaying)
+{
+    TraceSpan span("player", "BargeIn");
+    // whatever the device still holds is the tail of the audio we were told to drop
+    snd_pcm_sframes_t delay = 0;
+    bool deviceHadAudio = snd_pcm_delay(m_playback_handle, &delay) == 0 && delay > 0;
+    snd_pcm_drop(m_playback_handle);
+    snd_pcm_prepare(m_playback_handle);
+    m_bargeIn.Complete(wasPlaying || deviceHadAudio);
+}
+
+void LinuxAudioPlayer::PlayAudioPlayerStream(AudioPlayerEntry& entry)
 {
     size_t playBufferSize = GetBufferSize();
     unsigned int bytesRead = 0;
-    std::unique_ptr<unsigned char[]> playBuffer = std::make_unique<unsigned char[]>(playBufferSize);
-    do
+    PooledBuffer playBuffer = AudioBufferPool::AcquireAudioBuffer(playBufferSize);
+    std::shared_ptr<IAudioPlayerStream> stream = entry.m_audioPlayerStream;
+
+    // we wait on the stream's readiness instead of blocking in Read so that Stop() can interrupt us
+    stream->SetReadyCallback([this]() { m_streamReady.notify_one(); });
+    while (!Interrupted())
+    {
+        // a short tail is only worth waiting for while the source may still add to it
+        if (stream->Available() < playBufferSize && !stream->IsFullyBuffered())
+        {
+            std::unique_lock<std::mutex> lk{ m_streamMutex };
+            m_streamReady.wait_for(lk, std::chrono::milliseconds(20), [&]()
+                {
+                    return Interrupted() || stream->Available() >= playBufferSize || stream->IsFullyBuffered();
+                });
+            continue;
+        }
+
+        if (stream->SupportsSlices() && stream->Available() >= playBufferSize)
+        {
+            // write straight from the stream's memory, no copy needed
+            const unsigned char* slice;
+            stream->ReadSlice(&slice, playBufferSize);
+            WriteToALSA(slice);
+            CheckPlaybackStarted(entry, playBufferSize);
+            CheckPlaybackEnding(entry);
+            continue;
+        }
+
+        {
+            TraceSpan span("player", "Read");
+            bytesRead = stream->TryRead(playBuffer.Data(), playBufferSize);
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        if (bytesRead < playBufferSize)
+        {
+            //the last read is usually short so we will pad with silence
+            memset(playBuffer.Data() + bytesRead, 0, playBufferSize - bytesRead);
+        }
+        WriteToALSA(playBuffer.Data());
+        CheckPlaybackStarted(entry, playBufferSize);
+        CheckPlaybackEnding(entry);
+    }
+    stream->SetReadyCallback(nullptr);
+    if (Interrupted())
+    {
+        stream->Discard();
+    }
+    FinishPlaybackEnding(entry);
+}
+
+std::chrono::milliseconds LinuxAudioPlayer::QueuedAudio(size_t pendingBytes)
+{
+    // frames already handed to ALSA but not yet heard
+    snd_pcm_sframes_t delay = 0;
+    if (snd_pcm_delay(m_playback_handle, &delay) < 0 || delay < 0)
     {
-        bytesRead = pEntry->m_audioPlayerStream->Read(playBuffer.get(), playBufferSize);
-        WriteToALSA(playBuffer.get());
-    } while (bytesRead > 0 && m_canceled == false);
+        delay = 0;
+    }
+
+    uint64_t frames = pendingBytes / (m_bytesPerSample * m_numChannels) + (uint64_t)delay;
+    return std::chrono::milliseconds(frames * 1000 / m_bitsPerSecond);
+}
+
+void LinuxAudioPlayer::CheckPlaybackStarted(AudioPlayerEntry& entry, size_t bytesWritten)
+{
+    if (entry.PlaybackStartedPending())
+    {
+        // what we just wrote sits at the tail of the device queue, so its first sample plays once the rest has drained
+        auto now = std::chrono::steady_clock::now();
+        uint64_t writtenFrames = bytesWritten / (m_bytesPerSample * m_numChannels);
+        auto written = std::chrono::milliseconds(writtenFrames * 1000 / m_bitsPerSecond);
+        auto queued = QueuedAudio(0);
+        entry.NotifyPlaybackStarted(now + (queued > written ? queued - written : std::chrono::milliseconds(0)));
+    }
+}
+
+void LinuxAudioPlayer::CheckPlaybackEnding(AudioPlayerEntry& entry)
+{
+    if (entry.PlaybackEndingPending() && entry.m_audioPlayerStream->IsFullyBuffered() &&
+        QueuedAudio(entry.m_audioPlayerStream->Available()) <= entry.m_leadTime)
+    {
+        entry.NotifyPlaybackEnding(false);
+    }
 }
 
-void LinuxAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry)
+void LinuxAudioPlayer::FinishPlaybackEnding(AudioPlayerEntry& entry)
+{
+    // the stream is done but the device may still be playing its tail, so wait for the lead time to be reached
+    // unless more audio is queued behind it, in which case waiting would leave a gap
+    while (entry.PlaybackEndingPending() && !Interrupted() && m_audioQueue.Empty() &&
+        QueuedAudio(0) > entry.m_leadTime)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    entry.NotifyPlaybackEnding(Interrupted());
+}
+
+void LinuxAudioPlayer::PlayByteBuffer(AudioPlayerEntry& entry)
 {
     size_t playBufferSize = GetBufferSize();
-    size_t bufferLeft = pEntry->m_size;
-    std::unique_ptr<unsigned char[]> playBuffer = std::make_unique<unsigned char[]>(playBufferSize);
-    while (bufferLeft > 0 && m_canceled == false)
+    size_t bufferLeft = entry.m_size;
+    PooledBuffer playBuffer = AudioBufferPool::AcquireAudioBuffer(playBufferSize);
+    while (bufferLeft > 0 && !Interrupted())
     {
         if (bufferLeft >= playBufferSize)
         {
-            memcpy(playBuffer.get(), &pEntry->m_data[pEntry->m_size - bufferLeft], playBufferSize);
+            memcpy(playBuffer.Data(), &entry.m_data.Data()[entry.m_size - bufferLeft], playBufferSize);
             bufferLeft -= playBufferSize;
         }
         else
         { //there is a smaller amount to play so we will pad with silence
-            memcpy(playBuffer.get(), &pEntry->m_data[pEntry->m_size - bufferLeft], bufferLeft);
-            memset(playBuffer.get() + bufferLeft, 0, playBufferSize - bufferLeft);
+            memcpy(playBuffer.Data(), &entry.m_data.Data()[entry.m_size - bufferLeft], bufferLeft);
+            memset(playBuffer.Data() + bufferLeft, 0, playBufferSize - bufferLeft);
             bufferLeft = 0;
         }
-        if (WriteToALSA(playBuffer.get()) != 0)
+        if (WriteToALSA(playBuffer.Data()) < 0)
         {
             fprintf(stderr, "ERROR: Failed to write audio to ALSA\n");
         }
@@ -235,54 +350,35 @@ void LinuxAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry)
 
 int LinuxAudioPlayer::Play(uint8_t* buffer, size_t bufferSize)
 {
-    int rc = 0;
-
-    if (m_state == AudioPlayerState::UNINITIALIZED)
-    {
-        rc = -1;
-    }
-    else
-    {
-        AudioPlayerEntry entry(buffer, bufferSize);
-        m_queueMutex.lock();
-        m_audioQueue.push_back(entry);
-        m_queueMutex.unlock();
-
-        //make sure the canceled variable is not set
-        m_canceled = false;
+    return Enqueue(AudioPlayerEntry(buffer, bufferSize));
+}
 
-        if (m_state != AudioPlayerState::PLAYING)
-        {
-            //wake up the audio thread
-            m_conditionVariable.notify_one();
-        }
-    }
+int LinuxAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
+{
+    return Enqueue(AudioPlayerEntry(pStream));
+}
 
-    return rc;
+int LinuxAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, PlaybackEndingCallback onEnding,
+    PlaybackStartedCallback onStarted)
+{
+    return Enqueue(AudioPlayerEntry(pStream, leadTime, onEnding, onStarted));
 }
 
-int LinuxAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
+int LinuxAudioPlayer::Enqueue(AudioPlayerEntry&& entry)
 {
     int rc = 0;
     if (m_state == AudioPlayerState::UNINITIALIZED)
     {
         rc = -1;
+        entry.NotifyPlaybackEnding(true);
     }
     else
     {
-        AudioPlayerEntry entry(pStream);
-        m_queueMutex.lock();
-        m_audioQueue.push_back(entry);
-        m_queueMutex.unlock();
+        m_audioQueue.Push(std::move(entry));
 
-        //make sure the canceled variable is not set
-        m_canceled = false;
-
-        if (m_state != AudioPlayerState::PLAYING)
-        {
-            //wake up the audio thread
-            m_conditionVariable.notify_one();
-        }
+        //wake up the audio thread; it may have found the queue empty just before the push and be about to wait
+        std::lock_guard<std::mutex> lk{ m_threadMutex };
+        m_conditionVariable.notify_one();
     }
 
     return rc;
@@ -290,17 +386,21 @@ int LinuxAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
 
 int LinuxAudioPlayer::Stop()
 {
-    //set the canceled flag to stop playback
-    m_canceled = true;
-
-    //tell alsa to drop any frames in buffer
-    snd_pcm_drop(m_playback_handle);
-    m_state = AudioPlayerState::PAUSED;
+    // the player thread drops the frames in the device itself, calling snd_pcm_drop from here
+    // would race a snd_pcm_writei in progress on the player thread
+    return BargeIn(nullptr);
+}
 
+int LinuxAudioPlayer::BargeIn(BargeInCallback onSilent)
+{
     //clear the audio queue safely
-    m_queueMutex.lock();
-    m_audioQueue.clear();
-    m_queueMutex.unlock();
+    m_audioQueue.Clear();
+
+    m_bargeIn.Post(std::move(onSilent));
+    m_streamReady.notify_one();
+    // notifying under the lock means the player thread is either waiting, and gets the notify, or has yet to check Pending
+    std::lock_guard<std::mutex> lk{ m_threadMutex };
+    m_conditionVariable.notify_one();
 
     return 0;
 }
@@ -322,10 +422,23 @@ AudioPlayerState LinuxAudioPlayer::GetState()
     return m_state;
 }
 
-int LinuxAudioPlayer::WriteToALSA(uint8_t* buffer)
+int LinuxAudioPlayer::WriteToALSA(const uint8_t* buffer)
 {
     int rc = 0;
 
+    // wait for room ourselves rather than blocking in writei, so a barge in is noticed within a few milliseconds
+    snd_pcm_sframes_t available;
+    TraceSpan span("player", "Write");
+    while (!Interrupted() && (available = snd_pcm_avail_update(m_playback_handle)) >= 0 &&
+        (snd_pcm_uframes_t)available < m_frames)
+    {
+        snd_pcm_wait(m_playback_handle, 5);
+    }
+    if (Interrupted())
+    {
+        return 0;
+    }
+
     rc = snd_pcm_writei(m_playback_handle, buffer, m_frames);
     if (rc == -EPIPE)
     {
@@ -349,15 +462,21 @@ int LinuxAudioPlayer::WriteToALSA(uint8_t* buffer)
 
 int LinuxAudioPlayer::Close()
 {
-    m_shuttingDown = true;
+    {
+        std::lock_guard<std::mutex> lk{ m_threadMutex };
+        m_shuttingDown = true;
+        m_canceled = true;
+    }
+    m_conditionVariable.notify_one();
+    // the player thread may still be writing to the device, so stop it before closing the device
+    if (m_playerThread.joinable())
+    {
+        m_playerThread.join();
+    }
+
     m_state = AudioPlayerState::UNINITIALIZED;
     snd_pcm_drain(m_playback_handle);
     snd_pcm_close(m_playback_handle);
 
-    m_canceled = true;
-    m_threadMutex.unlock();
-    m_conditionVariable.notify_one();
-    m_playerThread.join();
-
     return 0;
 }
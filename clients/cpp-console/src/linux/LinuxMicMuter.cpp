@@ -1,30 +1,223 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <poll.h>
 #include <string>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 #include "LinuxMicMuter.h"
+#include "log.h"
 
 using namespace MicMuter;
+using namespace std;
+
+LinuxMicMuter::LinuxMicMuter(const string& captureDeviceName)
+{
+    _mixerDevice = MixerDeviceFor(captureDeviceName);
+}
 
 LinuxMicMuter::~LinuxMicMuter()
 {
-    // todo    
+    if (_eventThread.joinable())
+    {
+        char wake = 0;
+        if (write(_wakePipe[1], &wake, 1) == 1)
+        {
+            _eventThread.join();
+        }
+        else
+        {
+            _eventThread.detach();
+        }
+    }
+    if (_wakePipe[0] >= 0)
+    {
+        close(_wakePipe[0]);
+        close(_wakePipe[1]);
+    }
+
+    if (_mixer != nullptr)
+    {
+        if (_captureSwitch != nullptr && _muted != _originalMuted)
+        {
+            snd_mixer_selem_set_capture_switch_all(_captureSwitch, _originalMuted ? 0 : 1);
+        }
+        snd_mixer_close(_mixer);
+    }
+}
+
+string LinuxMicMuter::MixerDeviceFor(const string& captureDeviceName)
+{
+    // hw:CARD=Device,DEV=0 and sysdefault:CARD=Device name the card by its id
+    size_t card = captureDeviceName.find("CARD=");
+    if (card != string::npos)
+    {
+        size_t end = captureDeviceName.find(',', card);
+        return "hw:" + captureDeviceName.substr(card + 5, end == string::npos ? string::npos : end - card - 5);
+    }
+
+    // hw:1,0 and plughw:1,0 name it by its number
+    size_t colon = captureDeviceName.find(':');
+    if (colon != string::npos && captureDeviceName.find("hw:") != string::npos)
+    {
+        size_t end = captureDeviceName.find(',', colon);
+        return "hw:" + captureDeviceName.substr(colon + 1, end == string::npos ? string::npos : end - colon - 1);
+    }
+
+    return "default";
 }
 
 int LinuxMicMuter::Initialize()
 {
-    // todo
+    int err;
+    if ((err = snd_mixer_open(&_mixer, 0)) < 0)
+    {
+        fprintf(stderr, "cannot open mixer: %s\n", snd_strerror(err));
+        _mixer = nullptr;
+        return err;
+    }
+    if ((err = snd_mixer_attach(_mixer, _mixerDevice.c_str())) < 0 ||
+        (err = snd_mixer_selem_register(_mixer, NULL, NULL)) < 0 ||
+        (err = snd_mixer_load(_mixer)) < 0)
+    {
+        fprintf(stderr, "cannot load mixer %s: %s\n", _mixerDevice.c_str(), snd_strerror(err));
+        snd_mixer_close(_mixer);
+        _mixer = nullptr;
+        return err;
+    }
+
+    // prefer the card's main Capture control, otherwise the first control that can switch capture off
+    for (snd_mixer_elem_t* element = snd_mixer_first_elem(_mixer); element != nullptr; element = snd_mixer_elem_next(element))
+    {
+        if (!snd_mixer_selem_has_capture_switch(element))
+        {
+            continue;
+        }
+        if (_captureSwitch == nullptr || string(snd_mixer_selem_get_name(element)) == "Capture")
+        {
+            _captureSwitch = element;
+        }
+    }
+    if (_captureSwitch == nullptr)
+    {
+        fprintf(stderr, "mixer %s has no capture switch\n", _mixerDevice.c_str());
+        return -1;
+    }
+
+    {
+        lock_guard<mutex> lock(_mixerMutex);
+        ReadSwitch();
+    }
+    _originalMuted = _muted;
+
+    if (pipe(_wakePipe) != 0)
+    {
+        return -1;
+    }
+    _eventThread = thread(&LinuxMicMuter::EventThreadMain, this);
     return 0;
 }
 
 int LinuxMicMuter::MuteUnmute()
 {
-    // todo
+    if (_captureSwitch == nullptr)
+    {
+        return -1;
+    }
+
+    lock_guard<mutex> lock(_mixerMutex);
+    bool mute = !_muted;
+    _requestedAt = chrono::steady_clock::now();
+    _requestedMuted = mute;
+    _changeRequested = true;
+    int err = snd_mixer_selem_set_capture_switch_all(_captureSwitch, mute ? 0 : 1);
+    if (err < 0)
+    {
+        _changeRequested = false;
+        fprintf(stderr, "Error. Failed to mute/unmute the capture device: %s\n", snd_strerror(err));
+        return err;
+    }
+
+    // the event thread confirms the change and measures the latency; until then report what was asked for
+    _muted = mute;
     return 0;
 }
 
 bool LinuxMicMuter::IsMuted()
 {
     return _muted;
-}
\ No newline at end of file
+}
+
+void LinuxMicMuter::SetMuteChangedHandler(MuteChangedHandler handler)
+{
+    lock_guard<mutex> lock(_handlerMutex);
+    _muteChanged = handler;
+}
+
+bool LinuxMicMuter::ReadSwitch()
+{
+    int on = 1;
+    snd_mixer_selem_get_capture_switch(_captureSwitch, SND_MIXER_SCHN_FRONT_LEFT, &on);
+    bool muted = on == 0;
+    return _muted.exchange(muted) != muted;
+}
+
+void LinuxMicMuter::EventThreadMain()
+{
+    vector<pollfd> descriptors;
+    while (true)
+    {
+        bool changed = false;
+        bool muted = false;
+        {
+            lock_guard<mutex> lock(_mixerMutex);
+            int count = snd_mixer_poll_descriptors_count(_mixer);
+            descriptors.resize(count + 1);
+            descriptors[0] = { _wakePipe[0], POLLIN, 0 };
+            snd_mixer_poll_descriptors(_mixer, &descriptors[1], count);
+        }
+
+        if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+        {
+            continue;
+        }
+        if (descriptors[0].revents != 0)
+        {
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(_mixerMutex);
+            unsigned short revents = 0;
+            snd_mixer_poll_descriptors_revents(_mixer, &descriptors[1], descriptors.size() - 1, &revents);
+            if ((revents & POLLIN) == 0)
+            {
+                continue;
+            }
+            snd_mixer_handle_events(_mixer);
+
+            // MuteUnmute already set _muted, so our own change only shows up here as a confirmation
+            changed = ReadSwitch();
+            muted = _muted;
+            if (_changeRequested && muted == _requestedMuted)
+            {
+                _changeRequested = false;
+                auto latency = chrono::steady_clock::now() - _requestedAt;
+                _muteLatency.Record(latency);
+                log_t("Microphone ", muted ? "muted" : "unmuted", " after ", chrono::duration_cast<chrono::microseconds>(latency).count(),
+                    "us (p50 ", _muteLatency.Percentile(50.0), "us, p99 ", _muteLatency.Percentile(99.0), "us)");
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            lock_guard<mutex> lock(_handlerMutex);
+            if (_muteChanged)
+            {
+                _muteChanged(muted);
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// Measures what the status board costs its writer and its readers: an uncontended update, an uncontended read,
+// and reads while another thread updates as fast as it can. Every update writes the same counter into all the
+// counter fields, so a read that mixed two updates is caught and counted as torn; there should be none.
+//
+// usage: statusBoardBenchmark.exe [iterations]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "StatusBoard.h"
+#include "StatusBoardReader.h"
+
+using namespace std;
+
+namespace
+{
+    template <typename Fn>
+    double MeanNanoseconds(int iterations, Fn fn)
+    {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            fn(i);
+        }
+        auto elapsed = chrono::steady_clock::now() - start;
+        return chrono::duration<double, nano>(elapsed).count() / iterations;
+    }
+
+    void WriteCounter(StatusBoard& board, uint64_t counter)
+    {
+        board.Update([counter](StatusBoardFields& fields)
+            {
+                fields.turnsStarted = counter;
+                fields.turnsPlayed = counter;
+                fields.bargeIns = counter;
+                fields.playbackStartedUs = counter;
+            });
+    }
+
+    bool IsTorn(const StatusBoardFields& fields)
+    {
+        return fields.turnsPlayed != fields.turnsStarted || fields.bargeIns != fields.turnsStarted ||
+            fields.playbackStartedUs != fields.turnsStarted;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    string name = "/statusBoardBenchmark." + to_string(getpid());
+
+    StatusBoard board;
+    if (board.Open(name) != 0)
+    {
+        perror("opening the status board");
+        return 1;
+    }
+    StatusBoardReader* reader = statusboard_open(name.c_str());
+    if (reader == nullptr)
+    {
+        perror("mapping the status board");
+        return 1;
+    }
+
+    StatusBoardFields fields;
+    uint64_t torn = 0;
+    uint64_t failed = 0;
+
+    double write = MeanNanoseconds(iterations, [&board](int i) { WriteCounter(board, i); });
+    double read = MeanNanoseconds(iterations, [&](int) { failed += statusboard_read(reader, &fields) != 0 ? 1 : 0; });
+
+    atomic<bool> writing{ true };
+    atomic<uint64_t> updates{ 0 };
+    thread writer([&]
+        {
+            uint64_t counter = 0;
+            while (writing)
+            {
+                WriteCounter(board, ++counter);
+            }
+            updates = counter;
+        });
+    double contendedRead = MeanNanoseconds(iterations, [&](int)
+        {
+            if (statusboard_read(reader, &fields) != 0)
+            {
+                failed++;
+            }
+            else if (IsTorn(fields))
+            {
+                torn++;
+            }
+        });
+    writing = false;
+    writer.join();
+
+    printf("%d iterations\n", iterations);
+    printf("update, uncontended               %7.1f ns\n", write);
+    printf("read, uncontended                 %7.1f ns\n", read);
+    printf("read, writer updating flat out    %7.1f ns  (%llu updates meanwhile)\n", contendedRead, (unsigned long long)updates.load());
+    printf("torn reads %llu, failed reads %llu\n", (unsigned long long)torn, (unsigned long long)failed);
+
+    statusboard_close(reader);
+    board.Close();
+    return torn == 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "StatusBoardReader.h"
+
+/* Updates take well under a microsecond, so a reader spins a little and then yields in case it is keeping a preempted
+   writer off the CPU. It gives up after this many attempts, which takes a writer that died mid update. */
+#define STATUS_BOARD_READ_ATTEMPTS 100000
+#define STATUS_BOARD_SPINS_BEFORE_YIELD 64
+
+struct StatusBoardReader
+{
+    const StatusBoardSegment* segment;
+    size_t fieldsSize;
+};
+
+StatusBoardReader* statusboard_open(const char* name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    void* mapped = mmap(NULL, sizeof(StatusBoardSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const StatusBoardSegment* segment = (const StatusBoardSegment*)mapped;
+    if (segment->magic != STATUS_BOARD_MAGIC || segment->version > STATUS_BOARD_VERSION)
+    {
+        munmap(mapped, sizeof(StatusBoardSegment));
+        return NULL;
+    }
+
+    StatusBoardReader* reader = (StatusBoardReader*)malloc(sizeof(StatusBoardReader));
+    if (reader == NULL)
+    {
+        munmap(mapped, sizeof(StatusBoardSegment));
+        return NULL;
+    }
+    reader->segment = segment;
+    /* an older writer publishes fewer fields; the rest read as zero */
+    reader->fieldsSize = segment->fieldsSize < sizeof(StatusBoardFields) ? segment->fieldsSize : sizeof(StatusBoardFields);
+    return reader;
+}
+
+void statusboard_close(StatusBoardReader* reader)
+{
+    if (reader != NULL)
+    {
+        munmap((void*)reader->segment, sizeof(StatusBoardSegment));
+        free(reader);
+    }
+}
+
+int statusboard_read(const StatusBoardReader* reader, StatusBoardFields* fields)
+{
+    for (int attempt = 0; attempt < STATUS_BOARD_READ_ATTEMPTS; attempt++)
+    {
+        if (attempt > 0 && attempt % STATUS_BOARD_SPINS_BEFORE_YIELD == 0)
+        {
+            sched_yield();
+        }
+
+        uint32_t before = __atomic_load_n(&reader->segment->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1u)
+        {
+            continue;
+        }
+
+        memset(fields, 0, sizeof(*fields));
+        memcpy(fields, &reader->segment->fields, reader->fieldsSize);
+
+        /* keeps the field loads from moving below the second sequence load */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&reader->segment->sequence, __ATOMIC_RELAXED) == before)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t statusboard_sequence(const StatusBoardReader* reader)
+{
+    return __atomic_load_n(&reader->segment->sequence, __ATOMIC_ACQUIRE);
+}
+
+uint32_t statusboard_writer_pid(const StatusBoardReader* reader)
+{
+    return reader->segment->writerPid;
+}
+
+uint64_t statusboard_playback_position_ms(const StatusBoardFields* fields)
+{
+    if (fields->playbackStartedUs == 0)
+    {
+        return 0;
+    }
+
+    uint64_t end = fields->playbackEndedUs;
+    if (end == 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        end = (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+    }
+    return end > fields->playbackStartedUs ? (end - fields->playbackStartedUs) / 1000u : 0;
+}
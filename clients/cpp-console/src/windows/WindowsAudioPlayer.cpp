@@ -10,6 +10,7 @@
 #include <atlbase.h>
 #include <avrt.h>
 #include "WindowsAudioPlayer.h"
+#include "Tracer.h"
 
 using namespace AudioPlayer;
 
@@ -212,58 +213,78 @@ exit:
 void WindowsAudioPlayer::PlayerThreadMain()
 {
     HRESULT hr = S_OK;
-    m_shuttingDown = false;
-
-    while (m_shuttingDown == false)
+    Tracer::Instance().SetThreadName("player");
+    while (true)
     {
         // here we will wait to be woken up since there is no audio left to play
         std::unique_lock<std::mutex> lk{ m_threadMutex };
-        m_conditionVariable.wait(lk);
+        // checked under the lock so that a Close() cannot slip in before the wait and leave us asleep
+        if (m_shuttingDown)
+        {
+            break;
+        }
+        // a barge in posted while we were busy must not wait for the next Play to be completed
+        if (!m_bargeIn.Pending())
+        {
+            m_conditionVariable.wait(lk);
+        }
         lk.unlock();
+        if (m_bargeIn.Pending())
+        {
+            CompleteBargeIn(false);
+        }
 
-        while (m_audioQueue.size() > 0)
+        AudioPlayerEntry* entry;
+        while ((entry = m_audioQueue.BeginNext()) != nullptr)
         {
+            TraceSpan span("player", "PlayEntry");
             m_state = AudioPlayerState::PLAYING;
 
-            std::shared_ptr<AudioPlayerEntry> entry = std::make_shared<AudioPlayerEntry>(m_audioQueue.front());
-            m_queueMutex.lock();
-            if (!m_audioQueue.empty())
-            {
-                //remove the item we just used.
-                m_audioQueue.pop_front();
-            }
-            m_queueMutex.unlock();
-            if (entry == nullptr)
-            {
-                continue;
-            }
             switch (entry->m_entryType)
             {
             case PlayerEntryType::BYTE_ARRAY:
-                PlayByteBuffer(entry);
+                PlayByteBuffer(*entry);
                 break;
             case PlayerEntryType::PULL_AUDIO_OUTPUT_STREAM:
-                PlayAudioPlayerStream(entry);
+                PlayAudioPlayerStream(*entry);
                 break;
             default:
                 fprintf(stderr, "Unknown Audio Player Entry type\n");
             }
+            m_audioQueue.EndCurrent();
 
+            if (m_bargeIn.Pending())
+            {
+                CompleteBargeIn(true);
+            }
         }
         m_state = AudioPlayerState::PAUSED;
     }
 }
 
-void WindowsAudioPlayer::PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry> pEntry)
+void WindowsAudioPlayer::CompleteBargeIn(bool wasPlaying)
+{
+    TraceSpan span("player", "BargeIn");
+    // up to ENGINE_LATENCY_IN_MSEC of the dropped audio is still in the render buffer, so throw it away
+    UINT32 paddingFrames = 0;
+    bool deviceHadAudio = SUCCEEDED(m_pAudioClient->GetCurrentPadding(&paddingFrames)) && paddingFrames > 0;
+    m_pAudioClient->Stop();
+    m_pAudioClient->Reset();
+    m_pAudioClient->Start();
+    m_bargeIn.Complete(wasPlaying || deviceHadAudio);
+}
+
+void WindowsAudioPlayer::PlayAudioPlayerStream(AudioPlayerEntry& entry)
 {
     HRESULT hr = S_OK;
     UINT32 maxBufferSizeInFrames = 0;
     UINT32 paddingFrames;
     UINT32 framesAvailable;
     UINT32 framesToWrite;
-    BYTE* pData, * pStreamData;
+    BYTE* pData;
     unsigned int bytesRead = 0;
-    std::shared_ptr<IAudioPlayerStream> stream = pEntry->m_audioPlayerStream;
+    std::shared_ptr<IAudioPlayerStream> stream = entry.m_audioPlayerStream;
+    PooledBuffer streamData = AudioBufferPool::AcquireAudioBuffer(AudioBufferPool::ChunkBlockSize);
 
     hr = m_pAudioClient->GetBufferSize(&maxBufferSizeInFrames);
     if (FAILED(hr))
@@ -287,13 +308,15 @@ void WindowsAudioPlayer::PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry>
         return;
     }
 
-    do
+    // we wait on the stream's readiness instead of blocking in Read so that Stop() and BargeIn() can interrupt us
+    stream->SetReadyCallback([this]() { m_streamReady.notify_one(); });
+    while (!Interrupted())
     {
         hr = m_pAudioClient->GetCurrentPadding(&paddingFrames);
         if (FAILED(hr))
         {
             fprintf(stderr, "Error. Failed to GetCurrentPadding. Error: 0x%08x\n", hr);
-            continue;
+            break;
         }
 
         framesAvailable = maxBufferSizeInFrames - paddingFrames;
@@ -306,8 +329,47 @@ void WindowsAudioPlayer::PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry>
             continue;
         }
 
-        pStreamData = (BYTE*)malloc(sizeToWrite);
-        bytesRead = stream->Read((unsigned char*)pStreamData, sizeToWrite);
+        if (sizeToWrite > streamData.Capacity())
+        {
+            //keep each read within one pooled block, aligned to whole frames
+            sizeToWrite = (UINT32)(streamData.Capacity() - (streamData.Capacity() % m_pwf.nBlockAlign));
+        }
+
+        // the render buffer holds up to ENGINE_LATENCY_IN_MSEC, so whatever has arrived is written straight away
+        // and we only wait when not even a whole frame is there yet
+        if (stream->Available() < m_pwf.nBlockAlign && !stream->IsFullyBuffered())
+        {
+            std::unique_lock<std::mutex> lk{ m_streamMutex };
+            m_streamReady.wait_for(lk, std::chrono::milliseconds(20), [&]()
+                {
+                    return Interrupted() || stream->Available() >= m_pwf.nBlockAlign || stream->IsFullyBuffered();
+                });
+            continue;
+        }
+
+        size_t available = stream->Available();
+        if (sizeToWrite > available)
+        {
+            sizeToWrite = (UINT32)(available - (available % m_pwf.nBlockAlign));
+        }
+
+        const unsigned char* source = streamData.Data();
+        {
+            TraceSpan readSpan("player", "Read");
+            if (stream->SupportsSlices())
+            {
+                // memory backed streams can be copied straight into the render buffer
+                bytesRead = stream->ReadSlice(&source, sizeToWrite);
+            }
+            else
+            {
+                bytesRead = stream->TryRead(streamData.Data(), sizeToWrite);
+            }
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
 
         if (sizeToWrite > bytesRead)
         {
@@ -315,29 +377,81 @@ void WindowsAudioPlayer::PlayAudioPlayerStream(std::shared_ptr<AudioPlayerEntry>
         }
         framesToWrite = sizeToWrite / m_pwf.nBlockAlign;
 
+        TraceSpan writeSpan("player", "Write");
         hr = m_pRenderClient->GetBuffer(framesToWrite, &pData);
         if (FAILED(hr))
         {
             fprintf(stderr, "Error. Failed to GetBuffer. Error: 0x%08x\n", hr);
-            goto freeBeforeContinue;
+            continue;
         }
 
-        memcpy_s(pData, sizeToWrite, pStreamData, sizeToWrite);
+        memcpy_s(pData, sizeToWrite, source, sizeToWrite);
 
         hr = m_pRenderClient->ReleaseBuffer(framesToWrite, 0);
         if (FAILED(hr))
         {
             printf("Error. Failed to ReleaseBuffer. Error: 0x%08x\n", hr);
-            goto freeBeforeContinue;
+            continue;
         }
+        CheckPlaybackStarted(entry, sizeToWrite);
+        CheckPlaybackEnding(entry);
+    }
+    stream->SetReadyCallback(nullptr);
+
+    if (Interrupted())
+    {
+        stream->Discard();
+    }
+    FinishPlaybackEnding(entry);
+}
+
+std::chrono::milliseconds WindowsAudioPlayer::QueuedAudio(size_t pendingBytes)
+{
+    // frames already in the render buffer but not yet heard
+    UINT32 paddingFrames = 0;
+    if (FAILED(m_pAudioClient->GetCurrentPadding(&paddingFrames)))
+    {
+        paddingFrames = 0;
+    }
+
+    uint64_t frames = pendingBytes / m_pwf.nBlockAlign + paddingFrames;
+    return std::chrono::milliseconds(frames * 1000 / m_pwf.nSamplesPerSec);
+}
+
+void WindowsAudioPlayer::CheckPlaybackStarted(AudioPlayerEntry& entry, size_t bytesWritten)
+{
+    if (entry.PlaybackStartedPending())
+    {
+        // what we just wrote sits at the tail of the render buffer, so its first sample plays once the rest has drained
+        auto now = std::chrono::steady_clock::now();
+        auto written = std::chrono::milliseconds((uint64_t)(bytesWritten / m_pwf.nBlockAlign) * 1000 / m_pwf.nSamplesPerSec);
+        auto queued = QueuedAudio(0);
+        entry.NotifyPlaybackStarted(now + (queued > written ? queued - written : std::chrono::milliseconds(0)));
+    }
+}
 
-    freeBeforeContinue:
-        free(pStreamData);
-    } while (bytesRead > 0 && m_canceled == false);
+void WindowsAudioPlayer::CheckPlaybackEnding(AudioPlayerEntry& entry)
+{
+    if (entry.PlaybackEndingPending() && entry.m_audioPlayerStream->IsFullyBuffered() &&
+        QueuedAudio(entry.m_audioPlayerStream->Available()) <= entry.m_leadTime)
+    {
+        entry.NotifyPlaybackEnding(false);
+    }
+}
 
+void WindowsAudioPlayer::FinishPlaybackEnding(AudioPlayerEntry& entry)
+{
+    // the stream is done but up to ENGINE_LATENCY_IN_MSEC of it may still be in the render buffer, so wait for
+    // the lead time to be reached unless more audio is queued behind it, in which case waiting would leave a gap
+    while (entry.PlaybackEndingPending() && !Interrupted() && m_audioQueue.Empty() &&
+        QueuedAudio(0) > entry.m_leadTime)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    entry.NotifyPlaybackEnding(Interrupted());
 }
 
-void WindowsAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry)
+void WindowsAudioPlayer::PlayByteBuffer(AudioPlayerEntry& entry)
 {
     HRESULT hr = S_OK;
     UINT32 maxBufferSizeInFrames = 0;
@@ -345,7 +459,7 @@ void WindowsAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry
     UINT32 framesAvailable;
     UINT32 framesToWrite;
     BYTE* pData;
-    size_t bufferLeft = pEntry->m_size;
+    size_t bufferLeft = entry.m_size;
 
     hr = m_pAudioClient->GetBufferSize(&maxBufferSizeInFrames);
     if (FAILED(hr))
@@ -354,7 +468,7 @@ void WindowsAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry
         return;
     }
 
-    while (bufferLeft > 0 && m_canceled == false)
+    while (bufferLeft > 0 && !Interrupted())
     {
         //  We want to find out how much of the buffer *isn't* available (is padding).
 
@@ -381,7 +495,7 @@ void WindowsAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry
             continue;
         }
 
-        memcpy_s(pData, sizeToWrite, &pEntry->m_data[pEntry->m_size - bufferLeft], sizeToWrite);
+        memcpy_s(pData, sizeToWrite, &entry.m_data.Data()[entry.m_size - bufferLeft], sizeToWrite);
 
         bufferLeft -= sizeToWrite;
 
@@ -396,48 +510,32 @@ void WindowsAudioPlayer::PlayByteBuffer(std::shared_ptr<AudioPlayerEntry> pEntry
 
 int WindowsAudioPlayer::Play(uint8_t* buffer, size_t bufferSize)
 {
-    int rc = 0;
-    if (m_state == AudioPlayerState::UNINITIALIZED)
-    {
-        rc = -1;
-    }
-    else
-    {
-        AudioPlayerEntry entry(buffer, bufferSize);
-        m_queueMutex.lock();
-        m_audioQueue.push_back(entry);
-        m_queueMutex.unlock();
-
-        //make sure the canceled variable is not set
-        m_canceled = false;
+    return Enqueue(AudioPlayerEntry(buffer, bufferSize));
+}
 
-        if (m_state != AudioPlayerState::PLAYING)
-        {
-            //wake up the audio thread
-            m_conditionVariable.notify_one();
-        }
-    }
+int WindowsAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
+{
+    return Enqueue(AudioPlayerEntry(pStream));
+}
 
-    return rc;
+int WindowsAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream, std::chrono::milliseconds leadTime, PlaybackEndingCallback onEnding,
+    PlaybackStartedCallback onStarted)
+{
+    return Enqueue(AudioPlayerEntry(pStream, leadTime, onEnding, onStarted));
 }
 
-int WindowsAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
+int WindowsAudioPlayer::Enqueue(AudioPlayerEntry&& entry)
 {
     int rc = 0;
 
     if (m_state == AudioPlayerState::UNINITIALIZED)
     {
         rc = -1;
+        entry.NotifyPlaybackEnding(true);
     }
     else
     {
-        AudioPlayerEntry entry(pStream);
-        m_queueMutex.lock();
-        m_audioQueue.push_back(entry);
-        m_queueMutex.unlock();
-
-        //make sure the canceled variable is not set
-        m_canceled = false;
+        m_audioQueue.Push(std::move(entry));
 
         if (m_state != AudioPlayerState::PLAYING)
         {
@@ -451,13 +549,23 @@ int WindowsAudioPlayer::Play(std::shared_ptr<IAudioPlayerStream> pStream)
 
 int WindowsAudioPlayer::Stop()
 {
-    //set the canceled flag to stop playback
-    m_canceled = true;
+    // the player thread flushes the render buffer itself, between writes
+    return BargeIn(nullptr);
+}
 
+int WindowsAudioPlayer::BargeIn(BargeInCallback onSilent)
+{
     //clear the audio queue safely
-    m_queueMutex.lock();
-    m_audioQueue.clear();
-    m_queueMutex.unlock();
+    m_audioQueue.Clear();
+
+    m_bargeIn.Post(std::move(onSilent));
+    // wakes a stream that is waiting on its source, so the device is reset without waiting on the network
+    m_streamReady.notify_one();
+    {
+        // taking the lock means the player thread is either waiting, and gets the notify, or has yet to check Pending
+        std::lock_guard<std::mutex> lk{ m_threadMutex };
+    }
+    m_conditionVariable.notify_one();
 
     return 0;
 }
@@ -486,10 +594,16 @@ AudioPlayerState WindowsAudioPlayer::GetState()
 
 int WindowsAudioPlayer::Close()
 {
-    m_shuttingDown = true;
-    m_canceled = true;
+    {
+        std::lock_guard<std::mutex> lk{ m_threadMutex };
+        m_shuttingDown = true;
+        m_canceled = true;
+    }
     m_conditionVariable.notify_one();
-    m_playerThread.join();
+    if (m_playerThread.joinable())
+    {
+        m_playerThread.join();
+    }
 
     SAFE_CLOSEHANDLE(m_hAudioClientEvent);
     SAFE_RELEASE(m_pRenderClient);
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "Activity.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(ActivityTests)
+    {
+    public:
+
+        TEST_METHOD(TestActivityExtractsTopLevelFieldsWithoutParsing)
+        {
+            Activity activity(R"({
+                "attachments": [ { "contentType": "application/vnd.microsoft.card.adaptive",
+                                   "content": { "type": "AdaptiveCard", "body": [ { "type": "TextBlock", "text": "card text" } ] } } ],
+                "from": { "id": "bot-id", "name": "bot" },
+                "id": "activity-1",
+                "inputHint": "expectingInput",
+                "speak": "hello",
+                "text": "caf\u00e9 \"there\" \ud83d\ude00",
+                "type": "message"
+            })");
+
+            Assert::AreEqual(std::string("message"), activity.Type());
+            Assert::AreEqual(std::string("activity-1"), activity.Id());
+            Assert::AreEqual(std::string(u8"café \"there\" \U0001F600"), activity.Text());
+            Assert::AreEqual(std::string("expectingInput"), activity.InputHint());
+            Assert::IsTrue(activity.HasText());
+            Assert::IsFalse(activity.IsParsed());
+
+            Assert::IsTrue(activity.Json()["attachments"][0]["content"]["type"] == "AdaptiveCard");
+            Assert::IsTrue(activity.IsParsed());
+        }
+
+        TEST_METHOD(TestActivityWithMissingOrMalformedFields)
+        {
+            Activity event(R"({ "type": "event", "name": "keyword", "value": { "text": "nested" } })");
+            Assert::AreEqual(std::string("event"), event.Type());
+            Assert::IsFalse(event.HasText());
+            Assert::AreEqual(std::string(""), event.InputHint());
+
+            Activity malformed(R"({ "type": "message", "text": )");
+            Assert::AreEqual(std::string(""), malformed.Type());
+            Assert::IsFalse(malformed.HasText());
+        }
+
+        TEST_METHOD(TestActivityArenaServesParseAndResets)
+        {
+            ActivityArena arena(1024);
+            std::string raw = R"({ "type": "message", "attachments": [ )";
+            for (int i = 0; i < 100; i++)
+            {
+                raw += R"({ "contentType": "text/plain", "content": "an attachment long enough to need its own string buffer" },)";
+            }
+            raw += R"({ "content": "last" } ] })";
+
+            {
+                Activity activity(raw, &arena);
+                Assert::AreEqual((size_t)101, activity.Json()["attachments"].size());
+                Assert::IsTrue(arena.Allocations() > 100);
+                Assert::IsTrue(arena.BlockAllocations() > 1);
+            }
+
+            arena.Reset();
+            Assert::AreEqual((uint64_t)0, arena.Allocations());
+
+            // the overflow blocks were coalesced, so the same activity now fits in one block
+            uint64_t blocks = arena.BlockAllocations();
+            {
+                Activity activity(raw, &arena);
+                activity.Json();
+            }
+            arena.Reset();
+            Assert::AreEqual(blocks, arena.BlockAllocations());
+        }
+    };
+}
@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "AsyncLogger.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(AsyncLoggerTests)
+    {
+    public:
+
+        TEST_METHOD(TestAsyncLoggerWritesEveryThreadsLinesWholeAndInOrder)
+        {
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+            FILE* file = nullptr;
+            fopen_s(&file, path, "w");
+
+            const int threads = 4;
+            const int linesPerThread = 200;
+            {
+                AsyncLogger logger(file);
+                std::vector<std::thread> writers;
+                for (int t = 0; t < threads; t++)
+                {
+                    writers.emplace_back([&logger, t]
+                    {
+                        for (int i = 0; i < linesPerThread; i++)
+                        {
+                            // every tenth line is too long for a slot and goes through the heap
+                            std::string line = std::to_string(t) + " " + std::to_string(i) + " " + std::string(i % 10 == 0 ? 400 : 20, 'x');
+                            logger.Write(line.data(), line.size());
+                        }
+                    });
+                }
+                for (auto& writer : writers)
+                {
+                    writer.join();
+                }
+                logger.Flush();
+                Assert::AreEqual((uint64_t)0, logger.LinesDropped());
+            }
+            fclose(file);
+
+            std::vector<int> next(threads, 0);
+            std::ifstream in(path);
+            std::string line;
+            int count = 0;
+            while (std::getline(in, line))
+            {
+                int t = 0;
+                int i = 0;
+                Assert::AreEqual(2, sscanf_s(line.c_str(), "%d %d", &t, &i));
+                Assert::AreEqual(next[t], i);
+                size_t expectedLength = std::to_string(t).size() + std::to_string(i).size() + 2 + (i % 10 == 0 ? 400 : 20);
+                Assert::AreEqual(expectedLength, line.size());
+                next[t]++;
+                count++;
+            }
+            in.close();
+            remove(path);
+            Assert::AreEqual(threads * linesPerThread, count);
+        }
+
+        TEST_METHOD(TestAsyncLoggerCountsLinesItHadToDrop)
+        {
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+            FILE* file = nullptr;
+            fopen_s(&file, path, "w");
+            {
+                // a ring this small overflows whenever the writer falls behind
+                AsyncLogger logger(file, 4);
+                for (int i = 0; i < 10000; i++)
+                {
+                    logger.Write("a line", 6);
+                }
+                logger.Flush();
+                Assert::AreEqual((uint64_t)10000, logger.LinesWritten() + logger.LinesDropped());
+            }
+            fclose(file);
+            remove(path);
+        }
+    };
+}
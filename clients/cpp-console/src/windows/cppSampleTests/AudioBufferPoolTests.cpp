@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "AudioBufferPool.h"
+#include "AudioPlayerEntry.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace AudioPlayer;
+
+// Counts every operator new made by this test module while counting is switched on. Also used by the benchmarks.
+std::atomic<bool> g_countAllocations{ false };
+std::atomic<uint64_t> g_allocationCount{ 0 };
+
+void* operator new(size_t size)
+{
+    if (g_countAllocations)
+    {
+        g_allocationCount++;
+    }
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(AudioBufferPoolTests)
+    {
+    public:
+
+        TEST_METHOD(TestAudioBufferPoolReturnsBlocksOnDestruction)
+        {
+            AudioBufferPool pool(1024, 4);
+            {
+                PooledBuffer first = pool.Acquire();
+                PooledBuffer second = pool.Acquire();
+                Assert::IsTrue(first.IsPooled());
+                Assert::AreEqual((size_t)2, pool.Available());
+            }
+            Assert::AreEqual((size_t)4, pool.Available());
+        }
+
+        TEST_METHOD(TestAudioBufferPoolFallsBackToHeapWhenExhausted)
+        {
+            AudioBufferPool pool(1024, 1);
+            PooledBuffer first = pool.Acquire();
+            PooledBuffer second = pool.Acquire();
+
+            Assert::IsTrue(first.IsPooled());
+            Assert::IsFalse(second.IsPooled());
+            Assert::AreEqual((uint64_t)1, pool.FallbackAllocations());
+        }
+
+        TEST_METHOD(TestSteadyStateAudioPathDoesNotAllocate)
+        {
+            unsigned char chunk[1024] = { 0 };
+            AudioPlayerEntryQueue queue;
+
+            // warm up so the queue has nodes to recycle and the shared pools exist
+            for (int i = 0; i < 8; i++)
+            {
+                queue.Push(AudioPlayerEntry(chunk, sizeof(chunk)));
+            }
+            while (queue.BeginNext() != nullptr)
+            {
+                queue.EndCurrent();
+            }
+
+            uint64_t fallbacksBefore = AudioBufferPool::PeriodPool().FallbackAllocations();
+            g_allocationCount = 0;
+            g_countAllocations = true;
+
+            for (int i = 0; i < 10000; i++)
+            {
+                // the dialog layer's chunk buffer
+                PooledBuffer readBuffer = AudioBufferPool::AcquireAudioBuffer(sizeof(chunk));
+                queue.Push(AudioPlayerEntry(readBuffer.Data(), sizeof(chunk)));
+
+                // the player thread's period buffer
+                AudioPlayerEntry* entry = queue.BeginNext();
+                PooledBuffer periodBuffer = AudioBufferPool::AcquireAudioBuffer(entry->m_size);
+                queue.EndCurrent();
+            }
+
+            g_countAllocations = false;
+
+            Assert::AreEqual((uint64_t)0, g_allocationCount.load());
+            Assert::AreEqual(fallbacksBefore, AudioBufferPool::PeriodPool().FallbackAllocations());
+        }
+    };
+}
@@ -0,0 +1,219 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "AudioPlayerStreamImpl.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    // Stands in for the SDK's pull stream: Read blocks until the test hands it audio or ends the stream.
+    class GatedSource
+    {
+    public:
+        uint32_t Read(uint8_t* buffer, uint32_t size)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_reading = true;
+            m_changed.notify_all();
+            m_changed.wait(lock, [&] { return !m_pending.empty() || m_ended; });
+            m_reading = false;
+            uint32_t bytes = (uint32_t)std::min<size_t>(size, m_pending.size());
+            std::copy(m_pending.begin(), m_pending.begin() + bytes, buffer);
+            m_pending.erase(m_pending.begin(), m_pending.begin() + bytes);
+            return bytes;
+        }
+
+        void Deliver(size_t bytes, uint8_t value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.insert(m_pending.end(), bytes, value);
+            m_changed.notify_all();
+        }
+
+        void End()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ended = true;
+            m_changed.notify_all();
+        }
+
+        // Waits until the prefetch thread is blocked in Read.
+        bool WaitUntilReading()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(5), [&] { return m_reading; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::vector<uint8_t> m_pending;
+        bool m_ended = false;
+        bool m_reading = false;
+    };
+
+    AudioPlayer::AudioPlayerStreamImpl::PullSource ReadFrom(std::shared_ptr<GatedSource> source)
+    {
+        return [source](uint8_t* buffer, uint32_t size) { return source->Read(buffer, size); };
+    }
+
+    // Counts ready callbacks, which come from the prefetch thread.
+    class ReadySignal
+    {
+    public:
+        std::function<void()> Callback()
+        {
+            return [this]
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_count++;
+                m_changed.notify_all();
+            };
+        }
+
+        bool WaitFor(int count)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(5), [&] { return m_count >= count; });
+        }
+
+        int Count()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_count;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        int m_count = 0;
+    };
+
+    // Waits for the prefetch thread to let go of the source, which it only does on the way out.
+    bool WaitForRelease(const std::weak_ptr<GatedSource>& source)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!source.expired())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(AudioPlayerStreamTests)
+    {
+    public:
+
+        TEST_METHOD(TestPullStreamTryReadDoesNotWaitForTheSource)
+        {
+            auto source = std::make_shared<GatedSource>();
+            AudioPlayer::AudioPlayerStreamImpl stream(ReadFrom(source));
+            Assert::IsTrue(source->WaitUntilReading());
+
+            unsigned char buffer[256];
+            auto start = std::chrono::steady_clock::now();
+            unsigned int bytes = stream.TryRead(buffer, sizeof(buffer));
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            Assert::AreEqual(0u, bytes);
+            Assert::IsTrue(elapsed < std::chrono::milliseconds(50), L"TryRead waited on the source");
+            Assert::AreEqual((size_t)0, stream.Available());
+            Assert::IsFalse(stream.IsEndOfStream());
+
+            ReadySignal ready;
+            stream.SetReadyCallback(ready.Callback());
+            source->Deliver(100, 7);
+            Assert::IsTrue(ready.WaitFor(1));
+            Assert::AreEqual((size_t)100, stream.Available());
+            Assert::AreEqual(100u, stream.TryRead(buffer, sizeof(buffer)));
+            Assert::AreEqual((unsigned char)7, buffer[99]);
+            Assert::AreEqual(0u, stream.TryRead(buffer, sizeof(buffer)));
+            stream.SetReadyCallback(nullptr);
+            source->End();
+        }
+
+        TEST_METHOD(TestPullStreamReadyCallbackFiresForDataAndForTheEnd)
+        {
+            auto source = std::make_shared<GatedSource>();
+            AudioPlayer::AudioPlayerStreamImpl stream(ReadFrom(source));
+            Assert::IsTrue(source->WaitUntilReading());
+
+            ReadySignal ready;
+            stream.SetReadyCallback(ready.Callback());
+            Assert::AreEqual(0, ready.Count(), L"Called back with nothing buffered");
+
+            source->Deliver(64, 1);
+            Assert::IsTrue(ready.WaitFor(1));
+            source->End();
+            Assert::IsTrue(ready.WaitFor(2));
+            Assert::IsTrue(stream.IsFullyBuffered());
+            Assert::IsFalse(stream.IsEndOfStream(), L"Ended with audio still unread");
+
+            unsigned char buffer[128];
+            Assert::AreEqual(64u, stream.Read(buffer, sizeof(buffer)));
+            Assert::IsTrue(stream.IsEndOfStream());
+
+            // registering after the end calls back straight away
+            ReadySignal late;
+            stream.SetReadyCallback(late.Callback());
+            Assert::AreEqual(1, late.Count());
+        }
+
+        TEST_METHOD(TestPullStreamDiscardWhileTheSourceIsBlocked)
+        {
+            auto source = std::make_shared<GatedSource>();
+            std::weak_ptr<GatedSource> watched = source;
+            AudioPlayer::AudioPlayerStreamImpl stream(ReadFrom(source));
+            Assert::IsTrue(source->WaitUntilReading());
+
+            ReadySignal ready;
+            stream.SetReadyCallback(ready.Callback());
+            stream.Discard();
+            unsigned char buffer[128];
+            Assert::AreEqual(0u, stream.Read(buffer, sizeof(buffer)));
+            Assert::IsTrue(stream.IsEndOfStream());
+
+            // what the source delivers afterwards is dropped and the thread goes away
+            source->Deliver(128, 3);
+            source.reset();
+            Assert::IsTrue(WaitForRelease(watched));
+            Assert::AreEqual(0u, stream.TryRead(buffer, sizeof(buffer)));
+            Assert::AreEqual(0, ready.Count());
+        }
+
+        TEST_METHOD(TestPullStreamDestroyedWhileTheSourceIsBlocked)
+        {
+            auto source = std::make_shared<GatedSource>();
+            std::weak_ptr<GatedSource> watched = source;
+            ReadySignal ready;
+            {
+                AudioPlayer::AudioPlayerStreamImpl stream(ReadFrom(source));
+                Assert::IsTrue(source->WaitUntilReading());
+                stream.SetReadyCallback(ready.Callback());
+            }
+
+            // the thread is still blocked in the source and writes into its own ring once it returns
+            source->Deliver(AudioPlayer::AudioPlayerStreamImpl::PrefetchCapacity, 5);
+            source.reset();
+            Assert::IsTrue(WaitForRelease(watched));
+            Assert::AreEqual(0, ready.Count());
+        }
+    };
+}
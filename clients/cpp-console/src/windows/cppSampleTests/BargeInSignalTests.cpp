@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "AudioPlayerEntry.h"
+#include <chrono>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace AudioPlayer;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(BargeInSignalTests)
+    {
+    public:
+
+        TEST_METHOD(TestBargeInSignalCompletesEveryPostWithOneFlush)
+        {
+            BargeInSignal signal;
+            std::vector<std::chrono::steady_clock::time_point> silentTimes;
+            auto onSilent = [&silentTimes](std::chrono::steady_clock::time_point silentAt, bool wasAudible)
+            {
+                Assert::IsTrue(wasAudible);
+                silentTimes.push_back(silentAt);
+            };
+
+            Assert::IsFalse(signal.Pending());
+            signal.Post(onSilent);
+            signal.Post(onSilent);
+            Assert::IsTrue(signal.Pending());
+
+            signal.Complete(true);
+
+            Assert::IsFalse(signal.Pending());
+            Assert::AreEqual((size_t)2, silentTimes.size());
+            Assert::IsTrue(silentTimes[0] == silentTimes[1]);
+        }
+
+        TEST_METHOD(TestAudioPlayerEntryQueueClearCancelsQueuedPlayback)
+        {
+            unsigned char chunk[16] = { 0 };
+            AudioPlayerEntryQueue queue;
+            int canceled = 0;
+            queue.Push(AudioPlayerEntry(chunk, sizeof(chunk)));
+            AudioPlayerEntry entry(chunk, sizeof(chunk));
+            entry.m_onPlaybackEnding = [&canceled](bool wasCanceled) { canceled += wasCanceled ? 1 : 0; };
+            queue.Push(std::move(entry));
+
+            queue.Clear();
+
+            Assert::IsTrue(queue.Empty());
+            Assert::AreEqual(1, canceled);
+        }
+    };
+}
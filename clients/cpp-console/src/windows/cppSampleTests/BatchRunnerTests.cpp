@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include "CppUnitTest.h"
+#include "BatchRunner.h"
+#include "PushPacer.h"
+#include "WavHeader.h"
+#include <experimental/filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+    // Writes seconds of silence as 16 bit PCM.
+    void WriteSilence(const std::string& path, uint32_t samplesPerSecond, uint16_t channels, double seconds)
+    {
+        WavFile::WavFormat format;
+        format.formatTag = 1;
+        format.channels = channels;
+        format.samplesPerSecond = samplesPerSecond;
+        format.bitsPerSample = 16;
+        format.blockAlign = channels * 2;
+        format.averageBytesPerSecond = samplesPerSecond * format.blockAlign;
+        uint32_t dataLength = (uint32_t)(samplesPerSecond * seconds) * format.blockAlign;
+
+        unsigned char header[WavFile::CanonicalHeaderSize];
+        WavFile::WriteHeader(format, dataLength, header);
+        std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        out.write((const char*)header, sizeof(header));
+        std::vector<char> samples(dataLength);
+        out.write(samples.data(), samples.size());
+    }
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(BatchRunnerTests)
+    {
+    public:
+
+        TEST_METHOD(TestBatchRunnerLocalRunWritesAResultPerUtterance)
+        {
+            char directory[L_tmpnam];
+            tmpnam_s(directory, sizeof(directory));
+            fs::create_directories(directory);
+            std::string alpha = (fs::path(directory) / "alpha.wav").string();
+            std::string beta = (fs::path(directory) / "beta.wav").string();
+            WriteSilence(alpha, 16000, 1, 0.5);
+            // converted to 16 khz mono on the way in
+            WriteSilence(beta, 8000, 2, 0.5);
+            std::ofstream((fs::path(directory) / "notes.txt").string()) << "not audio";
+
+            auto config = std::make_shared<AgentConfiguration>();
+            config->_fileInputSpeed = 0;
+            BatchRunner::Options options;
+            options.local = true;
+            options.concurrency = 2;
+            options.localResponseDelay = std::chrono::milliseconds(20);
+            options.activityGrace = std::chrono::milliseconds(100);
+            options.resultsPath = (fs::path(directory) / "results.jsonl").string();
+
+            auto inputs = BatchRunner::LoadInputs(directory);
+            Assert::AreEqual((size_t)2, inputs.size());
+            BatchRunner runner(config, options);
+            Assert::AreEqual((size_t)0, runner.Run(inputs));
+            Assert::AreEqual((uint64_t)2, runner.RecognitionLatency().Count());
+
+            std::ifstream results(options.resultsPath);
+            std::vector<nlohmann::json> rows;
+            std::string line;
+            while (std::getline(results, line))
+            {
+                rows.push_back(nlohmann::json::parse(line));
+            }
+            results.close();
+            Assert::AreEqual((size_t)2, rows.size());
+
+            const char* names[] = { "alpha", "beta" };
+            for (size_t i = 0; i < rows.size(); i++)
+            {
+                auto& row = rows[i];
+                Assert::AreEqual(inputs[i], row["path"].get<std::string>());
+                Assert::AreEqual(std::string(names[i]), row["text"].get<std::string>());
+                Assert::AreEqual((size_t)1, row["activities"].size());
+                auto activity = nlohmann::json::parse(row["activities"][0].get<std::string>());
+                Assert::AreEqual("You said " + std::string(names[i]), activity["text"].get<std::string>());
+                Assert::IsTrue(row["audioSeconds"].get<double>() > 0.49 && row["audioSeconds"].get<double>() < 0.51);
+                Assert::IsTrue(row["recognizedMs"].get<double>() >= 20);
+                // the turn is only over once the activity grace period has passed quietly
+                Assert::IsTrue(row["totalMs"].get<double>() >= row["firstActivityMs"].get<double>() + 100);
+                Assert::IsFalse(row.contains("error"));
+            }
+
+            fs::remove_all(directory);
+        }
+
+        TEST_METHOD(TestPushPacerReleasesChunksAtTheChosenSpeed)
+        {
+            WavFile::WavFormat format;
+            format.channels = 2;
+            format.samplesPerSecond = 48000;
+            format.blockAlign = 4;
+            Assert::AreEqual((uint32_t)(4 * 48000 * PushPacer::ChunkMs / 1000), PushPacer::InputBytesPerChunk(format));
+            Assert::AreEqual((uint32_t)640, PushPacer::InputBytesPerChunk(WavFile::WavFormat()));
+
+            // 200ms of audio at twice real time takes 100ms, less the last chunk, which is not waited for
+            PushPacer pacer(2.0);
+            const uint32_t chunkBytes = (uint32_t)(PushPacer::PushStreamBytesPerSecond * PushPacer::ChunkMs / 1000);
+            for (int i = 0; i < 10; i++)
+            {
+                pacer.WaitForNextChunk();
+                pacer.Pushed(chunkBytes);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - pacer.Started();
+            Assert::IsTrue(elapsed >= std::chrono::milliseconds(90));
+            Assert::IsTrue(pacer.AudioSeconds() > 0.199 && pacer.AudioSeconds() < 0.201);
+
+            PushPacer unpaced(0);
+            unpaced.WaitForNextChunk();
+            unpaced.Pushed(chunkBytes * 1000);
+            unpaced.WaitForNextChunk();
+            Assert::IsFalse(unpaced.IsPaced());
+            Assert::IsTrue(std::chrono::steady_clock::now() - unpaced.Started() < std::chrono::milliseconds(50));
+        }
+    };
+}
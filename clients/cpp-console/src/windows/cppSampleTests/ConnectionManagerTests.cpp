@@ -0,0 +1,236 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "ConnectionManager.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    // A dialog service that only records connection calls and activities. The test decides when the
+    // connection comes up or drops; Disconnect reports the drop straight away, as a service would.
+    class FakeDialogService : public IDialogService
+    {
+    public:
+        virtual void SetHandlers(const DialogServiceHandlers&) final {}
+
+        virtual void SetConnectionHandlers(std::function<void()> connected, std::function<void()> disconnected) final
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_onConnected = connected;
+            m_onDisconnected = disconnected;
+        }
+
+        virtual void Connect() final
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_connects.push_back(std::chrono::steady_clock::now());
+            m_changed.notify_all();
+        }
+
+        virtual void Disconnect() final
+        {
+            RaiseDisconnected();
+        }
+
+        virtual void ListenOnce() final {}
+        virtual void StartKeywordRecognition(const std::string&) final {}
+        virtual void StopKeywordRecognition() final {}
+
+        virtual void SendActivity(const std::string&) final
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activities.push_back(std::chrono::steady_clock::now());
+            m_changed.notify_all();
+        }
+
+        virtual void WriteAudio(const uint8_t*, uint32_t) final {}
+        virtual void CloseAudio() final {}
+
+        void RaiseConnected()
+        {
+            std::function<void()> handler;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                handler = m_onConnected;
+            }
+            if (handler)
+            {
+                handler();
+            }
+        }
+
+        void RaiseDisconnected()
+        {
+            std::function<void()> handler;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                handler = m_onDisconnected;
+            }
+            if (handler)
+            {
+                handler();
+            }
+        }
+
+        // Waits until Connect has been called count times in all.
+        bool WaitForConnects(size_t count, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, timeout, [&] { return m_connects.size() >= count; });
+        }
+
+        // Waits until count activities have been sent in all.
+        bool WaitForActivities(size_t count, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, timeout, [&] { return m_activities.size() >= count; });
+        }
+
+        std::vector<TimePoint> Connects()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_connects;
+        }
+
+        std::vector<TimePoint> Activities()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_activities;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::function<void()> m_onConnected;
+        std::function<void()> m_onDisconnected;
+        std::vector<TimePoint> m_connects;
+        std::vector<TimePoint> m_activities;
+    };
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(ConnectionManagerTests)
+    {
+    public:
+
+        TEST_METHOD(TestConnectionManagerSendsKeepAliveOnlyAfterIdleInterval)
+        {
+            const std::chrono::milliseconds interval(200);
+            auto service = std::make_shared<FakeDialogService>();
+            ConnectionManager connection(service, interval);
+            connection.Start();
+            service->RaiseConnected();
+            auto connectedAt = std::chrono::steady_clock::now();
+
+            // activity keeps pushing the deadline back
+            while (std::chrono::steady_clock::now() - connectedAt < 3 * interval)
+            {
+                connection.NoteActivity();
+                std::this_thread::sleep_for(interval / 20);
+            }
+            Assert::AreEqual((size_t)0, service->Activities().size(), L"Kept alive while there was activity");
+            auto lastActivity = std::chrono::steady_clock::now();
+            connection.NoteActivity();
+
+            Assert::IsTrue(service->WaitForActivities(1));
+            Assert::IsTrue(service->Activities()[0] - lastActivity >= interval);
+            Assert::AreEqual((uint64_t)1, connection.KeepAlivesSent());
+
+            // a keepalive counts as activity, so the next one is another interval later
+            Assert::IsTrue(service->WaitForActivities(2));
+            auto sent = service->Activities();
+            Assert::IsTrue(sent[1] - sent[0] >= interval);
+            connection.Stop();
+        }
+
+        TEST_METHOD(TestConnectionManagerDoublesTheReconnectDelay)
+        {
+            const std::chrono::milliseconds firstDelay(20);
+            auto service = std::make_shared<FakeDialogService>();
+            ConnectionManager connection(service, std::chrono::milliseconds(0), firstDelay);
+            connection.Start();
+            service->RaiseConnected();
+            std::this_thread::sleep_for(firstDelay);
+            service->RaiseDisconnected();
+
+            // the service never comes back, so every attempt waits twice as long as the one before
+            Assert::IsTrue(service->WaitForConnects(5));
+            connection.Stop();
+            auto connects = service->Connects();
+            for (size_t i = 2; i < 5; i++)
+            {
+                Assert::IsTrue(connects[i] - connects[i - 1] >= firstDelay * (1 << (i - 1)));
+            }
+
+            // a connection that comes up resets the backoff; without that the next attempt would wait 4 times as long
+            const std::chrono::milliseconds resetDelay(50);
+            auto reconnected = std::make_shared<FakeDialogService>();
+            ConnectionManager again(reconnected, std::chrono::milliseconds(0), resetDelay);
+            again.Start();
+            reconnected->RaiseConnected();
+            std::this_thread::sleep_for(resetDelay);
+            reconnected->RaiseDisconnected();
+            Assert::IsTrue(reconnected->WaitForConnects(3));
+            reconnected->RaiseConnected();
+            std::this_thread::sleep_for(resetDelay);
+            auto droppedAt = std::chrono::steady_clock::now();
+            reconnected->RaiseDisconnected();
+            Assert::IsTrue(reconnected->WaitForConnects(4));
+            Assert::IsTrue(reconnected->Connects()[3] - droppedAt < resetDelay * 4);
+            Assert::AreEqual((uint64_t)1, again.ReconnectCount());
+            again.Stop();
+        }
+
+        TEST_METHOD(TestConnectionManagerDoesNotReconnectBeforeTheFirstDrop)
+        {
+            const std::chrono::milliseconds firstDelay(20);
+            auto service = std::make_shared<FakeDialogService>();
+            ConnectionManager connection(service, std::chrono::milliseconds(0), firstDelay);
+            connection.Start();
+
+            // Start's own connect has not come up yet, and a failed first connect is not a drop either
+            std::this_thread::sleep_for(firstDelay * 5);
+            service->RaiseDisconnected();
+            std::this_thread::sleep_for(firstDelay * 5);
+            Assert::AreEqual((size_t)1, service->Connects().size());
+            Assert::IsFalse(connection.IsConnected());
+            connection.Stop();
+        }
+
+        TEST_METHOD(TestConnectionManagerDoesNotReconnectAfterARequestedDisconnect)
+        {
+            const std::chrono::milliseconds firstDelay(20);
+            auto service = std::make_shared<FakeDialogService>();
+            ConnectionManager connection(service, std::chrono::milliseconds(0), firstDelay);
+            connection.Start();
+            service->RaiseConnected();
+            std::this_thread::sleep_for(firstDelay);
+
+            connection.Disconnect();
+            std::this_thread::sleep_for(firstDelay * 5);
+            Assert::AreEqual((size_t)1, service->Connects().size(), L"Reconnected after a requested disconnect");
+            Assert::AreEqual((uint64_t)1, connection.DisconnectCount());
+
+            // once the caller has connected again, a drop is reconnected as usual
+            service->Connect();
+            service->RaiseConnected();
+            std::this_thread::sleep_for(firstDelay);
+            service->RaiseDisconnected();
+            Assert::IsTrue(service->WaitForConnects(3));
+            connection.Stop();
+        }
+    };
+}
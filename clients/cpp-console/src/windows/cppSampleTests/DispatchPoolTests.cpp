@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "DispatchPool.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(DispatchPoolTests)
+    {
+    public:
+
+        TEST_METHOD(TestDispatchPoolRunsEveryTaskBeforeDestruction)
+        {
+            std::atomic<int> ran{ 0 };
+            {
+                DispatchPool pool(4);
+                for (int i = 0; i < 1000; i++)
+                {
+                    pool.Submit([&ran] { ran++; });
+                }
+            }
+            Assert::AreEqual(1000, ran.load());
+        }
+
+        TEST_METHOD(TestDispatchPoolWithOneThreadRunsTasksInOrder)
+        {
+            std::mutex mutex;
+            std::vector<int> order;
+            {
+                DispatchPool pool(1);
+                for (int i = 0; i < 100; i++)
+                {
+                    pool.Submit([&mutex, &order, i]
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        order.push_back(i);
+                    });
+                }
+            }
+
+            Assert::AreEqual((size_t)100, order.size());
+            for (int i = 0; i < 100; i++)
+            {
+                Assert::AreEqual(i, order[i]);
+            }
+        }
+    };
+}
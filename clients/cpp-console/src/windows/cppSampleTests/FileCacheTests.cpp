@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "FileCache.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    void WriteFile(const std::string& path, const std::string& contents)
+    {
+        std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        out << contents;
+    }
+
+    // Loads the contents of the file, refusing a file that says "bad" the way a model loader refuses a truncated model.
+    std::shared_ptr<std::string> LoadContents(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        auto contents = std::make_shared<std::string>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (*contents == "bad")
+        {
+            throw std::runtime_error("bad file " + path);
+        }
+        return contents;
+    }
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(FileCacheTests)
+    {
+    public:
+
+        TEST_METHOD(TestFileCacheLoadsOnceUntilTheFileChanges)
+        {
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+            WriteFile(path, "model one");
+
+            FileCache<std::string> cache(LoadContents);
+            auto first = cache.Get(path);
+            auto second = cache.Get(path);
+            auto third = cache.Get(path);
+            Assert::IsTrue(first == second && second == third);
+            Assert::AreEqual((uint64_t)1, cache.Loads());
+            Assert::AreEqual((uint64_t)2, cache.Hits());
+
+            // a different size is a change even if the modification time has not ticked over
+            WriteFile(path, "model number two");
+            auto reloaded = cache.Get(path);
+            Assert::AreEqual(std::string("model number two"), *reloaded);
+            Assert::AreEqual((uint64_t)2, cache.Loads());
+            // whoever still holds the old model keeps it
+            Assert::AreEqual(std::string("model one"), *first);
+
+            remove(path);
+        }
+
+        TEST_METHOD(TestFileCacheKeepsThePreviousObjectWhenAReloadFails)
+        {
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+            WriteFile(path, "good model");
+
+            FileCache<std::string> cache(LoadContents);
+            auto good = cache.Get(path);
+
+            WriteFile(path, "bad");
+            Assert::IsTrue(cache.Get(path) == good);
+            Assert::AreEqual((uint64_t)1, cache.FailedReloads());
+
+            remove(path);
+            Assert::IsTrue(cache.Get(path) == good);
+            Assert::AreEqual((uint64_t)2, cache.FailedReloads());
+            Assert::AreEqual((uint64_t)1, cache.Loads());
+        }
+
+        TEST_METHOD(TestFileCacheThrowsForAFileThatNeverLoaded)
+        {
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+
+            FileCache<std::string> cache(LoadContents);
+            bool threw = false;
+            try
+            {
+                cache.Get(path);
+            }
+            catch (const std::runtime_error&)
+            {
+                threw = true;
+            }
+            Assert::IsTrue(threw);
+            Assert::AreEqual((uint64_t)0, cache.Loads());
+        }
+    };
+}
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "LocalDialogService.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Microsoft::CognitiveServices::Speech;
+
+namespace cppSampleTests
+{
+    // Records the events a dialog service raises, in order.
+    class EventLog
+    {
+    public:
+        DialogServiceHandlers Handlers()
+        {
+            DialogServiceHandlers handlers;
+            handlers.sessionStarted = [this](const std::string&) { Add("started"); };
+            handlers.sessionStopped = [this](const std::string&) { Add("stopped"); };
+            handlers.recognized = [this](ResultReason reason, const std::string& text)
+            {
+                Add(reason == ResultReason::RecognizedKeyword ? "keyword" : "recognized:" + text);
+            };
+            handlers.activityReceived = [this](const std::string&, std::shared_ptr<IAudioPlayerStream> audio)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_audio = audio;
+                m_activities++;
+                m_events.push_back("activity");
+                m_changed.notify_all();
+            };
+            return handlers;
+        }
+
+        bool WaitForActivities(int count)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(5), [&] { return m_activities >= count; });
+        }
+
+        std::vector<std::string> Events()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_events;
+        }
+
+        std::shared_ptr<IAudioPlayerStream> LastAudio()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_audio;
+        }
+
+    private:
+        void Add(const std::string& event)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_events.push_back(event);
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::vector<std::string> m_events;
+        std::shared_ptr<IAudioPlayerStream> m_audio;
+        int m_activities = 0;
+    };
+
+    TEST_CLASS(LocalDialogServiceTests)
+    {
+    public:
+
+        TEST_METHOD(TestLocalDialogServiceAnswersOncePushedAudioEnds)
+        {
+            LocalDialogService::Script script;
+            script.recognizedDelay = std::chrono::milliseconds(20);
+            script.activityDelay = std::chrono::milliseconds(10);
+            LocalDialogService::Turn turn;
+            turn.text = "what time is it";
+            turn.ttsDuration = std::chrono::milliseconds(500);
+            script.turns.push_back(turn);
+
+            EventLog log;
+            LocalDialogService service(script, true);
+            service.SetHandlers(log.Handlers());
+            service.ListenOnce();
+
+            unsigned char audio[640] = { 0 };
+            service.WriteAudio(audio, sizeof(audio));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            Assert::AreEqual((size_t)1, log.Events().size(), L"Recognized before the audio ended");
+
+            service.CloseAudio();
+            Assert::IsTrue(log.WaitForActivities(1));
+
+            std::vector<std::string> expected = { "started", "recognized:what time is it", "stopped", "activity" };
+            Assert::IsTrue(expected == log.Events());
+            Assert::AreEqual((size_t)(16000 * 2 / 2), log.LastAudio()->Available());
+            Assert::AreEqual((uint64_t)sizeof(audio), service.AudioBytesReceived());
+            service.SetHandlers(DialogServiceHandlers());
+        }
+
+        TEST_METHOD(TestLocalDialogServiceRepeatsKeywordWhileArmed)
+        {
+            LocalDialogService::Script script;
+            script.keywordAfter = std::chrono::milliseconds(10);
+            script.turns.push_back(LocalDialogService::Turn());
+
+            EventLog log;
+            LocalDialogService service(script, false);
+            service.SetHandlers(log.Handlers());
+            service.StartKeywordRecognition("model.table");
+            Assert::IsTrue(log.WaitForActivities(3));
+            service.StopKeywordRecognition();
+            service.SetHandlers(DialogServiceHandlers());
+
+            auto events = log.Events();
+            Assert::AreEqual(std::string("started"), events[0]);
+            Assert::AreEqual(std::string("keyword"), events[1]);
+            Assert::AreEqual(std::string("recognized:hello"), events[2]);
+            Assert::IsTrue(service.TurnsCompleted() >= 3);
+        }
+
+        TEST_METHOD(TestLocalDialogServiceAnswersAKeywordHeardWhileConnecting)
+        {
+            // DialogManager arms keyword recognition before the connection is up, so the turn after an early
+            // keyword has to wait for the connection rather than be lost
+            LocalDialogService::Script script;
+            script.connectDelay = std::chrono::milliseconds(300);
+            script.keywordAfter = std::chrono::milliseconds(20);
+            script.turns.push_back(LocalDialogService::Turn());
+
+            EventLog log;
+            LocalDialogService service(script, false);
+            service.SetHandlers(log.Handlers());
+            std::atomic<bool> connected{ false };
+            service.SetConnectionHandlers([&] { connected = true; }, nullptr);
+
+            auto start = std::chrono::steady_clock::now();
+            service.StartKeywordRecognition("model.table");
+            std::thread connecting([&] { service.Connect(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            Assert::IsFalse(connected.load(), L"Connected before the connect delay");
+
+            Assert::IsTrue(log.WaitForActivities(1));
+            auto answered = std::chrono::steady_clock::now();
+            service.StopKeywordRecognition();
+            connecting.join();
+            service.SetHandlers(DialogServiceHandlers());
+            service.SetConnectionHandlers(nullptr, nullptr);
+
+            Assert::IsTrue(connected.load());
+            Assert::IsTrue(answered - start >= script.connectDelay);
+            auto events = log.Events();
+            std::vector<std::string> expected = { "started", "keyword", "recognized:hello", "stopped", "activity" };
+            Assert::IsTrue(std::vector<std::string>(events.begin(), events.begin() + expected.size()) == expected);
+        }
+    };
+}
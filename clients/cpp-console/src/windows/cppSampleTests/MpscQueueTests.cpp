@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "MpscQueue.h"
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(MpscQueueTests)
+    {
+    public:
+
+        TEST_METHOD(TestMpscQueueKeepsPerProducerOrder)
+        {
+            const int producerCount = 4;
+            const int itemsPerProducer = 50000;
+            MpscQueue<int> queue;
+
+            std::vector<std::thread> producers;
+            for (int p = 0; p < producerCount; p++)
+            {
+                producers.emplace_back([&queue, p, itemsPerProducer]()
+                    {
+                        for (int i = 0; i < itemsPerProducer; i++)
+                        {
+                            queue.Push(p * itemsPerProducer + i);
+                        }
+                    });
+            }
+
+            std::vector<int> next(producerCount, 0);
+            int received = 0;
+            int item;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (received < producerCount * itemsPerProducer)
+            {
+                if (!queue.WaitPop(item, std::chrono::milliseconds(100)))
+                {
+                    Assert::IsTrue(std::chrono::steady_clock::now() < deadline, L"Timed out waiting for the producers");
+                    continue;
+                }
+                int producer = item / itemsPerProducer;
+                Assert::AreEqual(next[producer], item % itemsPerProducer);
+                next[producer]++;
+                received++;
+            }
+
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+            Assert::IsFalse(queue.TryPop(item));
+        }
+    };
+}
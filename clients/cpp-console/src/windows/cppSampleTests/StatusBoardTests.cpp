@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "StatusBoard.h"
+#include <Windows.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(StatusBoardTests)
+    {
+    public:
+
+        TEST_METHOD(TestStatusBoardPublishesUpdatesToOtherMappings)
+        {
+            StatusBoard board;
+            Assert::AreEqual(0, board.Open("Local\\cppSampleTests.statusBoard"));
+            board.Update([](StatusBoardFields& fields)
+                {
+                    fields.deviceStatus = 4;
+                    fields.turnsStarted = 7;
+                });
+
+            // map it again the way another process would
+            HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, "Local\\cppSampleTests.statusBoard");
+            Assert::IsNotNull(mapping);
+            auto segment = static_cast<const StatusBoardSegment*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(StatusBoardSegment)));
+            Assert::IsNotNull(segment);
+
+            Assert::AreEqual(STATUS_BOARD_MAGIC, segment->magic);
+            Assert::AreEqual((uint32_t)sizeof(StatusBoardFields), segment->fieldsSize);
+            Assert::AreEqual(0u, segment->sequence % 2);
+            Assert::AreEqual(4u, segment->fields.deviceStatus);
+            Assert::AreEqual((uint64_t)7, segment->fields.turnsStarted);
+
+            uint32_t before = segment->sequence;
+            board.Update([](StatusBoardFields& fields) { fields.muted = 1; });
+            Assert::AreEqual(before + 2, segment->sequence);
+            // fields not touched by an update keep their values
+            Assert::AreEqual(4u, segment->fields.deviceStatus);
+
+            UnmapViewOfFile(segment);
+            CloseHandle(mapping);
+        }
+    };
+}
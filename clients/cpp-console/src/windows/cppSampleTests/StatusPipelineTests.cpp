@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "StatusPipeline.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(StatusPipelineTests)
+    {
+    public:
+
+        TEST_METHOD(TestStatusPipelineDropsRepeatedStatus)
+        {
+            std::mutex mutex;
+            std::vector<DeviceStatus> shown;
+            uint64_t suppressed = 0;
+            {
+                StatusPipeline pipeline(std::chrono::milliseconds(0), [&mutex, &shown](DeviceStatus status, bool)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shown.push_back(status);
+                });
+                for (int i = 0; i < 10; i++)
+                {
+                    pipeline.Post(DeviceStatus::Detecting, false);
+                }
+                suppressed = pipeline.Suppressed();
+            }
+            Assert::AreEqual((size_t)1, shown.size());
+            Assert::AreEqual((uint64_t)9, suppressed);
+        }
+
+        TEST_METHOD(TestStatusPipelineShowsOnlyTheLatestStatusOfABurst)
+        {
+            std::mutex mutex;
+            std::vector<DeviceStatus> shown;
+            {
+                // long enough that the burst below always lands inside the window
+                StatusPipeline pipeline(std::chrono::seconds(60), [&mutex, &shown](DeviceStatus status, bool)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shown.push_back(status);
+                });
+                pipeline.Post(DeviceStatus::Detecting, false);
+                while (pipeline.Delivered() == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+
+                pipeline.Post(DeviceStatus::Listening, false);
+                pipeline.Post(DeviceStatus::Thinking, false);
+                pipeline.Post(DeviceStatus::Speaking, false);
+
+                // destruction ends the window early and shows what is pending
+            }
+            Assert::AreEqual((size_t)2, shown.size());
+            Assert::IsTrue(shown[0] == DeviceStatus::Detecting);
+            Assert::IsTrue(shown[1] == DeviceStatus::Speaking);
+        }
+    };
+}
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "Tracer.h"
+#include <string>
+#include <thread>
+
+//the pragma here suppresses warnings from the 3rd party header
+#pragma warning(push, 0)
+#pragma warning (disable : 26451)
+#pragma warning (disable : 26444)
+#pragma warning (disable : 28020)
+#pragma warning (disable : 26495)
+#include "json.hpp"
+#pragma warning(pop)
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    // The exported events with the given name. Each test records on a thread of its own, since rings are per thread.
+    std::vector<nlohmann::json> EventsNamed(const std::string& name)
+    {
+        std::vector<nlohmann::json> found;
+        auto trace = nlohmann::json::parse(Tracer::Instance().ToChromeTraceJson());
+        for (auto& event : trace["traceEvents"])
+        {
+            if (event["name"] == name || (event["ph"] == "M" && event["args"]["name"] == name))
+            {
+                found.push_back(event);
+            }
+        }
+        return found;
+    }
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(TracerTests)
+    {
+    public:
+
+        TEST_METHOD(TestTracerExportsSpansAndInstantsAsChromeTrace)
+        {
+            bool wasEnabled = Tracer::Instance().Enabled();
+            Tracer::Instance().Enable(true);
+            std::thread worker([]
+                {
+                    Tracer::Instance().SetThreadName("TracerTests worker");
+                    {
+                        TraceSpan span("test", "TracerTestsSpan");
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    }
+                    Tracer::Instance().Instant("test", "TracerTestsInstant");
+                });
+            worker.join();
+            Tracer::Instance().Enable(wasEnabled);
+
+            auto spans = EventsNamed("TracerTestsSpan");
+            auto instants = EventsNamed("TracerTestsInstant");
+            auto threadNames = EventsNamed("TracerTests worker");
+            Assert::AreEqual((size_t)1, spans.size());
+            Assert::AreEqual((size_t)1, instants.size());
+            Assert::AreEqual((size_t)1, threadNames.size());
+
+            Assert::IsTrue(spans[0]["ph"] == "X");
+            Assert::IsTrue(spans[0]["dur"].get<int64_t>() >= 2000);
+            Assert::IsTrue(instants[0]["ph"] == "i");
+            Assert::IsTrue(instants[0]["ts"].get<int64_t>() >= spans[0]["ts"].get<int64_t>() + spans[0]["dur"].get<int64_t>());
+            Assert::IsTrue(threadNames[0]["tid"] == spans[0]["tid"]);
+        }
+
+        TEST_METHOD(TestTracerKeepsTheLatestEventsOfEachThread)
+        {
+            bool wasEnabled = Tracer::Instance().Enabled();
+            Tracer::Instance().Enable(true);
+            std::thread worker([]
+                {
+                    for (int i = 0; i < 10; i++)
+                    {
+                        Tracer::Instance().Instant("test", "TracerTestsOldEvent");
+                    }
+                    for (size_t i = 0; i < Tracer::EventsPerThread; i++)
+                    {
+                        Tracer::Instance().Instant("test", "TracerTestsNewEvent");
+                    }
+                });
+            worker.join();
+            Tracer::Instance().Enable(wasEnabled);
+
+            Assert::AreEqual((size_t)0, EventsNamed("TracerTestsOldEvent").size());
+            Assert::AreEqual(Tracer::EventsPerThread, EventsNamed("TracerTestsNewEvent").size());
+        }
+
+        TEST_METHOD(TestTraceSpanRecordsNothingWhileDisabled)
+        {
+            bool wasEnabled = Tracer::Instance().Enabled();
+            Tracer::Instance().Enable(false);
+            std::thread worker([]
+                {
+                    TraceSpan span("test", "TracerTestsDisabledSpan");
+                    Tracer::Instance().Instant("test", "TracerTestsDisabledInstant");
+                });
+            worker.join();
+            Tracer::Instance().Enable(wasEnabled);
+
+            Assert::AreEqual((size_t)0, EventsNamed("TracerTestsDisabledSpan").size());
+            Assert::AreEqual((size_t)0, EventsNamed("TracerTestsDisabledInstant").size());
+        }
+
+        TEST_METHOD(TestTracerReusesTheRingsOfExitedThreads)
+        {
+            bool wasEnabled = Tracer::Instance().Enabled();
+            Tracer::Instance().Enable(true);
+            uint64_t droppedBefore = Tracer::Instance().EventsDropped();
+            // many more threads than there are rings, but never more than one at a time
+            for (size_t i = 0; i < 2 * Tracer::MaxThreads; i++)
+            {
+                std::thread worker([i]
+                    {
+                        Tracer::Instance().Instant("test", i == 0 ? "TracerTestsFirstThread" : "TracerTestsLaterThread");
+                    });
+                worker.join();
+            }
+            std::thread last([]
+                {
+                    Tracer::Instance().SetThreadName("TracerTests last thread");
+                    Tracer::Instance().Instant("test", "TracerTestsLastThread");
+                });
+            last.join();
+            Tracer::Instance().Enable(wasEnabled);
+
+            Assert::AreEqual(droppedBefore, Tracer::Instance().EventsDropped());
+            // the first thread's ring has been taken over, and the events left belong to the thread that took it
+            Assert::AreEqual((size_t)0, EventsNamed("TracerTestsFirstThread").size());
+            auto lastEvents = EventsNamed("TracerTestsLastThread");
+            auto threadNames = EventsNamed("TracerTests last thread");
+            Assert::AreEqual((size_t)1, lastEvents.size());
+            Assert::AreEqual((size_t)1, threadNames.size());
+            Assert::IsTrue(threadNames[0]["tid"] == lastEvents[0]["tid"]);
+        }
+    };
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "TurnTracker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std::chrono;
+
+namespace cppSampleTests
+{
+    TEST_CLASS(TurnTrackerTests)
+    {
+    public:
+
+        TEST_METHOD(TestTurnTrackerRecordsFirstMarkPerStage)
+        {
+            TurnTracker tracker;
+            auto start = steady_clock::now();
+
+            uint64_t first = tracker.StartTurn(start);
+            Assert::IsTrue(tracker.Mark(TurnTracker::Stage::FinalRecognized, start + milliseconds(800)));
+            Assert::IsFalse(tracker.Mark(TurnTracker::Stage::FinalRecognized, start + milliseconds(900)));
+            Assert::IsTrue(tracker.Mark(first, TurnTracker::Stage::FirstActivity, start + milliseconds(1100)));
+
+            const LatencyHistogram& sinceStart = tracker.SinceTurnStart(TurnTracker::Stage::FirstActivity);
+            const LatencyHistogram& sincePrevious = tracker.SincePreviousStage(TurnTracker::Stage::FirstActivity);
+            Assert::AreEqual((uint64_t)1, sinceStart.Count());
+            Assert::IsTrue(sinceStart.Max() > 1050000 && sinceStart.Max() < 1150000);
+            Assert::IsTrue(sincePrevious.Max() > 280000 && sincePrevious.Max() < 320000);
+
+            // a late callback from the first turn does not count against the second
+            tracker.StartTurn(start + seconds(5));
+            Assert::IsFalse(tracker.Mark(first, TurnTracker::Stage::PlaybackEnded, start + seconds(6)));
+            Assert::AreEqual((uint64_t)0, tracker.SinceTurnStart(TurnTracker::Stage::PlaybackEnded).Count());
+
+            std::string json = tracker.ToJson();
+            Assert::IsTrue(json.find("\"firstActivity\"") != std::string::npos);
+            Assert::IsTrue(json.find("\"turns\": 2") != std::string::npos);
+        }
+    };
+}
@@ -0,0 +1,266 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "CppUnitTest.h"
+#include "Activity.h"
+#include "AsyncLogger.h"
+#include "log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// The operator new counter in AudioBufferPoolTests.cpp.
+extern std::atomic<bool> g_countAllocations;
+extern std::atomic<uint64_t> g_allocationCount;
+
+namespace
+{
+    // Times fn over iterations runs and returns the mean in microseconds.
+    template <typename Fn>
+    double MeanMicroseconds(int iterations, Fn fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    }
+
+    // A message activity shaped like the service's, with an adaptive card attachment grown to about targetBytes.
+    // The keys are in the order the service sends them, so the routed fields come after the attachment.
+    std::string MakeActivity(size_t targetBytes)
+    {
+        std::string facts;
+        int i = 0;
+        while (facts.size() + 600 < targetBytes)
+        {
+            if (!facts.empty())
+            {
+                facts += ",";
+            }
+            facts += R"({"type":"ColumnSet","columns":[{"type":"Column","width":"auto","items":[{"type":"Image","url":"https://example.com/icons/)"
+                + std::to_string(i) + R"(.png","size":"small"}]},{"type":"Column","width":"stretch","items":[{"type":"TextBlock","text":"Forecast for day )"
+                + std::to_string(i) + R"(: partly cloudy with a high of 21 degrees","wrap":true},{"type":"TextBlock","text":"Humidity 40%, wind 12 km/h","isSubtle":true,"spacing":"none"}]}]})";
+            i++;
+        }
+
+        return R"({"attachments":[{"contentType":"application/vnd.microsoft.card.adaptive","content":{"type":"AdaptiveCard","version":"1.2","body":[)"
+            + facts + R"(]}}],"channelData":{"conversationalAiData":{"requestInfo":{"interactionId":"4e1c7d9a"}}},)"
+            R"("conversation":{"id":"a1b2c3"},"from":{"id":"weather-bot","name":"Weather"},"id":"7f3e1b2a",)"
+            R"("inputHint":"expectingInput","locale":"en-US","replyToId":"5d4c3b2a","serviceUrl":"PersistentConnection",)"
+            R"("speak":"Here is the forecast.","text":"Here is the forecast for this week.","timestamp":"2020-01-01T00:00:00Z","type":"message"})";
+    }
+
+    // The log_t this repo had before AsyncLogger: a flush per argument and a localtime per line, on the caller's thread.
+    void FlushingLog(std::ostream& out)
+    {
+        out << std::endl;
+    }
+
+    template <typename T, typename... Args>
+    void FlushingLog(std::ostream& out, T v, Args... args)
+    {
+        out << v << std::flush;
+        FlushingLog(out, args...);
+    }
+
+    template <typename... Args>
+    void FlushingLogT(std::ostream& out, Args... args)
+    {
+        char buff[9];
+        auto now = std::chrono::system_clock::now();
+        time_t now_c = std::chrono::system_clock::to_time_t(now);
+        tm now_tm;
+        localtime_s(&now_tm, &now_c);
+        strftime(buff, sizeof buff, "%H:%M:%S", &now_tm);
+        out << buff << "." << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000 << "  ";
+        FlushingLog(out, args...);
+    }
+
+    // What log_t does, against a logger of our own instead of the one on stdout.
+    template <typename... Args>
+    void AsyncLogT(AsyncLogger& logger, Args... args)
+    {
+        LogLine& line = AsyncLogger::ThreadLine();
+        line.Clear();
+        line.AppendTimestamp();
+        line.Append("  ");
+        int expand[] = { 0, (line.Append(args), 0)... };
+        (void)expand;
+        logger.Write(line.Data(), line.Size());
+    }
+
+    // The kind of argument a hot path log line used to pay for whether or not it was printed.
+    std::string CountedActivityText(const std::string& raw, int& evaluations)
+    {
+        evaluations++;
+        return Activity(raw).Text();
+    }
+}
+
+namespace cppSampleTests
+{
+    TEST_CLASS(cppSampleBenchmarks)
+    {
+    public:
+
+        TEST_METHOD(BenchmarkActivityFieldExtraction)
+        {
+            const size_t sizes[] = { 1024, 10 * 1024, 50 * 1024, 100 * 1024, 200 * 1024 };
+            char line[256];
+
+            Logger::WriteMessage("activity bytes, full parse us, field extraction us, speedup\n");
+            for (size_t size : sizes)
+            {
+                std::string raw = MakeActivity(size);
+                int iterations = (int)(20 * 1024 * 1024 / raw.size());
+
+                double fullParse = MeanMicroseconds(iterations, [&raw]()
+                    {
+                        auto activity = nlohmann::json::parse(raw);
+                        if (activity.value<std::string>("inputHint", "") != "expectingInput")
+                        {
+                            Assert::Fail(L"full parse lost the inputHint");
+                        }
+                    });
+
+                double extraction = MeanMicroseconds(iterations, [&raw]()
+                    {
+                        Activity activity(raw);
+                        if (activity.InputHint() != "expectingInput")
+                        {
+                            Assert::Fail(L"extraction lost the inputHint");
+                        }
+                    });
+
+                snprintf(line, sizeof(line), "%zu, %.1f, %.1f, %.1fx\n", raw.size(), fullParse, extraction, fullParse / extraction);
+                Logger::WriteMessage(line);
+            }
+        }
+
+        TEST_METHOD(BenchmarkActivityArenaParse)
+        {
+            const size_t sizes[] = { 1024, 10 * 1024, 50 * 1024, 100 * 1024, 200 * 1024 };
+            char line[256];
+
+            Logger::WriteMessage("activity bytes, heap parse us, heap allocations, arena parse us, heap allocations, arena allocations\n");
+            for (size_t size : sizes)
+            {
+                std::string raw = MakeActivity(size);
+                int iterations = (int)(20 * 1024 * 1024 / raw.size());
+
+                // parse and free the full DOM on the heap, as DialogManager used to
+                g_allocationCount = 0;
+                g_countAllocations = true;
+                double heapParse = MeanMicroseconds(iterations, [&raw]()
+                    {
+                        auto json = nlohmann::json::parse(raw);
+                    });
+                g_countAllocations = false;
+                uint64_t heapAllocations = g_allocationCount / iterations;
+
+                // the same through an arena that is reset after every activity
+                ActivityArena arena;
+                {
+                    Activity warmUp(raw, &arena);
+                    warmUp.Json();
+                }
+                arena.Reset();
+
+                uint64_t arenaAllocations = 0;
+                g_allocationCount = 0;
+                g_countAllocations = true;
+                double arenaParse = MeanMicroseconds(iterations, [&raw, &arena, &arenaAllocations]()
+                    {
+                        {
+                            Activity activity(raw, &arena);
+                            activity.Json();
+                        }
+                        arenaAllocations = arena.Allocations();
+                        arena.Reset();
+                    });
+                g_countAllocations = false;
+
+                // the raw string copy made for each Activity is the only remaining heap allocation
+                snprintf(line, sizeof(line), "%zu, %.1f, %llu, %.1f, %llu, %llu\n", raw.size(), heapParse, (unsigned long long)heapAllocations,
+                    arenaParse, (unsigned long long)(g_allocationCount / iterations), (unsigned long long)arenaAllocations);
+                Logger::WriteMessage(line);
+            }
+        }
+
+        TEST_METHOD(BenchmarkLogLine)
+        {
+            // a typical dispatch thread line, written to a file so the terminal's speed does not count
+            const int iterations = 256 * 400;
+            char path[L_tmpnam];
+            tmpnam_s(path, sizeof(path));
+
+            double flushing;
+            {
+                std::ofstream out(path, std::ios::out | std::ios::trunc);
+                flushing = MeanMicroseconds(iterations, [&out] { FlushingLogT(out, "Listening again ", 42, "ms after the activity (median ", 40, "ms)"); });
+            }
+
+            double async = 0;
+            uint64_t dropped;
+            {
+                FILE* file = nullptr;
+                fopen_s(&file, path, "w");
+                AsyncLogger logger(file);
+                // in bursts well inside the ring, as a turn logs, letting the writer catch up in between
+                const int burst = 256;
+                for (int i = 0; i < iterations; i += burst)
+                {
+                    async += MeanMicroseconds(burst, [&logger] { AsyncLogT(logger, "Listening again ", 42, "ms after the activity (median ", 40, "ms)"); });
+                    logger.Flush();
+                }
+                async /= iterations / burst;
+                dropped = logger.LinesDropped();
+                logger.Stop();
+                fclose(file);
+            }
+            remove(path);
+
+            char line[256];
+            snprintf(line, sizeof(line), "log_t ns per call: flushing cout style %.0f, async %.0f (%llu of %d lines dropped)\n",
+                flushing * 1000, async * 1000, (unsigned long long)dropped, iterations);
+            Logger::WriteMessage(line);
+        }
+
+        TEST_METHOD(BenchmarkDisabledLogLevels)
+        {
+            // trace is below the default build floor and compiled out, debug is compiled in but below the run time threshold
+            const int iterations = 1000000;
+            std::string raw = MakeActivity(10 * 1024);
+            int evaluations = 0;
+            int previousLevel = log_level_threshold().load();
+            log_set_level(LOG_LEVEL_INFO);
+
+            double empty = MeanMicroseconds(iterations, [] {});
+            double compiledOut = MeanMicroseconds(iterations, [&raw, &evaluations]
+                {
+                    LOG_TRACE("activity[\"text\"]: ", CountedActivityText(raw, evaluations));
+                });
+            double filtered = MeanMicroseconds(iterations, [&raw, &evaluations]
+                {
+                    LOG_DEBUG("activity[\"text\"]: ", CountedActivityText(raw, evaluations));
+                });
+            double evaluated = MeanMicroseconds(1000, [&raw, &evaluations] { CountedActivityText(raw, evaluations); });
+
+            log_set_level(previousLevel);
+            Assert::AreEqual(1000, evaluations);
+
+            char line[256];
+            snprintf(line, sizeof(line), "disabled log line ns per call: empty loop %.2f, compiled out %.2f, filtered at run time %.2f (evaluating its argument %.0f)\n",
+                empty * 1000, compiledOut * 1000, filtered * 1000, evaluated * 1000);
+            Logger::WriteMessage(line);
+        }
+    };
+}
@@ -4,11 +4,69 @@
 #include "CppUnitTest.h"
 #include "WindowsAudioPlayer.h"
 #include "AudioPlayerStreamImpl.h"
+#include "MappedAudioPlayerStream.h"
+#include "AudioConverter.h"
+#include "TtsRecorder.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iterator>
+#include <vector>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace std;
 
+namespace
+{
+    // Stands in for a pull stream whose network has stalled: the first reads return silence and every read after
+    // that blocks until the test releases it.
+    class StarvedSource
+    {
+    public:
+        explicit StarvedSource(uint32_t firstBytes) : m_firstBytes(firstBytes) {}
+
+        uint32_t Read(uint8_t* buffer, uint32_t size)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_firstBytes > 0)
+            {
+                uint32_t bytes = size < m_firstBytes ? size : m_firstBytes;
+                memset(buffer, 0, bytes);
+                m_firstBytes -= bytes;
+                return bytes;
+            }
+            m_starved = true;
+            m_changed.notify_all();
+            m_changed.wait(lock, [&] { return m_released; });
+            return 0;
+        }
+
+        // Waits until the prefetch thread has used up the first bytes and is blocked in Read.
+        bool WaitUntilStarved()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(5), [&] { return m_starved; });
+        }
+
+        void Release()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_released = true;
+            m_changed.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+        uint32_t m_firstBytes;
+        bool m_starved = false;
+        bool m_released = false;
+    };
+}
+
 namespace cppSampleTests
 {
     const string testWavFilePath = "..\\..\\cppSampleTests\\CognitiveServicesVoiceAssistantIntro.wav";
@@ -49,7 +107,8 @@ namespace cppSampleTests
                 Assert::Fail();
             }
 
-            fs->seekg(44);
+            WavFile::WavFileInfo info;
+            Assert::IsTrue(WavFile::ReadHeader(*fs, info) == WavFile::WavParseResult::Success);
 
             AudioPlayer::WindowsAudioPlayer player;
             player.Initialize();
@@ -60,6 +119,166 @@ namespace cppSampleTests
             Assert::AreEqual(rc, result);
         }
 
+        TEST_METHOD(TestMappedAudioPlayerStreamParsesWavHeader)
+        {
+            AudioPlayer::MappedAudioPlayerStream stream(testWavFilePath);
+
+            Assert::IsTrue(stream.IsValid());
+            Assert::AreEqual((uint16_t)1, stream.Format().channels);
+            Assert::AreEqual((uint32_t)16000, stream.Format().samplesPerSecond);
+            Assert::AreEqual((uint16_t)16, stream.Format().bitsPerSample);
+
+            // the fmt chunk of the test file is 18 bytes long, so the samples start at 46 rather than 44 and run to
+            // the end of the file
+            const size_t dataOffset = 46;
+            fstream fs(testWavFilePath, ios_base::binary | ios_base::in);
+            std::vector<unsigned char> file((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+            Assert::AreEqual(file.size() - dataOffset, stream.DataLength());
+
+            const unsigned char* slice;
+            size_t length = stream.DataLength();
+            Assert::AreEqual(length, (size_t)stream.ReadSlice(&slice, length));
+            Assert::IsTrue(memcmp(file.data() + dataOffset, slice, length) == 0);
+            Assert::IsTrue(stream.IsEndOfStream());
+        }
+
+        TEST_METHOD(TestWindowsAudioPlayerMappedFileStream)
+        {
+            int rc = 0;
+            std::shared_ptr<AudioPlayer::MappedAudioPlayerStream> stream = std::make_shared<AudioPlayer::MappedAudioPlayerStream>(testWavFilePath);
+            Assert::IsTrue(stream->IsValid());
+
+            AudioPlayer::WindowsAudioPlayer player;
+            player.Initialize();
+
+            int result = player.Play(stream);
+
+            Assert::AreEqual(rc, result);
+        }
+
+        TEST_METHOD(TestAudioConverterDownmixesAndResamples)
+        {
+            WavFile::WavFormat format;
+            format.formatTag = WavFile::FormatPcm;
+            format.channels = 2;
+            format.samplesPerSecond = 48000;
+            format.bitsPerSample = 16;
+            format.blockAlign = 4;
+            format.averageBytesPerSecond = 48000 * 4;
+            Assert::IsTrue(AudioConverter::IsSupported(format));
+            Assert::IsTrue(AudioConverter::NeedsConversion(format));
+
+            // one second of stereo audio, pushed in odd sized blocks so frames are split across calls
+            std::vector<int16_t> input(48000 * 2, 1000);
+            const unsigned char* bytes = (const unsigned char*)input.data();
+            size_t total = input.size() * sizeof(int16_t);
+
+            AudioConverter converter(format);
+            std::vector<int16_t> output;
+            for (size_t offset = 0; offset < total; offset += 999)
+            {
+                converter.Convert(bytes + offset, min((size_t)999, total - offset), output);
+            }
+
+            Assert::IsTrue(output.size() >= 15990 && output.size() <= 16000);
+            Assert::AreEqual(1.0, converter.InputSeconds());
+            Assert::AreEqual((int16_t)1000, output[output.size() / 2]);
+        }
+
+        TEST_METHOD(TestTtsRecorderWritesTurnAndCountsDrops)
+        {
+            std::vector<unsigned char> chunk(16000, 0x55);
+            // larger than a turn ring, so it is dropped however quickly the writer drains
+            std::vector<unsigned char> oversized(AudioPlayer::AudioBufferPool::ChunkBlockSize + 1, 0x66);
+            std::string path;
+            uint64_t dropped;
+            {
+                AudioPlayer::TtsRecorder recorder("ttsRecordings", AudioPlayer::TtsRecorder::DefaultFormat());
+                auto turn = recorder.StartTurn("session-1", "activity/1");
+                path = turn->Path();
+
+                // the ring starts empty, so the first chunk always fits
+                turn->Write(chunk.data(), chunk.size());
+                turn->Write(oversized.data(), oversized.size());
+                dropped = turn->DroppedBytes();
+                turn->Finish();
+            }
+
+            Assert::AreEqual(std::string("ttsRecordings/session-1_activity_1.wav"), path);
+            Assert::AreEqual((uint64_t)oversized.size(), dropped);
+
+            fstream fs(path, ios_base::binary | ios_base::in);
+            WavFile::WavFileInfo info;
+            Assert::IsTrue(WavFile::ReadHeader(fs, info) == WavFile::WavParseResult::Success);
+            Assert::AreEqual(chunk.size(), info.dataLength);
+        }
+
+        TEST_METHOD(TestWindowsAudioPlayerPlaybackEndingCanceledByStop)
+        {
+            std::shared_ptr<AudioPlayer::MappedAudioPlayerStream> stream = std::make_shared<AudioPlayer::MappedAudioPlayerStream>(testWavFilePath);
+            AudioPlayer::WindowsAudioPlayer player;
+            player.Initialize();
+
+            int calls = 0;
+            bool wasCanceled = false;
+            player.Play(stream, std::chrono::milliseconds(1000), [&](bool canceled)
+                {
+                    calls++;
+                    wasCanceled = canceled;
+                });
+
+            // the test file is far longer than the lead time, so stopping right away must cancel
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            player.Stop();
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            Assert::AreEqual(1, calls);
+            Assert::IsTrue(wasCanceled);
+        }
+
+        TEST_METHOD(TestWindowsAudioPlayerBargeInWhileTheStreamIsStarved)
+        {
+            // declared ahead of the player, which may still call back while it is being destroyed
+            std::mutex mutex;
+            std::condition_variable changed;
+            bool silent = false;
+            int endings = 0;
+            bool wasCanceled = false;
+
+            // a tenth of a second of audio, then nothing until the test lets the source go
+            auto source = std::make_shared<StarvedSource>(3200);
+            std::shared_ptr<IAudioPlayerStream> stream = std::make_shared<AudioPlayer::AudioPlayerStreamImpl>(
+                [source](uint8_t* buffer, uint32_t size) { return source->Read(buffer, size); });
+            AudioPlayer::WindowsAudioPlayer player;
+            player.Initialize();
+
+            player.Play(stream, std::chrono::milliseconds(0), [&](bool canceled)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    endings++;
+                    wasCanceled = canceled;
+                });
+            Assert::IsTrue(source->WaitUntilStarved());
+            // long enough for the player to write what arrived and start waiting for more
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            player.BargeIn([&](std::chrono::steady_clock::time_point, bool)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    silent = true;
+                    changed.notify_all();
+                });
+            {
+                // the source is still stalled, so the barge in only completes if the player is not waiting on it
+                std::unique_lock<std::mutex> lock(mutex);
+                Assert::IsTrue(changed.wait_for(lock, std::chrono::milliseconds(500), [&] { return silent; }),
+                    L"Barge in waited on the stalled source");
+                Assert::AreEqual(1, endings);
+                Assert::IsTrue(wasCanceled);
+            }
+            source->Release();
+        }
+
         TEST_METHOD(TestWindowsAudioPlayerStop) 
         {
             int rc = 0;
@@ -90,7 +309,8 @@ namespace cppSampleTests
                 Assert::Fail();
             }
 
-            fs.seekg(44);
+            WavFile::WavFileInfo info;
+            Assert::IsTrue(WavFile::ReadHeader(fs, info) == WavFile::WavParseResult::Success);
 
             std::array<uint8_t, 1000> buffer;
 